@@ -1,8 +1,50 @@
+#include <algorithm>
+#include <cstddef>
 #include "ppm_ac.h"
 #include "ppm_see.cpp"
 
 //ppmdf version of PPMD
 
+static constexpr u32 PPM_SNAPSHOT_MAGIC = 0x4d505050; // "PPPM"
+static constexpr u8 PPM_IMAGE_EMPTY_CONTEXT = 0x80; // mark of snapshot check, context orders + 1 are in low bits
+
+struct ppm_snapshot_header
+{
+	u32 Magic;
+	u32 OrderCount;
+	u32 InitEsc;
+	u32 LastMaskedCount;
+
+	// offsets in arena image (SUB_ALLOC_IMAGE_BASE based, 0 - null)
+	u64 Exclusion;
+	u64 MaxContext;
+	u64 MinContext;
+	u64 ContextStack;
+	u64 LastEncSym;
+	u64 Root;
+
+	u32 SEEPrevSuccess;
+	u32 SEELastUsed;
+	see_context SEEContext[44][8];
+	see_bin_context SEEBinContext[128][16];
+};
+
+// In place model checkpoint, restore brings model back to trained state with one copy of used arena
+struct ppm_checkpoint
+{
+	sub_alloc_checkpoint Arena;
+	SEEState SEE;
+
+	context_data_excl* Exclusion;
+	context* MaxContext;
+	context* MinContext;
+	context_data** ContextStack;
+	context_data* LastEncSym;
+
+	u8 InitEsc;
+	u16 LastMaskedCount;
+};
+
 class PPMByte
 {
 	SEEState* SEE;
@@ -16,6 +58,7 @@ class PPMByte
 	u8 InitEsc;
 	u16 OrderCount;
 	u16 LastMaskedCount;
+	b32 OwnsSEE;
 
 public:
 	StaticSubAlloc<32> SubAlloc;
@@ -28,19 +71,31 @@ public:
 
 	PPMByte() = delete;
 	PPMByte(u32 MaxOrderContext, u32 MemLimit) :
-		SubAlloc(MemLimit), SEE(nullptr), OrderCount(MaxOrderContext)
+		SEE(nullptr), OrderCount(MaxOrderContext), OwnsSEE(true), SubAlloc(MemLimit)
 	{
-		initModel();
-		SEE = new SEEState;
-		SEE->init();
+		init();
+	}
 
-#ifdef _DEBUG
-		SymEnc = 0.0;
-		EscEnc = 0.0;
-#endif
+	// Arena on page backend, see PageAlloc. Worth it for large MemLimit where context walk misses dTLB.
+	PPMByte(u32 MaxOrderContext, u32 MemLimit, const page_alloc_params& Pages) :
+		SEE(nullptr), OrderCount(MaxOrderContext), OwnsSEE(true), SubAlloc(MemLimit, Pages)
+	{
+		init();
 	}
 
-	~PPMByte() { delete SEE; }
+	// NOTE: no allocation, model lives in caller's workspace (Memory and ExternalSEE must outlive model).
+	// Each thread must own its own workspace, model state is never shared.
+	PPMByte(u32 MaxOrderContext, u8* Memory, u64 MemSize, SEEState* ExternalSEE) :
+		SEE(ExternalSEE), OrderCount(MaxOrderContext), OwnsSEE(false), SubAlloc(Memory, MemSize)
+	{
+		Assert(ExternalSEE);
+		init();
+	}
+
+	~PPMByte()
+	{
+		if (OwnsSEE) delete SEE;
+	}
 
 	void encode(ArithEncoder& Encoder, u32 Symbol)
 	{
@@ -153,7 +208,408 @@ public:
 		SEE->init();
 	}
 
+	// NOTE: runs Data through model as if it was coded, output goes to Scratch and is thrown away.
+	// Encoder and decoder side must prime with same bytes.
+	void prime(const u8* Data, u64 Size, ByteVec& Scratch)
+	{
+		Scratch.clear();
+		ArithEncoder Encoder(Scratch);
+
+		for (u64 i = 0; i < Size; ++i)
+		{
+			encode(Encoder, Data[i]);
+		}
+	}
+
+	void checkpoint(ppm_checkpoint& Out) const
+	{
+		SubAlloc.checkpoint(Out.Arena);
+		Out.SEE = *SEE;
+
+		Out.Exclusion = Exclusion;
+		Out.MaxContext = MaxContext;
+		Out.MinContext = MinContext;
+		Out.ContextStack = ContextStack;
+		Out.LastEncSym = LastEncSym;
+		Out.InitEsc = InitEsc;
+		Out.LastMaskedCount = LastMaskedCount;
+	}
+
+	// Checkpoint must be taken from this model, pointers are kept as is
+	void restore(const ppm_checkpoint& In)
+	{
+		SubAlloc.restore(In.Arena);
+		*SEE = In.SEE;
+
+		Exclusion = In.Exclusion;
+		MaxContext = In.MaxContext;
+		MinContext = In.MinContext;
+		ContextStack = In.ContextStack;
+		LastEncSym = In.LastEncSym;
+		InitEsc = In.InitEsc;
+		LastMaskedCount = In.LastMaskedCount;
+	}
+
+	// NOTE: both models must have same order and memory size, Src is only read
+	void cloneFrom(const PPMByte& Src)
+	{
+		Assert(OrderCount == Src.OrderCount);
+
+		SubAlloc.copyFrom(Src.SubAlloc);
+
+		size_t From = reinterpret_cast<size_t>(Src.SubAlloc.getMemory());
+		size_t To = reinterpret_cast<size_t>(SubAlloc.getMemory());
+
+		rebaseContext(SubAlloc.getMemory(), From, To, Src.rootContext(), OrderCount);
+		copyModelState(Src, From, To);
+	}
+
+	// Arena offsets of all context pointer fields, sorted. Lets clones of one base rebase in a linear pass
+	// instead of walking context tree every time.
+	void collectRelocs(std::vector<u64>& Relocs) const
+	{
+		Relocs.clear();
+
+		u8* Memory = SubAlloc.getMemory();
+		auto Collect = [Memory, &Relocs](u8* Field) { Relocs.push_back(Field - Memory); };
+		visitContextPtrs(Memory, reinterpret_cast<size_t>(Memory), rootContext(), 0, OrderCount, Collect);
+
+		std::sort(Relocs.begin(), Relocs.end());
+	}
+
+	// Relocs must be collected from Src after its last update
+	void cloneFrom(const PPMByte& Src, const std::vector<u64>& Relocs)
+	{
+		Assert(OrderCount == Src.OrderCount);
+
+		SubAlloc.copyFrom(Src.SubAlloc);
+
+		u8* Memory = SubAlloc.getMemory();
+		size_t From = reinterpret_cast<size_t>(Src.SubAlloc.getMemory());
+		size_t To = reinterpret_cast<size_t>(Memory);
+
+		for (u64 Offset : Relocs)
+		{
+			rebaseField(Memory + Offset, From, To);
+		}
+
+		copyModelState(Src, From, To);
+	}
+
+	u64 snapshotSize() const
+	{
+		u64 Result = sizeof(ppm_snapshot_header) + SubAlloc.imageSize();
+		return Result;
+	}
+
+	// Model as position independent image: header, then arena with pointers stored as offsets
+	void saveSnapshot(u8* Out) const
+	{
+		size_t From = reinterpret_cast<size_t>(SubAlloc.getMemory());
+		size_t To = SUB_ALLOC_IMAGE_BASE;
+
+		ppm_snapshot_header Header = {};
+		Header.Magic = PPM_SNAPSHOT_MAGIC;
+		Header.OrderCount = OrderCount;
+		Header.InitEsc = InitEsc;
+		Header.LastMaskedCount = LastMaskedCount;
+		Header.Exclusion = reinterpret_cast<size_t>(RebasePtr(Exclusion, From, To));
+		Header.MaxContext = reinterpret_cast<size_t>(RebasePtr(MaxContext, From, To));
+		Header.MinContext = reinterpret_cast<size_t>(RebasePtr(MinContext, From, To));
+		Header.ContextStack = reinterpret_cast<size_t>(RebasePtr(ContextStack, From, To));
+		Header.LastEncSym = reinterpret_cast<size_t>(RebasePtr(LastEncSym, From, To));
+		Header.Root = reinterpret_cast<size_t>(RebasePtr(rootContext(), From, To));
+
+		Header.SEEPrevSuccess = SEE->PrevSuccess;
+		Header.SEELastUsed = static_cast<u32>(SEE->LastUsed - SEE->Context[0]);
+		memcpy(Header.SEEContext, SEE->Context, sizeof(SEE->Context));
+		memcpy(Header.SEEBinContext, SEE->BinContext, sizeof(SEE->BinContext));
+
+		memcpy(Out, &Header, sizeof(Header));
+		Out += sizeof(Header);
+
+		SubAlloc.saveImage(Out);
+		u8* Image = Out + sizeof(sub_alloc_image_header);
+		rebaseContext(Image, From, To, rootContext(), OrderCount);
+	}
+
+	// model must be created with same order, owned arena takes snapshot's memory size.
+	// Snapshot is untrusted, on false model is reset.
+	b32 loadSnapshot(const u8* In, u64 InSize)
+	{
+		ppm_snapshot_header Header;
+		if (InSize < sizeof(Header)) return false;
+
+		memcpy(&Header, In, sizeof(Header));
+		if ((Header.Magic != PPM_SNAPSHOT_MAGIC) || (Header.OrderCount != OrderCount)) return false;
+		if (Header.SEELastUsed >= (sizeof(SEE->Context) / sizeof(see_context))) return false;
+
+		if (!SubAlloc.loadImage(In + sizeof(Header), InSize - sizeof(Header)))
+		{
+			reset();
+			return false;
+		}
+
+		if (!validImage(Header))
+		{
+			reset();
+			return false;
+		}
+
+		size_t From = SUB_ALLOC_IMAGE_BASE;
+		size_t To = reinterpret_cast<size_t>(SubAlloc.getMemory());
+
+		rebaseContext(SubAlloc.getMemory(), From, To, reinterpret_cast<context*>(Header.Root), OrderCount);
+
+		InitEsc = Header.InitEsc;
+		LastMaskedCount = Header.LastMaskedCount;
+		Exclusion = RebasePtr(reinterpret_cast<context_data_excl*>(Header.Exclusion), From, To);
+		MaxContext = RebasePtr(reinterpret_cast<context*>(Header.MaxContext), From, To);
+		MinContext = RebasePtr(reinterpret_cast<context*>(Header.MinContext), From, To);
+		ContextStack = RebasePtr(reinterpret_cast<context_data**>(Header.ContextStack), From, To);
+		LastEncSym = RebasePtr(reinterpret_cast<context_data*>(Header.LastEncSym), From, To);
+
+		SEE->init();
+		SEE->PrevSuccess = Header.SEEPrevSuccess;
+		SEE->LastUsed = SEE->Context[0] + Header.SEELastUsed;
+		memcpy(SEE->Context, Header.SEEContext, sizeof(SEE->Context));
+		memcpy(SEE->BinContext, Header.SEEBinContext, sizeof(SEE->BinContext));
+
+		return true;
+	}
+
 private:
+	context* rootContext() const
+	{
+		context* Result = MaxContext;
+		while (Result->Prev)
+		{
+			Result = Result->Prev;
+		}
+
+		return Result;
+	}
+
+	// Calls Visit(FieldAddress) for every pointer field of Ctx subtree; Dest holds arena in From base, Ctx is in From base.
+	// Field is visited after its old value was read, so Visit may rewrite it.
+	// NOTE: Next of max order context symbols points to other max order context (suffix shift),
+	// so only lower orders form a tree and are descended.
+	template<typename F>
+	static void visitContextPtrs(u8* Dest, size_t From, context* Ctx, u32 Order, u32 MaxOrder, F& Visit)
+	{
+		context* At = reinterpret_cast<context*>(Dest + (reinterpret_cast<size_t>(Ctx) - From));
+		context_data* Data = At->Data;
+
+		Visit(reinterpret_cast<u8*>(&At->Data));
+		Visit(reinterpret_cast<u8*>(&At->Prev));
+
+		if (!Data) return;
+
+		context_data* DataAt = reinterpret_cast<context_data*>(Dest + (reinterpret_cast<size_t>(Data) - From));
+		for (u32 i = 0; i < At->SymbolCount; ++i)
+		{
+			context* Next = DataAt[i].Next;
+			if (Next)
+			{
+				Visit(reinterpret_cast<u8*>(DataAt + i) + offsetof(context_data, Next));
+				if (Order < MaxOrder) visitContextPtrs(Dest, From, Next, Order + 1, MaxOrder, Visit);
+			}
+		}
+	}
+
+	// Loaded arena is still in image form. Pointers of header and of context tree must point inside loaded prefix
+	// and be aligned, every context of tree must be reached once (rebase would apply twice otherwise). Contexts must
+	// keep invariants coder divides and indexes tables by: symbol frequencies sum below total, unique symbols,
+	// suffix one order lower with at least as many symbols, successor contexts with symbols. SEE state and
+	// header values are checked against ranges of tables they index.
+	b32 validImage(const ppm_snapshot_header& Header) const
+	{
+		u64 ImageSize = SubAlloc.highWater();
+		const u8* Image = SubAlloc.getMemory();
+
+		b32 Result = (OrderCount < PPM_IMAGE_EMPTY_CONTEXT) && ValidImagePtr(Header.Exclusion, sizeof(context_data_excl), ImageSize, alignof(context_data_excl)) &&
+			ValidImagePtr(Header.ContextStack, OrderCount * sizeof(context_data*), ImageSize, alignof(context_data*)) &&
+			ValidImagePtr(Header.MaxContext, sizeof(context), ImageSize, alignof(context)) &&
+			(!Header.MinContext || ValidImagePtr(Header.MinContext, sizeof(context), ImageSize, alignof(context))) &&
+			(!Header.LastEncSym || ValidImagePtr(Header.LastEncSym, sizeof(context_data), ImageSize, alignof(context_data))) &&
+			(Header.InitEsc <= ExpEscape[0]) && (Header.LastMaskedCount <= (context::MaxSymbol + 1)) && validSEE(Header);
+
+		if (Result)
+		{
+			// NOTE: Visited holds order + 1 of every tree context, links between contexts are checked once whole tree is known
+			std::vector<u8> Visited(ImageSize / alignof(context) + 1);
+			Result = validImageContext(Image, ImageSize, Header.Root, 0, OrderCount, Visited);
+
+			// contexts without symbols are only allocated ones on suffix chain of max context, filled by next update
+			u64 Ctx = Header.MaxContext;
+			for (u32 i = 0; Result && Ctx && (i <= OrderCount); i++)
+			{
+				u64 Offset = Ctx - SUB_ALLOC_IMAGE_BASE;
+				const context* At = reinterpret_cast<const context*>(Image + Offset);
+				Result = Visited[Offset / alignof(context)];
+				if (At->SymbolCount) break;
+
+				Visited[Offset / alignof(context)] |= PPM_IMAGE_EMPTY_CONTEXT;
+				Ctx = reinterpret_cast<size_t>(At->Prev);
+			}
+
+			Result = Result && validImageLinks(Image, Header.Root, 0, OrderCount, Visited);
+			if (Result && Header.MinContext)
+			{
+				u64 Offset = Header.MinContext - SUB_ALLOC_IMAGE_BASE;
+				Result = Visited[Offset / alignof(context)] && reinterpret_cast<const context*>(Image + Offset)->SymbolCount;
+			}
+		}
+
+		return Result;
+	}
+
+	static b32 validSEE(const ppm_snapshot_header& Header)
+	{
+		if (Header.SEEPrevSuccess > 1) return false;
+
+		for (const auto& Row : Header.SEEContext)
+		{
+			for (const see_context& Context : Row)
+			{
+				if (Context.Shift > CTX_MAX_BITS) return false;
+			}
+		}
+
+		for (const auto& Row : Header.SEEBinContext)
+		{
+			for (const see_bin_context& Context : Row)
+			{
+				if (Context.Scale >= FREQ_MAX_VALUE) return false;
+			}
+		}
+
+		return true;
+	}
+
+	static b32 validImageContext(const u8* Image, u64 ImageSize, u64 Ctx, u32 Order, u32 MaxOrder, std::vector<u8>& Visited)
+	{
+		if (!ValidImagePtr(Ctx, sizeof(context), ImageSize, alignof(context))) return false;
+
+		u64 Offset = Ctx - SUB_ALLOC_IMAGE_BASE;
+		if (Visited[Offset / alignof(context)]) return false;
+		Visited[Offset / alignof(context)] = static_cast<u8>(Order + 1);
+
+		const context* At = reinterpret_cast<const context*>(Image + Offset);
+		u64 Data = reinterpret_cast<size_t>(At->Data);
+		u64 Prev = reinterpret_cast<size_t>(At->Prev);
+
+		if (Prev && !ValidImagePtr(Prev, sizeof(context), ImageSize, alignof(context))) return false;
+		if (!Data) return !At->SymbolCount;
+
+		if (At->SymbolCount > (context::MaxSymbol + 1)) return false;
+		if (!ValidImagePtr(Data, At->SymbolCount * sizeof(context_data), ImageSize, alignof(context))) return false;
+
+		// NOTE: binary context frequency indexes SEE table, otherwise escape frequency (total minus sum) must be positive
+		const context_data* DataAt = reinterpret_cast<const context_data*>(Image + (Data - SUB_ALLOC_IMAGE_BASE));
+		if (At->SymbolCount == 1)
+		{
+			if (!DataAt[0].Freq || (DataAt[0].Freq > 128)) return false;
+		}
+		else if (At->SymbolCount > 1)
+		{
+			u32 FreqSum = 0;
+			u32 Seen[256 / 32] = {};
+			for (u32 i = 0; i < At->SymbolCount; ++i)
+			{
+				u32 Symbol = DataAt[i].Symbol;
+				if (!DataAt[i].Freq || (Seen[Symbol >> 5] & (1u << (Symbol & 31)))) return false;
+
+				Seen[Symbol >> 5] |= 1u << (Symbol & 31);
+				FreqSum += DataAt[i].Freq;
+			}
+
+			if (FreqSum >= At->TotalFreq) return false;
+		}
+
+		for (u32 i = 0; i < At->SymbolCount; ++i)
+		{
+			u64 Next = reinterpret_cast<size_t>(DataAt[i].Next);
+			if (!Next) continue;
+
+			b32 Valid = (Order < MaxOrder) ? validImageContext(Image, ImageSize, Next, Order + 1, MaxOrder, Visited) :
+				ValidImagePtr(Next, sizeof(context), ImageSize, alignof(context));
+			if (!Valid) return false;
+		}
+
+		return true;
+	}
+
+	// second pass over tree checked by validImageContext, every context pointer it holds is in range
+	static b32 validImageLinks(const u8* Image, u64 Ctx, u32 Order, u32 MaxOrder, const std::vector<u8>& Visited)
+	{
+		const context* At = reinterpret_cast<const context*>(Image + (Ctx - SUB_ALLOC_IMAGE_BASE));
+		u64 Prev = reinterpret_cast<size_t>(At->Prev);
+
+		if (!Order != !Prev) return false;
+		if (Prev)
+		{
+			u64 PrevOffset = Prev - SUB_ALLOC_IMAGE_BASE;
+			const context* PrevAt = reinterpret_cast<const context*>(Image + PrevOffset);
+			if ((Visited[PrevOffset / alignof(context)] & ~PPM_IMAGE_EMPTY_CONTEXT) != Order) return false;
+			if (PrevAt->SymbolCount < At->SymbolCount) return false;
+		}
+
+		if (!At->Data) return true;
+
+		const context_data* DataAt = reinterpret_cast<const context_data*>(Image + (reinterpret_cast<size_t>(At->Data) - SUB_ALLOC_IMAGE_BASE));
+		for (u32 i = 0; i < At->SymbolCount; ++i)
+		{
+			u64 Next = reinterpret_cast<size_t>(DataAt[i].Next);
+			if (!Next) continue;
+
+			u64 NextOffset = Next - SUB_ALLOC_IMAGE_BASE;
+			u8 NextVisited = Visited[NextOffset / alignof(context)];
+			if (!NextVisited) return false;
+			if (!reinterpret_cast<const context*>(Image + NextOffset)->SymbolCount && !(NextVisited & PPM_IMAGE_EMPTY_CONTEXT)) return false;
+
+			if ((Order < MaxOrder) && !validImageLinks(Image, Next, Order + 1, MaxOrder, Visited)) return false;
+		}
+
+		return true;
+	}
+
+	static void rebaseContext(u8* Dest, size_t From, size_t To, context* Root, u32 MaxOrder)
+	{
+		auto Rebase = [From, To](u8* Field) { rebaseField(Field, From, To); };
+		visitContextPtrs(Dest, From, Root, 0, MaxOrder, Rebase);
+	}
+
+	static void rebaseField(u8* Field, size_t From, size_t To)
+	{
+		size_t Val;
+		memcpy(&Val, Field, sizeof(Val));
+
+		if (Val)
+		{
+			Val = Val - From + To;
+			memcpy(Field, &Val, sizeof(Val));
+		}
+	}
+
+	void copyModelState(const PPMByte& Src, size_t From, size_t To)
+	{
+		InitEsc = Src.InitEsc;
+		LastMaskedCount = Src.LastMaskedCount;
+		Exclusion = RebasePtr(Src.Exclusion, From, To);
+		MaxContext = RebasePtr(Src.MaxContext, From, To);
+		MinContext = RebasePtr(Src.MinContext, From, To);
+		ContextStack = RebasePtr(Src.ContextStack, From, To);
+		LastEncSym = RebasePtr(Src.LastEncSym, From, To);
+
+		*SEE = *Src.SEE;
+		SEE->LastUsed = SEE->Context[0] + (Src.SEE->LastUsed - Src.SEE->Context[0]);
+
+#ifdef _DEBUG
+		SymEnc = Src.SymEnc;
+		EscEnc = Src.EscEnc;
+#endif
+	}
 
 	void calcEncBits(prob Prob, b32 Success)
 	{
@@ -775,6 +1231,18 @@ private:
 		MemSet<u8>(reinterpret_cast<u8*>(Exclusion), sizeof(context_data_excl) / sizeof(Exclusion->Data[0]), context_data_excl::Mask);
 	}
 
+	// shared by constructors, arena is set up, SEE is allocated only if model owns it
+	void init()
+	{
+		initModel();
+		initSEE();
+
+#ifdef _DEBUG
+		SymEnc = 0.0;
+		EscEnc = 0.0;
+#endif
+	}
+
 	void initSEE()
 	{
 		if (SEE == nullptr)
@@ -787,6 +1255,11 @@ private:
 
 	void initModel()
 	{
+		// NOTE: set by first coded symbol before use, fixed here so snapshots of fresh model pass load checks
+		InitEsc = 0;
+		LastMaskedCount = 0;
+		LastEncSym = nullptr;
+
 		Exclusion = SubAlloc.alloc<context_data_excl>(1);
 		clearExclusion();
 
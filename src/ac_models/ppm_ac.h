@@ -11,7 +11,9 @@ struct context_data_excl
 
 struct context;
 
-// TODO: fix for gcc and clang
+// NOTE: packed, pragma pack is supported by MSVC, GCC and Clang with same layout.
+// Allocation sizes (and so model output once memory limit is hit) depend on sizeof, so it must not vary.
+// Next is unaligned, never take its address, access goes through context_data.
 #pragma pack(push, 1)
 struct context_data
 {
@@ -21,6 +23,8 @@ struct context_data
 };
 #pragma pack(pop)
 
+static_assert(sizeof(context_data) == sizeof(context*) + 2, "context_data must be packed");
+
 struct context
 {
 	context_data* Data;
@@ -31,6 +35,8 @@ struct context
 	static constexpr u32 MaxSymbol = 255;
 };
 
+static_assert(sizeof(context) == AlignSizeForward(2 * sizeof(void*) + 2 * sizeof(u16)), "context layout must match on all compilers");
+
 struct decode_symbol_result
 {
 	prob Prob;
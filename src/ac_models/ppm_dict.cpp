@@ -0,0 +1,80 @@
+// Priming dictionary for small messages: model trained on sample data, stored as position independent snapshot.
+// Load it once into base model, then clone base per message (clone copies only used part of arena).
+// Encoder and decoder must both start from same snapshot.
+void
+PPMTrainDictionary(ByteVec& OutSnapshot, const u8* Samples, u64 SamplesSize, u32 Order, u32 MemLimit)
+{
+	PPMByte Model(Order, MemLimit);
+
+	ByteVec Scratch;
+	Model.prime(Samples, SamplesSize, Scratch);
+
+	OutSnapshot.resize(Model.snapshotSize());
+	Model.saveSnapshot(OutSnapshot.data());
+}
+
+b32
+PPMSaveModelFile(const PPMByte& Model, const std::string& PathName)
+{
+	ByteVec Snapshot(Model.snapshotSize());
+	Model.saveSnapshot(Snapshot.data());
+
+	b32 Result = WriteEntireFile(PathName, Snapshot.data(), Snapshot.size());
+	return Result;
+}
+
+// model must be created with same order as saved one. File content is untrusted, loadSnapshot checks it
+// straight on mapped pages; on false model is reset.
+b32
+PPMLoadModelFile(PPMByte& Model, const std::string& PathName)
+{
+	mapped_file File;
+	if (!MapFile(File, PathName)) return false;
+
+	b32 Result = Model.loadSnapshot(File.Data, File.Size);
+	UnmapFile(File);
+
+	return Result;
+}
+
+// Loaded dictionary, read only after load so one instance serves all threads
+class PPMDictionary
+{
+	PPMByte Base;
+	std::vector<u64> Relocs;
+	u32 Order;
+	u32 MemLimit;
+
+public:
+	PPMDictionary(u32 Order, u32 MemLimit) : Base(Order, MemLimit), Order(Order), MemLimit(MemLimit) {}
+
+	u32 order() const { return Order; }
+	u32 memLimit() const { return MemLimit; }
+
+	b32 load(const u8* Snapshot, u64 Size)
+	{
+		// NOTE: rejected snapshot leaves base reset, relocs are collected for it too
+		b32 Result = Base.loadSnapshot(Snapshot, Size);
+		Base.collectRelocs(Relocs);
+
+		return Result;
+	}
+
+	// Snapshot is read straight from mapped pages, no intermediate file buffer
+	b32 loadFile(const std::string& PathName)
+	{
+		mapped_file File;
+		if (!MapFile(File, PathName)) return false;
+
+		b32 Result = load(File.Data, File.Size);
+		UnmapFile(File);
+
+		return Result;
+	}
+
+	// Model must have same order and memory size as dictionary
+	void instantiate(PPMByte& Model) const
+	{
+		Model.cloneFrom(Base, Relocs);
+	}
+};
@@ -0,0 +1,238 @@
+#include <atomic>
+#include <thread>
+
+// Parallel PPM: input is cut in independent blocks, every block is coded by own PPMByte + range coder.
+// Container layout (little endian):
+//   u32 BlockCount, u32 BlockSize, u64 TotalSize, u32 Order, u32 MemLimit, u32 CompressedSize[BlockCount], block streams
+// Blocks don't share model state, so they can be decoded in any order on any thread.
+// Optional trained dictionary model (PPMDictionary) is cloned into every block's model before coding, so
+// blocks start from trained statistics without coding dictionary bytes again. It's read only and shared by workers.
+static constexpr u32 PPM_PARALLEL_BLOCK_SIZE = 1 << 22;
+static constexpr u32 PPM_PARALLEL_HEADER_SIZE = 4 * sizeof(u32) + sizeof(u64);
+
+// Model params limits, decoder takes params from stream and rejects anything outside
+static constexpr u32 PPM_PARALLEL_MIN_ORDER = 1;
+static constexpr u32 PPM_PARALLEL_MAX_ORDER = 64;
+static constexpr u32 PPM_PARALLEL_MIN_MEM_LIMIT = 1 << 16;
+static constexpr u32 PPM_PARALLEL_MAX_MEM_LIMIT = 1 << 30;
+
+struct ppm_parallel_params
+{
+	u32 Order;
+	u32 MemLimit;
+	u32 BlockSize;
+	u32 ThreadCount; // 0 - all hardware threads
+
+	const PPMDictionary* Dict; // same order and mem limit as params, nullptr - every block starts from empty model
+};
+
+inline ppm_parallel_params
+PPMParallelDefaultParams()
+{
+	ppm_parallel_params Result = {};
+	Result.Order = 4;
+	Result.MemLimit = 20 << 20;
+	Result.BlockSize = PPM_PARALLEL_BLOCK_SIZE;
+	return Result;
+}
+
+inline b32
+PPMParallelValidModelParams(u32 Order, u32 MemLimit)
+{
+	b32 Result = (Order >= PPM_PARALLEL_MIN_ORDER) && (Order <= PPM_PARALLEL_MAX_ORDER) &&
+		(MemLimit >= PPM_PARALLEL_MIN_MEM_LIMIT) && (MemLimit <= PPM_PARALLEL_MAX_MEM_LIMIT);
+	return Result;
+}
+
+inline u32
+PPMParallelThreadCount(u32 ThreadCount, u32 BlockCount)
+{
+	if (ThreadCount == 0)
+	{
+		ThreadCount = std::thread::hardware_concurrency();
+		ThreadCount = ThreadCount ? ThreadCount : 1;
+	}
+
+	u32 Result = ThreadCount < BlockCount ? ThreadCount : BlockCount;
+	return Result;
+}
+
+// Workers take next block index from shared counter; calling thread is worker 0
+template<typename F> void
+PPMParallelRun(u32 ThreadCount, F&& BlockWorker)
+{
+	if (!ThreadCount) return;
+
+	std::atomic<u32> NextBlock(0);
+
+	auto WorkerLoop = [&]()
+	{
+		BlockWorker(NextBlock);
+	};
+
+	std::vector<std::thread> Workers;
+	Workers.reserve(ThreadCount - 1);
+
+	for (u32 i = 1; i < ThreadCount; i++)
+	{
+		Workers.emplace_back(WorkerLoop);
+	}
+
+	WorkerLoop();
+
+	for (auto& Worker : Workers)
+	{
+		Worker.join();
+	}
+}
+
+void
+PPMParallelCompress(const u8* Data, u64 Size, ByteVec& OutBuffer, const ppm_parallel_params& Params)
+{
+	Assert(Params.BlockSize);
+	Assert(PPMParallelValidModelParams(Params.Order, Params.MemLimit));
+	Assert(!Params.Dict || ((Params.Dict->order() == Params.Order) && (Params.Dict->memLimit() == Params.MemLimit)));
+
+	u64 BlockCount64 = (Size + Params.BlockSize - 1) / Params.BlockSize;
+	Assert(BlockCount64 <= MaxUInt32);
+	u32 BlockCount = static_cast<u32>(BlockCount64);
+
+	std::vector<ByteVec> BlockOut(BlockCount);
+	u32 ThreadCount = PPMParallelThreadCount(Params.ThreadCount, BlockCount);
+
+	PPMParallelRun(ThreadCount, [&](std::atomic<u32>& NextBlock)
+	{
+		PPMByte Model(Params.Order, Params.MemLimit);
+
+		for (u32 BlockIndex = NextBlock++; BlockIndex < BlockCount; BlockIndex = NextBlock++)
+		{
+			u64 Start = static_cast<u64>(BlockIndex) * Params.BlockSize;
+			u64 End = (Start + Params.BlockSize) < Size ? (Start + Params.BlockSize) : Size;
+
+			if (Params.Dict) Params.Dict->instantiate(Model);
+			else Model.reset();
+
+			ByteVec& Out = BlockOut[BlockIndex];
+			ArithEncoder Encoder(Out);
+
+			for (u64 i = Start; i < End; ++i)
+			{
+				Model.encode(Encoder, Data[i]);
+			}
+
+			// NOTE: encoder flushes on destruction
+			Model.encodeEndOfStream(Encoder);
+		}
+	});
+
+	u64 HeaderSize = PPM_PARALLEL_HEADER_SIZE + sizeof(u32) * BlockCount;
+	u64 TotalSize = HeaderSize;
+	for (const ByteVec& Block : BlockOut)
+	{
+		Assert(Block.size() <= MaxUInt32);
+		TotalSize += Block.size();
+	}
+
+	OutBuffer.resize(TotalSize);
+	u8* Out = OutBuffer.data();
+
+	u32 BlockSize = Params.BlockSize;
+	memcpy(Out, &BlockCount, sizeof(u32));
+	memcpy(Out + sizeof(u32), &BlockSize, sizeof(u32));
+	memcpy(Out + 2 * sizeof(u32), &Size, sizeof(u64));
+	memcpy(Out + 2 * sizeof(u32) + sizeof(u64), &Params.Order, sizeof(u32));
+	memcpy(Out + 3 * sizeof(u32) + sizeof(u64), &Params.MemLimit, sizeof(u32));
+	Out += PPM_PARALLEL_HEADER_SIZE;
+
+	for (const ByteVec& Block : BlockOut)
+	{
+		u32 CompressedSize = static_cast<u32>(Block.size());
+		memcpy(Out, &CompressedSize, sizeof(u32));
+		Out += sizeof(u32);
+	}
+
+	for (const ByteVec& Block : BlockOut)
+	{
+		if (Block.size()) memcpy(Out, Block.data(), Block.size());
+		Out += Block.size();
+	}
+}
+
+// returns decoded size, 0 on malformed container or DestSize too small.
+// Block size and model params are taken from stream, only ThreadCount and Dict are used from Params.
+// Stream model params must match Dict ones.
+u64
+PPMParallelDecompress(u8* Dest, u64 DestSize, const ByteVec& InBuffer, const ppm_parallel_params& Params)
+{
+	if (InBuffer.size() < PPM_PARALLEL_HEADER_SIZE) return 0;
+
+	const u8* In = InBuffer.data();
+
+	u32 BlockCount;
+	u32 BlockSize;
+	u64 TotalSize;
+	u32 Order;
+	u32 MemLimit;
+	memcpy(&BlockCount, In, sizeof(u32));
+	memcpy(&BlockSize, In + sizeof(u32), sizeof(u32));
+	memcpy(&TotalSize, In + 2 * sizeof(u32), sizeof(u64));
+	memcpy(&Order, In + 2 * sizeof(u32) + sizeof(u64), sizeof(u32));
+	memcpy(&MemLimit, In + 3 * sizeof(u32) + sizeof(u64), sizeof(u32));
+
+	u64 HeaderSize = PPM_PARALLEL_HEADER_SIZE + static_cast<u64>(BlockCount) * sizeof(u32);
+	if (!BlockSize || (TotalSize > DestSize) || (InBuffer.size() < HeaderSize)) return 0;
+	if (!PPMParallelValidModelParams(Order, MemLimit)) return 0;
+	if (Params.Dict && ((Params.Dict->order() != Order) || (Params.Dict->memLimit() != MemLimit))) return 0;
+	if (((TotalSize + BlockSize - 1) / BlockSize) != BlockCount) return 0;
+
+	std::vector<u64> BlockOffset(BlockCount + 1);
+	BlockOffset[0] = HeaderSize;
+	for (u32 i = 0; i < BlockCount; i++)
+	{
+		u32 CompressedSize;
+		memcpy(&CompressedSize, In + PPM_PARALLEL_HEADER_SIZE + i * sizeof(u32), sizeof(u32));
+		BlockOffset[i + 1] = BlockOffset[i] + CompressedSize;
+	}
+	if (BlockOffset[BlockCount] > InBuffer.size()) return 0;
+
+	std::atomic<b32> Valid(true);
+	u32 ThreadCount = PPMParallelThreadCount(Params.ThreadCount, BlockCount);
+
+	PPMParallelRun(ThreadCount, [&](std::atomic<u32>& NextBlock)
+	{
+		PPMByte Model(Order, MemLimit);
+		ByteVec BlockIn;
+
+		for (u32 BlockIndex = NextBlock++; BlockIndex < BlockCount; BlockIndex = NextBlock++)
+		{
+			u64 Start = static_cast<u64>(BlockIndex) * BlockSize;
+			u64 End = (Start + BlockSize) < TotalSize ? (Start + BlockSize) : TotalSize;
+
+			if (Params.Dict) Params.Dict->instantiate(Model);
+			else Model.reset();
+
+			BlockIn.assign(In + BlockOffset[BlockIndex], In + BlockOffset[BlockIndex + 1]);
+			ArithDecoder Decoder(BlockIn);
+
+			u64 ByteIndex = Start;
+			for (;;)
+			{
+				u32 DecodedSymbol = Model.decode(Decoder);
+				if (DecodedSymbol == PPMByte::EscapeSymbol) break;
+
+				if (ByteIndex == End)
+				{
+					Valid = false;
+					break;
+				}
+
+				Dest[ByteIndex++] = static_cast<u8>(DecodedSymbol);
+			}
+
+			if (ByteIndex != End) Valid = false;
+		}
+	});
+
+	u64 Result = Valid ? TotalSize : 0;
+	return Result;
+}
@@ -11,6 +11,8 @@ using ArithDecoder = ArithByteDecoder;
 
 #include "ac_models/basic_ac.cpp"
 #include "ac_models/ppm_ac.cpp"
+#include "ac_models/ppm_dict.cpp"
+#include "ac_models/ppm_parallel.cpp"
 
 template <typename TypeEncoder, b32 UseShift = false> void
 CompressStaticACFile(u16* ByteCumFreq, file_data& InputFile, ByteVec& OutBuffer)
@@ -334,4 +336,460 @@ TestPPMModel(file_data& InputFile)
 #endif
 
 	printf("\n");
-}
\ No newline at end of file
+}
+
+void
+TestPPMWorkspace(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+
+	u32 Order = 4;
+	u32 MemLimit = 20 << 20;
+	printf(" MemLim: %u Order: %u\n", MemLimit, Order);
+
+	PPMByte EncModel(Order, MemLimit);
+	ByteVec CompressBuffer;
+	CompressFile(EncModel, InputFile, CompressBuffer);
+	PrintCompressionSize(InputFile.Size, CompressBuffer.size());
+
+	// decoder model lives in caller's workspace, reset reuses it for next stream without allocation
+	std::vector<u8> DecModelMem(MemLimit);
+	SEEState DecSEE;
+	PPMByte DecModel(Order, DecModelMem.data(), DecModelMem.size(), &DecSEE);
+
+	file_data OutputFile;
+	OutputFile.Size = InputFile.Size;
+	OutputFile.Data = new u8[OutputFile.Size];
+
+	for (u32 Run = 0; Run < 2; Run++)
+	{
+		ZeroSize(OutputFile.Data, OutputFile.Size);
+
+		f64 StartTime = timer();
+		DecompressFile(DecModel, OutputFile, CompressBuffer, InputFile);
+		f64 EndTime = timer() - StartTime;
+		printf("DecTime %.3f\n", EndTime);
+
+		Verify(!memcmp(OutputFile.Data, InputFile.Data, InputFile.Size));
+		DecModel.reset();
+	}
+
+	delete[] OutputFile.Data;
+
+	printf("\n");
+}
+
+void
+TestPPMParallel(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+
+	ppm_parallel_params Params = PPMParallelDefaultParams();
+	Params.BlockSize = 1 << 18;
+	printf(" MemLim: %u Order: %u BlockSize: %u\n", Params.MemLimit, Params.Order, Params.BlockSize);
+
+	// NOTE: dictionary here is just trained on head of the file, only to show its effect
+	u64 DictSize = InputFile.Size < (1 << 15) ? InputFile.Size : (1 << 15);
+
+	ByteVec Snapshot;
+	PPMTrainDictionary(Snapshot, InputFile.Data, DictSize, Params.Order, Params.MemLimit);
+
+	PPMDictionary Dict(Params.Order, Params.MemLimit);
+	Verify(Dict.load(Snapshot.data(), Snapshot.size()));
+
+	ByteVec CompressBuffer;
+	std::vector<u8> DecBuff(InputFile.Size);
+
+	u32 MaxThreadCount = std::thread::hardware_concurrency();
+	MaxThreadCount = MaxThreadCount ? MaxThreadCount : 1;
+
+	for (u32 UseDict = 0; UseDict < 2; UseDict++)
+	{
+		Params.Dict = UseDict ? &Dict : nullptr;
+
+		for (u32 ThreadCount = 1; ThreadCount <= MaxThreadCount; ThreadCount *= 2)
+		{
+			Params.ThreadCount = ThreadCount;
+
+			f64 StartTime = timer();
+			PPMParallelCompress(InputFile.Data, InputFile.Size, CompressBuffer, Params);
+			f64 EncTime = timer() - StartTime;
+
+			StartTime = timer();
+			u64 DecodedSize = PPMParallelDecompress(DecBuff.data(), DecBuff.size(), CompressBuffer, Params);
+			f64 DecTime = timer() - StartTime;
+
+			Verify(DecodedSize == InputFile.Size);
+			Assert(!memcmp(DecBuff.data(), InputFile.Data, InputFile.Size));
+
+			printf(" %s%u threads EncTime %.3f (%.1f MiB/s) DecTime %.3f (%.1f MiB/s)\n", UseDict ? "dict, " : "", ThreadCount,
+				EncTime, InputFile.Size / (EncTime * 1048576.0), DecTime, InputFile.Size / (DecTime * 1048576.0));
+		}
+
+		PrintCompressionSize(InputFile.Size, CompressBuffer.size());
+	}
+
+	// model params out of encoder limits are rejected before any model is built
+	static constexpr u64 OrderOffset = 2 * sizeof(u32) + sizeof(u64);
+	const u32 BadParams[][2] = { { 0, Params.MemLimit }, { PPM_PARALLEL_MAX_ORDER + 1, Params.MemLimit },
+		{ Params.Order, PPM_PARALLEL_MIN_MEM_LIMIT - 1 }, { Params.Order, MaxUInt32 } };
+
+	for (const u32* Bad : BadParams)
+	{
+		ByteVec Corrupted = CompressBuffer;
+		memcpy(Corrupted.data() + OrderOffset, Bad, 2 * sizeof(u32));
+		Verify(!PPMParallelDecompress(DecBuff.data(), DecBuff.size(), Corrupted, Params));
+	}
+
+	// dictionary of other model params than stream is rejected
+	PPMDictionary OtherDict(Params.Order + 1, Params.MemLimit);
+	Params.Dict = &OtherDict;
+	Verify(!PPMParallelDecompress(DecBuff.data(), DecBuff.size(), CompressBuffer, Params));
+
+	printf("\n");
+}
+
+// small messages from second half of file, dictionary trained on first half
+void
+TestPPMDictionary(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+
+	const u32 Order = 4;
+	const u32 MemLimit = 20 << 20;
+	const u32 MessageSize = 2048;
+	const u32 MaxMessageCount = 256;
+
+	u64 TrainSize = InputFile.Size / 2;
+	u64 TestSize = InputFile.Size - TrainSize;
+	u64 MessageCount = (TestSize + MessageSize - 1) / MessageSize;
+	MessageCount = MessageCount < MaxMessageCount ? MessageCount : MaxMessageCount;
+	TestSize = MessageCount * MessageSize < TestSize ? MessageCount * MessageSize : TestSize;
+
+	const u8* TestData = InputFile.Data + TrainSize;
+
+	ByteVec Snapshot;
+	f64 StartTime = timer();
+	PPMTrainDictionary(Snapshot, InputFile.Data, TrainSize, Order, MemLimit);
+	f64 TrainTime = timer() - StartTime;
+
+	PPMDictionary Dict(Order, MemLimit);
+
+	// corrupted snapshots are rejected before any pointer of them is followed or any frequency of them is used.
+	// NOTE: fixture is trained on fixed text, so root has symbols with successors whatever the input file is
+	{
+		static constexpr u64 ArenaHeaderAt = sizeof(ppm_snapshot_header);
+		static constexpr u64 ArenaAt = ArenaHeaderAt + sizeof(sub_alloc_image_header);
+		static const char FixtureText[] = "abracadabra, abracadabra, abracadabra";
+
+		ByteVec Fixture;
+		PPMTrainDictionary(Fixture, reinterpret_cast<const u8*>(FixtureText), sizeof(FixtureText) - 1, Order, MemLimit);
+		Verify(Dict.load(Fixture.data(), Fixture.size()));
+
+		ppm_snapshot_header Header;
+		sub_alloc_image_header ArenaHeader;
+		memcpy(&Header, Fixture.data(), sizeof(Header));
+		memcpy(&ArenaHeader, Fixture.data() + ArenaHeaderAt, sizeof(ArenaHeader));
+
+		// root context fields and two successors of order 0 symbols
+		u8* Root = Fixture.data() + ArenaAt + (Header.Root - SUB_ALLOC_IMAGE_BASE);
+		context RootCtx;
+		memcpy(&RootCtx, Root, sizeof(RootCtx));
+		u64 RootAt = Root - Fixture.data();
+		u64 RootDataAt = ArenaAt + (reinterpret_cast<size_t>(RootCtx.Data) - SUB_ALLOC_IMAGE_BASE);
+
+		std::vector<u64> NextFields;
+		for (u32 i = 0; (i < RootCtx.SymbolCount) && (NextFields.size() < 2); i++)
+		{
+			u64 Next;
+			u64 NextAt = RootDataAt + i * sizeof(context_data) + offsetof(context_data, Next);
+			memcpy(&Next, Fixture.data() + NextAt, sizeof(Next));
+			if (Next) NextFields.push_back(NextAt);
+		}
+		Verify(NextFields.size() == 2);
+
+		// (offset in snapshot, value written there, value size)
+		const u64 Corruptions[][3] = {
+			{ offsetof(ppm_snapshot_header, Root), ArenaHeader.UsedSize + SUB_ALLOC_IMAGE_BASE, sizeof(u64) },
+			{ offsetof(ppm_snapshot_header, Root), Header.Root + 1, sizeof(u64) },
+			{ offsetof(ppm_snapshot_header, MaxContext), 0, sizeof(u64) },
+			{ offsetof(ppm_snapshot_header, ContextStack), ArenaHeader.UsedSize, sizeof(u64) },
+			{ offsetof(ppm_snapshot_header, InitEsc), 0xff, sizeof(u32) },
+			{ offsetof(ppm_snapshot_header, SEEPrevSuccess), 2, sizeof(u32) },
+			{ offsetof(ppm_snapshot_header, SEEBinContext), FREQ_MAX_VALUE, sizeof(u16) },
+			{ ArenaHeaderAt + offsetof(sub_alloc_image_header, SentinelNext), ArenaHeader.UsedSize, sizeof(u64) },
+			{ ArenaHeaderAt + offsetof(sub_alloc_image_header, SentinelNext), ArenaHeader.SentinelNext + 1, sizeof(u64) },
+			{ RootAt + offsetof(context, Data), MaxUInt64, sizeof(u64) },
+			{ RootAt + offsetof(context, Prev), ArenaHeader.UsedSize, sizeof(u64) },
+			{ RootAt + offsetof(context, Prev), Header.MaxContext, sizeof(u64) },
+			{ RootAt + offsetof(context, TotalFreq), 0, sizeof(u16) },
+			{ RootAt + offsetof(context, TotalFreq), RootCtx.SymbolCount, sizeof(u16) },
+			{ RootDataAt + sizeof(context_data) + offsetof(context_data, Symbol), 0, sizeof(u8) },
+			{ RootDataAt + offsetof(context_data, Freq), 0, sizeof(u8) },
+		};
+
+		ByteVec Corrupted;
+		for (const u64* Corruption : Corruptions)
+		{
+			Corrupted = Fixture;
+			memcpy(Corrupted.data() + Corruption[0], &Corruption[1], Corruption[2]);
+			Verify(!Dict.load(Corrupted.data(), Corrupted.size()));
+		}
+
+		// two symbols leading to one context
+		Corrupted = Fixture;
+		memcpy(Corrupted.data() + NextFields[1], Fixture.data() + NextFields[0], sizeof(u64));
+		Verify(!Dict.load(Corrupted.data(), Corrupted.size()));
+
+		Verify(!Dict.load(Fixture.data(), Fixture.size() - 1));
+	}
+
+	StartTime = timer();
+	b32 Loaded = Dict.load(Snapshot.data(), Snapshot.size());
+	f64 LoadTime = timer() - StartTime;
+	Verify(Loaded);
+
+	printf(" train %lu bytes %.3f s, snapshot %lu bytes, load %.3f ms\n", TrainSize, TrainTime, Snapshot.size(), LoadTime * 1000.0);
+
+	PPMByte EncModel(Order, MemLimit);
+	PPMByte DecModel(Order, MemLimit);
+	ByteVec EncBuffer;
+	std::vector<u8> DecBuffer(MessageSize);
+
+	for (u32 UseDict = 0; UseDict < 2; UseDict++)
+	{
+		u64 CompressedSize = 0;
+		f64 InitTime = 0;
+		f64 EncTime = 0;
+
+		for (u64 Start = 0; Start < TestSize; Start += MessageSize)
+		{
+			u64 Size = (TestSize - Start) < MessageSize ? (TestSize - Start) : MessageSize;
+
+			StartTime = timer();
+			if (UseDict) Dict.instantiate(EncModel);
+			else EncModel.reset();
+			InitTime += timer() - StartTime;
+
+			EncBuffer.clear();
+			StartTime = timer();
+			{
+				ArithEncoder Encoder(EncBuffer);
+				for (u64 i = 0; i < Size; ++i)
+				{
+					EncModel.encode(Encoder, TestData[Start + i]);
+				}
+				EncModel.encodeEndOfStream(Encoder);
+			}
+			EncTime += timer() - StartTime;
+			CompressedSize += EncBuffer.size();
+
+			if (UseDict) Dict.instantiate(DecModel);
+			else DecModel.reset();
+
+			ArithDecoder Decoder(EncBuffer);
+			u64 DecodedCount = 0;
+			for (;;)
+			{
+				u32 Symbol = DecModel.decode(Decoder);
+				if (Symbol == PPMByte::EscapeSymbol) break;
+
+				Assert(DecodedCount < Size);
+				DecBuffer[DecodedCount++] = static_cast<u8>(Symbol);
+			}
+
+			Assert(DecodedCount == Size);
+			Assert(!memcmp(DecBuffer.data(), TestData + Start, Size));
+		}
+
+		printf(" %s: %lu messages of %u, init %.1f us/msg, enc %.1f us/msg\n", UseDict ? "primed (clone)" : "cold (reset)",
+			MessageCount, MessageSize, InitTime * 1e6 / MessageCount, EncTime * 1e6 / MessageCount);
+		PrintCompressionSize(TestSize, CompressedSize);
+	}
+
+	printf("\n");
+}
+
+void
+TestPPMSnapshot(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+
+	const u32 Order = 4;
+	const u32 MemLimit = 20 << 20;
+	const u32 MessageSize = 2048;
+	const u32 MaxMessageCount = 256;
+
+	u64 TrainSize = InputFile.Size / 2;
+	u64 TestSize = InputFile.Size - TrainSize;
+	u64 MessageCount = (TestSize + MessageSize - 1) / MessageSize;
+	MessageCount = MessageCount < MaxMessageCount ? MessageCount : MaxMessageCount;
+	TestSize = MessageCount * MessageSize < TestSize ? MessageCount * MessageSize : TestSize;
+
+	const u8* TestData = InputFile.Data + TrainSize;
+
+	PPMByte EncModel(Order, MemLimit);
+	ByteVec Scratch;
+
+	f64 StartTime = timer();
+	EncModel.prime(InputFile.Data, TrainSize, Scratch);
+	f64 RebuildTime = timer() - StartTime;
+
+	ppm_checkpoint EncCheckpoint;
+	StartTime = timer();
+	EncModel.checkpoint(EncCheckpoint);
+	f64 CheckpointTime = timer() - StartTime;
+
+	// decoder side starts from model file
+	const std::string PathName = (fs::temp_directory_path() / "ppm_model_snapshot.bin").string();
+	Verify(PPMSaveModelFile(EncModel, PathName));
+
+	PPMByte DecModel(Order, MemLimit);
+
+	// truncated and corrupted model files are rejected
+	{
+		ByteVec Snapshot(EncModel.snapshotSize());
+		EncModel.saveSnapshot(Snapshot.data());
+
+		const std::string BadPathName = (fs::temp_directory_path() / "ppm_model_snapshot_bad.bin").string();
+		Verify(WriteEntireFile(BadPathName, Snapshot.data(), Snapshot.size() / 2));
+		Verify(!PPMLoadModelFile(DecModel, BadPathName));
+
+		u64 BadRoot = MaxUInt64;
+		memcpy(Snapshot.data() + offsetof(ppm_snapshot_header, Root), &BadRoot, sizeof(BadRoot));
+		Verify(WriteEntireFile(BadPathName, Snapshot.data(), Snapshot.size()));
+		Verify(!PPMLoadModelFile(DecModel, BadPathName));
+
+		fs::remove(BadPathName);
+	}
+
+	StartTime = timer();
+	b32 Loaded = PPMLoadModelFile(DecModel, PathName);
+	f64 LoadTime = timer() - StartTime;
+	Verify(Loaded);
+	fs::remove(PathName);
+
+	ppm_checkpoint DecCheckpoint;
+	DecModel.checkpoint(DecCheckpoint);
+
+	printf(" rebuild %.3f ms, checkpoint %.3f ms (%lu bytes), model file load %.3f ms\n",
+		RebuildTime * 1000.0, CheckpointTime * 1000.0, EncCheckpoint.Arena.Memory.size(), LoadTime * 1000.0);
+
+	ByteVec EncBuffer;
+	std::vector<u8> DecBuffer(MessageSize);
+	u64 CompressedSize = 0;
+	f64 RestoreTime = 0;
+
+	for (u64 Start = 0; Start < TestSize; Start += MessageSize)
+	{
+		u64 Size = (TestSize - Start) < MessageSize ? (TestSize - Start) : MessageSize;
+
+		StartTime = timer();
+		EncModel.restore(EncCheckpoint);
+		RestoreTime += timer() - StartTime;
+
+		EncBuffer.clear();
+		{
+			ArithEncoder Encoder(EncBuffer);
+			for (u64 i = 0; i < Size; ++i)
+			{
+				EncModel.encode(Encoder, TestData[Start + i]);
+			}
+			EncModel.encodeEndOfStream(Encoder);
+		}
+		CompressedSize += EncBuffer.size();
+
+		DecModel.restore(DecCheckpoint);
+
+		ArithDecoder Decoder(EncBuffer);
+		u64 DecodedCount = 0;
+		for (;;)
+		{
+			u32 Symbol = DecModel.decode(Decoder);
+			if (Symbol == PPMByte::EscapeSymbol) break;
+
+			Assert(DecodedCount < Size);
+			DecBuffer[DecodedCount++] = static_cast<u8>(Symbol);
+		}
+
+		Assert(DecodedCount == Size);
+		Assert(!memcmp(DecBuffer.data(), TestData + Start, Size));
+	}
+
+	printf(" %lu messages of %u, restore %.1f us/msg\n", MessageCount, MessageSize, RestoreTime * 1e6 / MessageCount);
+	PrintCompressionSize(TestSize, CompressedSize);
+	printf("\n");
+}
+
+void
+CodePPMWithTlbStats(PPMByte& EncModel, PPMByte& DecModel, file_data& InputFile, file_data& OutputFile, ByteVec& CompressBuffer)
+{
+	TlbMissCounter TlbMiss;
+
+	CompressBuffer.clear();
+	TlbMiss.start();
+	f64 StartTime = timer();
+	CompressFile(EncModel, InputFile, CompressBuffer);
+	f64 EncTime = timer() - StartTime;
+	u64 EncMiss = TlbMiss.end();
+
+	TlbMiss.start();
+	StartTime = timer();
+	DecompressFile(DecModel, OutputFile, CompressBuffer, InputFile);
+	f64 DecTime = timer() - StartTime;
+	u64 DecMiss = TlbMiss.end();
+
+	Assert(!memcmp(OutputFile.Data, InputFile.Data, InputFile.Size));
+
+	printf(" EncTime %.3f DecTime %.3f", EncTime, DecTime);
+	if (TlbMiss.Valid)
+	{
+		printf(" | dTLB misses enc %.3f dec %.3f per byte", 1.0 * EncMiss / InputFile.Size, 1.0 * DecMiss / InputFile.Size);
+	}
+	else
+	{
+		printf(" | dTLB counter n/a");
+	}
+	printf("\n");
+}
+
+// Same model on heap arena and on page backend, big MemLimit so context walk is spread over whole arena
+void
+TestPPMHugePages(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+
+	const u32 Order = 6;
+	const u32 MemLimit = 64 << 20;
+	printf(" MemLim: %u Order: %u\n", MemLimit, Order);
+
+	ByteVec CompressBuffer;
+	file_data OutputFile;
+	OutputFile.Size = InputFile.Size;
+	OutputFile.Data = new u8[OutputFile.Size];
+
+	{
+		f64 StartTime = timer();
+		PPMByte EncModel(Order, MemLimit);
+		PPMByte DecModel(Order, MemLimit);
+		printf(" heap arena, alloc %.3f s\n", timer() - StartTime);
+
+		CodePPMWithTlbStats(EncModel, DecModel, InputFile, OutputFile, CompressBuffer);
+	}
+
+	{
+		page_alloc_params Pages = PageAllocDefaultParams();
+
+		f64 StartTime = timer();
+		PPMByte EncModel(Order, MemLimit, Pages);
+		PPMByte DecModel(Order, MemLimit, Pages);
+		printf(" %s pages arena, alloc + prefault %.3f s\n", PageKindName(EncModel.SubAlloc.pageKind()), timer() - StartTime);
+
+		CodePPMWithTlbStats(EncModel, DecModel, InputFile, OutputFile, CompressBuffer);
+	}
+
+	PrintCompressionSize(InputFile.Size, CompressBuffer.size());
+	delete[] OutputFile.Data;
+
+	printf("\n");
+}
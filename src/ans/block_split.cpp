@@ -0,0 +1,186 @@
+#include <algorithm>
+
+// Adaptive block splitting: every block gets own normalized table, split points are found
+// by bottom-up merging of adjacent windows while merge is cheaper than paying for separate table
+
+static constexpr u32 SPLIT_WINDOW_SIZE = 1 << 12;
+
+// block size word + 2 words of flushed rANS state
+static constexpr u32 SplitBlockOverheadWords = 3;
+
+struct split_block
+{
+	u64 Start;
+	u64 Size;
+};
+
+struct split_node
+{
+	u32 Freq[256];
+	u64 Start;
+	u64 Size;
+	f64 Cost;
+	s32 Prev;
+	s32 Next;
+	u32 Version;
+};
+
+struct split_merge_cand
+{
+	f64 Delta;
+	u32 Left;
+	u32 LeftVersion;
+	u32 RightVersion;
+
+	split_merge_cand() { }
+	split_merge_cand(f64 D, u32 L, u32 LV, u32 RV) : Delta(D), Left(L), LeftVersion(LV), RightVersion(RV) { }
+
+	// NOTE: inverted for min-heap on std heap functions
+	bool operator < (const split_merge_cand& rhs) const
+	{
+		return Delta > rhs.Delta;
+	}
+};
+
+// estimated size in bits of block coded with own table (order-0 entropy + header)
+inline f64
+SplitBlockCost(const u32* Freq, u64 Total)
+{
+	f64 Result = 32.0 * (SplitBlockOverheadWords + FreqTableWordCount(Freq));
+	if (Total)
+	{
+		Result += Entropy(Freq, 256) * static_cast<f64>(Total);
+	}
+
+	return Result;
+}
+
+inline f64
+SplitMergeDelta(const split_node& A, const split_node& B)
+{
+	u32 MergeFreq[256];
+	for (u32 i = 0; i < 256; i++)
+	{
+		MergeFreq[i] = A.Freq[i] + B.Freq[i];
+	}
+
+	f64 Result = SplitBlockCost(MergeFreq, A.Size + B.Size) - A.Cost - B.Cost;
+	return Result;
+}
+
+void
+FixedBlockSplits(std::vector<split_block>& Blocks, u64 Size, u64 SplitSize)
+{
+	Blocks.clear();
+	for (u64 Start = 0; Start < Size; Start += SplitSize)
+	{
+		u64 Left = Size - Start;
+
+		split_block Block;
+		Block.Start = Start;
+		Block.Size = Left < SplitSize ? Left : SplitSize;
+		Blocks.push_back(Block);
+	}
+}
+
+void
+FindBlockSplits(std::vector<split_block>& Blocks, u8* Data, u64 Size, u32 WindowSize = SPLIT_WINDOW_SIZE)
+{
+	Assert(WindowSize);
+
+	Blocks.clear();
+	if (!Size) return;
+
+	u64 WindowCount = (Size + WindowSize - 1) / WindowSize;
+	std::vector<split_node> Nodes(WindowCount);
+
+	for (u64 i = 0; i < WindowCount; i++)
+	{
+		split_node& Node = Nodes[i];
+		ZeroSize(Node.Freq, sizeof(Node.Freq));
+
+		Node.Start = i * WindowSize;
+		Node.Size = (Size - Node.Start) < WindowSize ? (Size - Node.Start) : WindowSize;
+		CountByte(Node.Freq, Data + Node.Start, Node.Size);
+
+		Node.Cost = SplitBlockCost(Node.Freq, Node.Size);
+		Node.Prev = static_cast<s32>(i) - 1;
+		Node.Next = (i + 1) < WindowCount ? static_cast<s32>(i + 1) : -1;
+		Node.Version = 0;
+	}
+
+	std::vector<split_merge_cand> Heap;
+	Heap.reserve(WindowCount);
+
+	for (u64 i = 1; i < WindowCount; i++)
+	{
+		f64 Delta = SplitMergeDelta(Nodes[i - 1], Nodes[i]);
+		if (Delta < 0.0)
+		{
+			Heap.push_back(split_merge_cand(Delta, i - 1, 0, 0));
+		}
+	}
+
+	std::make_heap(Heap.begin(), Heap.end());
+
+	while (!Heap.empty())
+	{
+		std::pop_heap(Heap.begin(), Heap.end());
+		split_merge_cand Cand = Heap.back();
+		Heap.pop_back();
+
+		split_node& Left = Nodes[Cand.Left];
+		if ((Left.Version != Cand.LeftVersion) || (Left.Next < 0)) continue;
+
+		split_node& Right = Nodes[Left.Next];
+		if (Right.Version != Cand.RightVersion) continue;
+
+		for (u32 i = 0; i < 256; i++)
+		{
+			Left.Freq[i] += Right.Freq[i];
+		}
+
+		Left.Size += Right.Size;
+		Left.Cost = SplitBlockCost(Left.Freq, Left.Size);
+		Left.Version++;
+		Left.Next = Right.Next;
+
+		Right.Size = 0;
+		Right.Version++;
+
+		if (Left.Next >= 0)
+		{
+			Nodes[Left.Next].Prev = Cand.Left;
+		}
+
+		if (Left.Prev >= 0)
+		{
+			split_node& Prev = Nodes[Left.Prev];
+			f64 Delta = SplitMergeDelta(Prev, Left);
+			if (Delta < 0.0)
+			{
+				Heap.push_back(split_merge_cand(Delta, Left.Prev, Prev.Version, Left.Version));
+				std::push_heap(Heap.begin(), Heap.end());
+			}
+		}
+
+		if (Left.Next >= 0)
+		{
+			split_node& Next = Nodes[Left.Next];
+			f64 Delta = SplitMergeDelta(Left, Next);
+			if (Delta < 0.0)
+			{
+				Heap.push_back(split_merge_cand(Delta, Cand.Left, Left.Version, Next.Version));
+				std::push_heap(Heap.begin(), Heap.end());
+			}
+		}
+	}
+
+	for (s32 i = 0; i >= 0; i = Nodes[i].Next)
+	{
+		split_block Block;
+		Block.Start = Nodes[i].Start;
+		Block.Size = Nodes[i].Size;
+		Blocks.push_back(Block);
+	}
+}
@@ -0,0 +1,704 @@
+// Per block codec choice without running every coder: histograms of evenly spaced sample chunks give
+// estimated coded size of every codec. Among codecs fast enough for decode budget, fastest one whose
+// estimate is within MinGain of block size from smallest estimate wins (stored included), so few
+// saved bytes don't buy slower decode. Order-0 entropy of sample close to 8 bits means incompressible block (already compressed
+// media), it's stored right away without order-1 statistics or any entropy coding.
+// Estimates use probabilities normalized to coder precision, so table precision loss is included.
+//
+// Very skewed blocks (sparse bitmaps, mostly zero sensor data) are found by dominant symbol share of
+// sample and checked on whole block: single symbol block is just its size and symbol, otherwise runs
+// of dominant symbol are coded apart from other bytes. Single and run length are candidates only for
+// blocks where that check ran (single only for uniform block), their other estimates are placeholders. Probability cap of normalization (at most
+// (Scale - 1) / Scale) and one decode step per symbol are paid only for run lengths and literals,
+// runs are expanded with memset.
+//
+// Block format (u32 words): u32 Codec, then
+//   stored:       u32 Size, bytes padded to word
+//   Huffman:      u32 Size, u32 ByteCount, code lengths header and codes (MSB first), bytes padded to word
+//   tANS:         u32 Size, freq table words, u32 ByteCount, 4 state interleaved tANS stream, bytes padded to word
+//   rANS order-0: rANS block (RansBlockEncode)
+//   rANS order-1: u32 Size, context bitmap words, rANS block per present context
+//   single:       u32 Size, u32 Symbol
+//   run length:   u32 Size, u32 Dominant, u32 LiteralCount, rANS block of literals (if any),
+//                 rANS block of runs
+// Order-1 context is previous byte (0 for first). Run length block is LiteralCount + 1 runs of dominant
+// symbol (LEB128 bytes) with literal after every run but last. Huffman needs at least two symbols in block.
+enum block_codec
+{
+	BlockCodec_Stored,
+	BlockCodec_Huffman,
+	BlockCodec_Tans,
+	BlockCodec_RansOrder0,
+	BlockCodec_RansOrder1,
+	BlockCodec_Single,
+	BlockCodec_RunLength,
+	BlockCodec_Count,
+};
+
+static const char* BlockCodecNames[BlockCodec_Count] = {"stored", "Huffman", "tANS", "rANS o0", "rANS o1", "single", "run length"};
+
+// rough decode clocks per byte of coders in this repo (see their tests), only ratios matter
+static constexpr f64 BlockCodecDecodeClocks[BlockCodec_Count] = {0.25, 6.0, 8.0, 13.0, 24.0, 0.1, 3.0};
+
+static constexpr u32 CODEC_BLOCK_CODERS = (1 << BlockCodec_Stored) | (1 << BlockCodec_Huffman) | (1 << BlockCodec_Tans) |
+	(1 << BlockCodec_RansOrder0) | (1 << BlockCodec_RansOrder1) | (1 << BlockCodec_Single) | (1 << BlockCodec_RunLength);
+static constexpr u32 CODEC_SAMPLE_CHUNK = 512;
+static constexpr u32 CODEC_HUFF_MAX_CODELEN = 11;
+static constexpr u32 CODEC_TANS_PROB_BIT = 12;
+static constexpr u32 CODEC_TANS_STATES = 4;
+static constexpr u32 CODEC_CONTEXT_BITMAP_WORDS = 256 / 32;
+static constexpr u32 CODEC_MAX_RUN_BYTES = 5; // LEB128 of u32
+static constexpr f64 CODEC_RUN_MIN_SHARE = 0.75; // dominant symbol share of sample to check runs on whole block
+
+struct codec_select_params
+{
+	u32 SampleSize; // bytes sampled per block, smaller blocks are analyzed whole
+	f64 MaxDecodeClocks; // decode speed budget per byte
+	f64 MinGain; // fraction of block size slower codec must save to be picked over faster one
+	u32 AllowedMask; // 1 << block_codec
+};
+
+inline codec_select_params
+CodecSelectDefaultParams()
+{
+	codec_select_params Result = {};
+	Result.SampleSize = 16 << 10;
+	Result.MaxDecodeClocks = BlockCodecDecodeClocks[BlockCodec_RansOrder1];
+	Result.MinGain = 1.0 / 32.0;
+	Result.AllowedMask = CODEC_BLOCK_CODERS;
+	return Result;
+}
+
+struct codec_estimate
+{
+	f64 Bytes[BlockCodec_Count];
+	f64 Order0Bits; // per byte, of sample
+	u32 SampledSize;
+	u32 ApplicableMask; // 1 << block_codec, block coders able to code this block
+	b32 Incompressible;
+};
+
+struct codec_select_ctx
+{
+	u32 Freq[256];
+	u32 ContextTotal[256];
+	u16 NormFreq[256];
+	std::vector<u32> Pair; // [context][symbol], only rows of seen contexts are non zero
+	std::vector<u8> Literals;
+	std::vector<u8> Runs;
+	HuffDefaultBuild Huff;
+};
+
+// bits for symbols coded with probabilities normalized to 1 << ScaleBit
+inline f64
+CodecQuantizedBits(const u32* Freq, u32 Total, u16* NormFreq, u32 ScaleBit)
+{
+	OptimalNormalizeFast(Freq, NormFreq, Total, 256, 1 << ScaleBit);
+
+	f64 Result = 0;
+	for (u32 i = 0; i < 256; i++)
+	{
+		if (Freq[i])
+		{
+			Result += Freq[i] * (ScaleBit - std::log2(static_cast<f64>(NormFreq[i])));
+		}
+	}
+
+	return Result;
+}
+
+inline void
+CodecPutRun(std::vector<u8>& Runs, u32 Run)
+{
+	while (Run >= 0x80)
+	{
+		Runs.push_back(static_cast<u8>(Run | 0x80));
+		Run >>= 7;
+	}
+	Runs.push_back(static_cast<u8>(Run));
+}
+
+// splits block into bytes other than Dominant and lengths of Dominant runs between them
+void
+CodecRunLengthSplit(const u8* Data, u32 Size, u8 Dominant, std::vector<u8>& Literals, std::vector<u8>& Runs)
+{
+	Literals.clear();
+	Runs.clear();
+
+	const u64 Pattern = 0x0101010101010101ull * Dominant;
+	u32 RunStart = 0;
+	u32 i = 0;
+
+	for (;;)
+	{
+		// NOTE: 8 bytes per step while run lasts, first differing byte by lowest set bit (little endian)
+		for (; (i + 8) <= Size; i += 8)
+		{
+			u64 Bytes;
+			memcpy(&Bytes, Data + i, sizeof(u64));
+			u64 Diff = Bytes ^ Pattern;
+			if (Diff)
+			{
+				i += FindLeastSignificantSetBit64(Diff) >> 3;
+				break;
+			}
+		}
+		while ((i < Size) && (Data[i] == Dominant)) i++;
+
+		CodecPutRun(Runs, i - RunStart);
+		if (i == Size) break;
+
+		Literals.push_back(Data[i]);
+		RunStart = ++i;
+	}
+}
+
+void
+EstimateBlockCodecs(codec_select_ctx& Ctx, const u8* Data, u32 Size, const codec_select_params& Params, codec_estimate& Est)
+{
+	Assert(Size);
+
+	Est = {};
+	ZeroSize(Ctx.Freq, sizeof(Ctx.Freq));
+
+	u32 ChunkSize = Size;
+	u32 ChunkCount = 1;
+	if (Size > Params.SampleSize)
+	{
+		// NOTE: sample budget below one chunk still samples one chunk, never past block end
+		ChunkSize = Size < CODEC_SAMPLE_CHUNK ? Size : CODEC_SAMPLE_CHUNK;
+		ChunkCount = Params.SampleSize / CODEC_SAMPLE_CHUNK;
+		ChunkCount = ChunkCount ? ChunkCount : 1;
+	}
+	u32 Stride = Size / ChunkCount;
+
+	for (u32 i = 0; i < ChunkCount; i++)
+	{
+		CountByteFast(Ctx.Freq, Data + i * Stride, ChunkSize);
+	}
+
+	u32 Sampled = ChunkCount * ChunkSize;
+	f64 Scale = static_cast<f64>(Size) / Sampled;
+
+	Est.SampledSize = Sampled;
+	Est.Order0Bits = Entropy(Ctx.Freq, 256);
+	Est.Incompressible = Est.Order0Bits >= 8.0 * (1.0 - Params.MinGain);
+	Est.Bytes[BlockCodec_Stored] = 2 * sizeof(u32) + ((Size + 3) & ~3u);
+
+	u32 PresentCount = 0;
+	for (u32 i = 0; i < 256; i++) PresentCount += Ctx.Freq[i] != 0;
+
+	// size word, freq table, flushed state
+	f64 TableBytes = sizeof(u32) * (2 + FreqTableWordCount(Ctx.Freq) + 2);
+
+	f64 RansBits = CodecQuantizedBits(Ctx.Freq, Sampled, Ctx.NormFreq, RANS_BLOCK_PROB_BIT);
+	Est.Bytes[BlockCodec_RansOrder0] = RansBits * Scale / 8.0 + TableBytes;
+
+	f64 TansBits = CodecQuantizedBits(Ctx.Freq, Sampled, Ctx.NormFreq, CODEC_TANS_PROB_BIT);
+	Est.Bytes[BlockCodec_Tans] = TansBits * Scale / 8.0 + TableBytes;
+
+	// NOTE: Huffman code costs at least 1 bit per symbol, header is code lengths of present symbols
+	f64 HuffBytes = static_cast<f64>(Size) / 8.0;
+	if (PresentCount > 1)
+	{
+		u32 HuffFreq[256];
+		MemCopy(sizeof(HuffFreq), HuffFreq, Ctx.Freq);
+		Ctx.Huff.buildTable(HuffFreq, CODEC_HUFF_MAX_CODELEN);
+		HuffBytes = Ctx.Huff.countSize(HuffFreq) * Scale;
+	}
+	Est.Bytes[BlockCodec_Huffman] = HuffBytes + PresentCount + 3 * sizeof(u32);
+
+	u32 Dominant = 0;
+	for (u32 i = 1; i < 256; i++) Dominant = Ctx.Freq[i] > Ctx.Freq[Dominant] ? i : Dominant;
+
+	Est.Bytes[BlockCodec_Single] = Est.Bytes[BlockCodec_Stored] + 1;
+	Est.Bytes[BlockCodec_RunLength] = Est.Bytes[BlockCodec_Stored] + 1;
+
+	// NOTE: sample can miss rare bytes, so single and run length are decided on whole block
+	u32 RunMask = (1 << BlockCodec_Single) | (1 << BlockCodec_RunLength);
+	Est.ApplicableMask = CODEC_BLOCK_CODERS & ~RunMask;
+	if (PresentCount < 2) Est.ApplicableMask &= ~(1 << BlockCodec_Huffman);
+	if ((Params.AllowedMask & RunMask) && (Ctx.Freq[Dominant] >= CODEC_RUN_MIN_SHARE * Sampled))
+	{
+		CodecRunLengthSplit(Data, Size, static_cast<u8>(Dominant), Ctx.Literals, Ctx.Runs);
+
+		u32 LiteralCount = static_cast<u32>(Ctx.Literals.size());
+		if (!LiteralCount)
+		{
+			Est.Bytes[BlockCodec_Single] = 3 * sizeof(u32);
+			Est.ApplicableMask |= 1 << BlockCodec_Single;
+		}
+
+		u32 RunCount = static_cast<u32>(Ctx.Runs.size());
+		u32 RunFreq[256] = {};
+		CountByteFast(RunFreq, Ctx.Runs.data(), RunCount);
+		f64 RunBytes = CodecQuantizedBits(RunFreq, RunCount, Ctx.NormFreq, RANS_BLOCK_PROB_BIT) / 8.0;
+		RunBytes += sizeof(u32) * (4 + 1 + FreqTableWordCount(RunFreq) + 2);
+
+		if (LiteralCount)
+		{
+			u32 LiteralFreq[256] = {};
+			CountByteFast(LiteralFreq, Ctx.Literals.data(), LiteralCount);
+			RunBytes += CodecQuantizedBits(LiteralFreq, LiteralCount, Ctx.NormFreq, RANS_BLOCK_PROB_BIT) / 8.0;
+			RunBytes += sizeof(u32) * (1 + FreqTableWordCount(LiteralFreq) + 2);
+		}
+
+		Est.Bytes[BlockCodec_RunLength] = RunBytes;
+		Est.ApplicableMask |= 1 << BlockCodec_RunLength;
+	}
+
+	if (Est.Incompressible || !(Params.AllowedMask & (1 << BlockCodec_RansOrder1)))
+	{
+		Est.Bytes[BlockCodec_RansOrder1] = Est.Bytes[BlockCodec_Stored] + 1;
+		return;
+	}
+
+	if (Ctx.Pair.size() != 256 * 256) Ctx.Pair.assign(256 * 256, 0);
+	ZeroSize(Ctx.ContextTotal, sizeof(Ctx.ContextTotal));
+
+	for (u32 i = 0; i < ChunkCount; i++)
+	{
+		const u8* Chunk = Data + i * Stride;
+		u32 Prev = i ? Chunk[-1] : 0;
+
+		for (u32 j = 0; j < ChunkSize; j++)
+		{
+			Ctx.Pair[(Prev << 8) | Chunk[j]]++;
+			Ctx.ContextTotal[Prev]++;
+			Prev = Chunk[j];
+		}
+	}
+
+	f64 Order1Bits = 0;
+	f64 Order1HeaderBytes = sizeof(u32) * (2 + CODEC_CONTEXT_BITMAP_WORDS);
+	for (u32 c = 0; c < 256; c++)
+	{
+		if (!Ctx.ContextTotal[c]) continue;
+
+		u32* Row = Ctx.Pair.data() + (c << 8);
+		Order1Bits += CodecQuantizedBits(Row, Ctx.ContextTotal[c], Ctx.NormFreq, RANS_BLOCK_PROB_BIT);
+		Order1HeaderBytes += sizeof(u32) * (1 + FreqTableWordCount(Row) + 2);
+
+		ZeroSize(Row, 256 * sizeof(u32));
+	}
+
+	Est.Bytes[BlockCodec_RansOrder1] = Order1Bits * Scale / 8.0 + Order1HeaderBytes;
+}
+
+block_codec
+SelectBlockCodec(const codec_estimate& Est, const codec_select_params& Params)
+{
+	block_codec Result = BlockCodec_Stored;
+	if (Est.Incompressible) return Result;
+
+	// NOTE: stored is always allowed and fits any budget
+	u32 Candidates = 1 << BlockCodec_Stored;
+	u32 Usable = Params.AllowedMask & Est.ApplicableMask;
+	for (u32 Codec = BlockCodec_Stored + 1; Codec < BlockCodec_Count; Codec++)
+	{
+		if ((Usable & (1 << Codec)) && (BlockCodecDecodeClocks[Codec] <= Params.MaxDecodeClocks))
+		{
+			Candidates |= 1 << Codec;
+		}
+	}
+
+	for (u32 Codec = 0; Codec < BlockCodec_Count; Codec++)
+	{
+		if ((Candidates & (1 << Codec)) && (Est.Bytes[Codec] < Est.Bytes[Result])) Result = static_cast<block_codec>(Codec);
+	}
+
+	f64 Limit = Est.Bytes[Result] + Params.MinGain * Est.Bytes[BlockCodec_Stored];
+	for (u32 Codec = 0; Codec < BlockCodec_Count; Codec++)
+	{
+		if (!(Candidates & (1 << Codec)) || (Est.Bytes[Codec] > Limit)) continue;
+		if (BlockCodecDecodeClocks[Codec] < BlockCodecDecodeClocks[Result]) Result = static_cast<block_codec>(Codec);
+	}
+
+	return Result;
+}
+
+struct codec_block_enc_ctx
+{
+	rans_block_enc_ctx Rans;
+	u32 ContextStart[257];
+	u32 Freq[256];
+	u16 NormFreq[256];
+	HuffDefaultBuild HuffBuild;
+	HuffEncoder HuffEnc;
+	TansEncTable::entry TansEntries[256];
+	u16 TansStates[1 << CODEC_TANS_PROB_BIT];
+	std::vector<u8> Symbols;
+	std::vector<u8> Runs;
+	std::vector<u8> Bytes; // bit stream of Huffman and tANS before it's copied to block
+};
+
+struct codec_block_dec_ctx
+{
+	rans_block_dec_ctx Rans;
+	u32 ContextEnd[256];
+	u32 ContextPos[256];
+	u32 Freq[256];
+	u16 NormFreq[256];
+	HuffDecTableInfo HuffInfo;
+	huff_dec_entry HuffTable[1 << CODEC_HUFF_MAX_CODELEN];
+	TansDecTable::entry TansEntries[1 << CODEC_TANS_PROB_BIT];
+	std::vector<u8> Symbols;
+	std::vector<u8> Runs;
+};
+
+// copies bit stream bytes below Out as u32 ByteCount and bytes padded to word
+inline u32*
+CodecPutBytes(u32* Out, const u8* Bytes, u32 ByteCount)
+{
+	u32 WordCount = (ByteCount + 3) >> 2;
+	Out -= WordCount;
+	Out[WordCount - 1] = 0;
+	memcpy(Out, Bytes, ByteCount);
+	*--Out = ByteCount;
+	return Out;
+}
+
+// output bound in bytes for any block coder codec, order-1 may pay rANS block header per context,
+// run length up to literal and run byte per input byte
+inline u64
+CodecBlockBound(u64 Size)
+{
+	u64 Result = RansBlockBound(2 * Size + 1) + sizeof(u32) * (2 + CODEC_CONTEXT_BITMAP_WORDS + 256 * (RANS_BLOCK_HEADER_MAX_WORDS + 4));
+	return Result;
+}
+
+// writes backward from OutEnd, returns begin of encoded block, nullptr if Codec can't code block
+// (no block coder, single on block with more than one symbol, Huffman on block with one symbol).
+u32*
+CodecBlockEncode(codec_block_enc_ctx& Ctx, u32* OutEnd, const u8* Data, u32 Size, block_codec Codec)
+{
+	Assert(Size);
+
+	if (!(CODEC_BLOCK_CODERS & (1 << Codec))) return nullptr;
+	if ((Codec == BlockCodec_Single) && (Size > 1) && memcmp(Data, Data + 1, Size - 1)) return nullptr;
+
+	u32* Out = OutEnd;
+
+	if (Codec == BlockCodec_Stored)
+	{
+		u32 WordCount = (Size + 3) >> 2;
+		Out -= WordCount;
+		Out[WordCount - 1] = 0;
+		memcpy(Out, Data, Size);
+		*--Out = Size;
+	}
+	else if ((Codec == BlockCodec_Huffman) || (Codec == BlockCodec_Tans))
+	{
+		ZeroSize(Ctx.Freq, sizeof(Ctx.Freq));
+		CountByteFast(Ctx.Freq, Data, Size);
+
+		// NOTE: at most 12 bits per symbol (tANS freq 1, Huffman length 11) and header
+		u64 BytesCapacity = Size + (Size >> 1) + 512;
+		if (Ctx.Bytes.size() < BytesCapacity) Ctx.Bytes.resize(BytesCapacity);
+
+		u64 ByteCount = 0;
+		if (Codec == BlockCodec_Huffman)
+		{
+			u32 PresentCount = 0;
+			for (u32 i = 0; i < 256; i++) PresentCount += Ctx.Freq[i] != 0;
+			if ((PresentCount < 2) || !Ctx.HuffBuild.buildTable(Ctx.Freq, CODEC_HUFF_MAX_CODELEN)) return nullptr;
+
+			Ctx.HuffBuild.buildCodes(Ctx.HuffEnc);
+
+			BitWriter Writer(Ctx.Bytes.data(), BytesCapacity);
+			Ctx.HuffBuild.writeTable(Writer);
+			for (u32 i = 0; i < Size; i++)
+			{
+				Ctx.HuffEnc.encode(Writer, Data[i]);
+			}
+			ByteCount = Writer.finish();
+			Out = CodecPutBytes(Out, Ctx.Bytes.data(), static_cast<u32>(ByteCount));
+		}
+		else
+		{
+			OptimalNormalizeFast(Ctx.Freq, Ctx.NormFreq, Size, 256, 1 << CODEC_TANS_PROB_BIT);
+
+			TansEncTable Table;
+			Table.initRadix(Ctx.TansEntries, CODEC_TANS_PROB_BIT, Ctx.TansStates, Ctx.NormFreq);
+
+			TansInterleaved<CODEC_TANS_STATES> Coder;
+			ByteCount = Coder.encode(Ctx.Bytes.data(), BytesCapacity, Data, Size, Table);
+			Out = CodecPutBytes(Out, Ctx.Bytes.data(), static_cast<u32>(ByteCount));
+
+			for (u32 i = 0; i < 256; i++) Ctx.Freq[i] = Ctx.NormFreq[i];
+			Out -= FreqTableWordCount(Ctx.Freq);
+			WriteFreqTable(Out, Ctx.Freq);
+		}
+		Assert(ByteCount <= BytesCapacity);
+
+		*--Out = Size;
+	}
+	else if (Codec == BlockCodec_RansOrder0)
+	{
+		Out = RansBlockEncode(Ctx.Rans, Out, Data, Size);
+	}
+	else if (Codec == BlockCodec_Single)
+	{
+		*--Out = Data[0];
+		*--Out = Size;
+	}
+	else if (Codec == BlockCodec_RunLength)
+	{
+		u32 Freq[256] = {};
+		CountByteFast(Freq, Data, Size);
+
+		u32 Dominant = 0;
+		for (u32 i = 1; i < 256; i++) Dominant = Freq[i] > Freq[Dominant] ? i : Dominant;
+
+		CodecRunLengthSplit(Data, Size, static_cast<u8>(Dominant), Ctx.Symbols, Ctx.Runs);
+
+		u32 LiteralCount = static_cast<u32>(Ctx.Symbols.size());
+		Out = RansBlockEncode(Ctx.Rans, Out, Ctx.Runs.data(), static_cast<u32>(Ctx.Runs.size()));
+		if (LiteralCount)
+		{
+			Out = RansBlockEncode(Ctx.Rans, Out, Ctx.Symbols.data(), LiteralCount);
+		}
+
+		*--Out = LiteralCount;
+		*--Out = Dominant;
+		*--Out = Size;
+	}
+	else
+	{
+		// symbols grouped by context with counting sort, every group is own rANS block
+		u32* Start = Ctx.ContextStart;
+		ZeroSize(Start, sizeof(Ctx.ContextStart));
+
+		u8 Prev = 0;
+		for (u32 i = 0; i < Size; i++)
+		{
+			Start[Prev + 1]++;
+			Prev = Data[i];
+		}
+		for (u32 c = 0; c < 256; c++) Start[c + 1] += Start[c];
+
+		Ctx.Symbols.resize(Size);
+		u32 Pos[256];
+		MemCopy(sizeof(Pos), Pos, Start);
+
+		Prev = 0;
+		for (u32 i = 0; i < Size; i++)
+		{
+			Ctx.Symbols[Pos[Prev]++] = Data[i];
+			Prev = Data[i];
+		}
+
+		u32 Bitmap[CODEC_CONTEXT_BITMAP_WORDS] = {};
+		for (u32 c = 256; c > 0; c--)
+		{
+			u32 Count = Start[c] - Start[c - 1];
+			if (!Count) continue;
+
+			Out = RansBlockEncode(Ctx.Rans, Out, Ctx.Symbols.data() + Start[c - 1], Count);
+			Bitmap[(c - 1) >> 5] |= 1u << ((c - 1) & 31);
+		}
+
+		Out -= CODEC_CONTEXT_BITMAP_WORDS;
+		MemCopy(sizeof(Bitmap), Out, Bitmap);
+		*--Out = Size;
+	}
+
+	*--Out = Codec;
+	return Out;
+}
+
+// returns decoded size, 0 on malformed block or if it doesn't fit in DestCapacity; In is moved past the block.
+// Every read is bounded by InEnd.
+u32
+CodecBlockDecode(codec_block_dec_ctx& Ctx, u8* Dest, u32 DestCapacity, u32** InP, const u32* InEnd)
+{
+	u32* In = *InP;
+	if ((InEnd - In) < 2) return 0;
+
+	u32 Codec = *In++;
+	u32 Result = 0;
+
+	if (Codec == BlockCodec_Stored)
+	{
+		u32 Size = *In++;
+		u32 WordCount = (Size + 3) >> 2;
+		if (!Size || (Size > DestCapacity) || (static_cast<u64>(InEnd - In) < WordCount)) return 0;
+
+		MemCopy(Size, Dest, In);
+		In += WordCount;
+		Result = Size;
+	}
+	else if (Codec == BlockCodec_Huffman)
+	{
+		u32 Size = *In++;
+		if (In == InEnd) return 0;
+
+		u32 ByteCount = *In++;
+		u32 WordCount = (ByteCount + 3) >> 2;
+		if (!Size || (Size > DestCapacity) || (static_cast<u64>(InEnd - In) < WordCount)) return 0;
+
+		BitReaderMSB Reader(reinterpret_cast<u8*>(In), ByteCount);
+		if (!Ctx.HuffInfo.readTableChecked(Reader, CODEC_HUFF_MAX_CODELEN)) return 0;
+
+		// NOTE: incomplete code leaves zero length entries, they decode without consuming bits
+		ZeroSize(Ctx.HuffTable, sizeof(Ctx.HuffTable));
+		HuffDecoder Decoder(Ctx.HuffTable);
+		Ctx.HuffInfo.assignCodesMSB(Decoder);
+
+		u32 MaxCodeLen = Ctx.HuffInfo.MaxCodeLen;
+		u32 i = 0;
+		for (; (i + 4) <= Size; i += 4)
+		{
+			Reader.refillTo(4 * MaxCodeLen);
+			Dest[i + 0] = Decoder.decode(Reader, MaxCodeLen);
+			Dest[i + 1] = Decoder.decode(Reader, MaxCodeLen);
+			Dest[i + 2] = Decoder.decode(Reader, MaxCodeLen);
+			Dest[i + 3] = Decoder.decode(Reader, MaxCodeLen);
+		}
+		for (; i < Size; i++)
+		{
+			Reader.refillTo(MaxCodeLen);
+			Dest[i] = Decoder.decode(Reader, MaxCodeLen);
+		}
+
+		u64 BitsRead = 8 * static_cast<u64>(Reader.Stream.Pos - Reader.Stream.Start) - Reader.BitCount;
+		if (BitsRead > (8ull * ByteCount)) return 0;
+
+		In += WordCount;
+		Result = Size;
+	}
+	else if (Codec == BlockCodec_Tans)
+	{
+		u32 Size = *In++;
+		if (!Size || (Size > DestCapacity)) return 0;
+
+		u32 TableWords = ReadFreqTableChecked(Ctx.Freq, In, InEnd - In);
+		if (!TableWords) return 0;
+		In += TableWords;
+
+		u32 FreqSum = 0;
+		for (u32 i = 0; i < 256; i++)
+		{
+			FreqSum += Ctx.Freq[i];
+			Ctx.NormFreq[i] = static_cast<u16>(Ctx.Freq[i]);
+		}
+		if ((FreqSum != (1u << CODEC_TANS_PROB_BIT)) || (In == InEnd)) return 0;
+
+		u32 ByteCount = *In++;
+		u32 WordCount = (ByteCount + 3) >> 2;
+		if (!ByteCount || (static_cast<u64>(InEnd - In) < WordCount)) return 0;
+
+		// NOTE: stream ends with marker bit, so last byte is never zero
+		u8* Bytes = reinterpret_cast<u8*>(In);
+		if (!Bytes[ByteCount - 1]) return 0;
+
+		TansDecTable Table;
+		Table.initRadix(Ctx.TansEntries, CODEC_TANS_PROB_BIT, Ctx.NormFreq);
+
+		TansInterleaved<CODEC_TANS_STATES> Coder;
+		if (!Coder.decode(Dest, Size, Bytes, ByteCount, Table)) return 0;
+
+		In += WordCount;
+		Result = Size;
+	}
+	else if (Codec == BlockCodec_RansOrder0)
+	{
+		Result = RansBlockDecode(Ctx.Rans, Dest, DestCapacity, &In, InEnd);
+	}
+	else if (Codec == BlockCodec_RansOrder1)
+	{
+		u32 Size = *In++;
+		if (!Size || (Size > DestCapacity) || ((InEnd - In) < CODEC_CONTEXT_BITMAP_WORDS)) return 0;
+
+		const u32* Bitmap = In;
+		In += CODEC_CONTEXT_BITMAP_WORDS;
+
+		if (Ctx.Symbols.size() < Size) Ctx.Symbols.resize(Size);
+
+		u32 Decoded = 0;
+		for (u32 c = 0; c < 256; c++)
+		{
+			Ctx.ContextPos[c] = Decoded;
+			if (Bitmap[c >> 5] & (1u << (c & 31)))
+			{
+				u32 Count = RansBlockDecode(Ctx.Rans, Ctx.Symbols.data() + Decoded, Size - Decoded, &In, InEnd);
+				if (!Count) return 0;
+				Decoded += Count;
+			}
+			Ctx.ContextEnd[c] = Decoded;
+		}
+
+		if (Decoded != Size) return 0;
+
+		u8 Prev = 0;
+		for (u32 i = 0; i < Size; i++)
+		{
+			if (Ctx.ContextPos[Prev] == Ctx.ContextEnd[Prev]) return 0;
+			Prev = Ctx.Symbols[Ctx.ContextPos[Prev]++];
+			Dest[i] = Prev;
+		}
+
+		Result = Size;
+	}
+	else if (Codec == BlockCodec_Single)
+	{
+		u32 Size = *In++;
+		if (In == InEnd) return 0;
+
+		u32 Symbol = *In++;
+		if (!Size || (Size > DestCapacity) || (Symbol > 0xff)) return 0;
+
+		memset(Dest, Symbol, Size);
+		Result = Size;
+	}
+	else if (Codec == BlockCodec_RunLength)
+	{
+		u32 Size = *In++;
+		if ((InEnd - In) < 2) return 0;
+
+		u32 Dominant = *In++;
+		u32 LiteralCount = *In++;
+		if (!Size || (Size > DestCapacity) || (Dominant > 0xff) || (LiteralCount >= Size)) return 0;
+
+		if (Ctx.Symbols.size() < LiteralCount) Ctx.Symbols.resize(LiteralCount);
+		if (LiteralCount && (RansBlockDecode(Ctx.Rans, Ctx.Symbols.data(), LiteralCount, &In, InEnd) != LiteralCount)) return 0;
+
+		u32 RunCapacity = (LiteralCount + 1) * CODEC_MAX_RUN_BYTES;
+		if (Ctx.Runs.size() < RunCapacity) Ctx.Runs.resize(RunCapacity);
+		u32 RunBytes = RansBlockDecode(Ctx.Rans, Ctx.Runs.data(), RunCapacity, &In, InEnd);
+		if (!RunBytes) return 0;
+
+		const u8* Run = Ctx.Runs.data();
+		const u8* RunEnd = Run + RunBytes;
+		u32 Out = 0;
+
+		for (u32 l = 0;; l++)
+		{
+			u32 Length = 0;
+			for (u32 Shift = 0;; Shift += 7)
+			{
+				if ((Run == RunEnd) || (Shift > 28)) return 0;
+
+				u32 Byte = *Run++;
+				Length |= (Byte & 0x7f) << Shift;
+				if (!(Byte & 0x80)) break;
+			}
+
+			if (Length > (Size - Out)) return 0;
+			memset(Dest + Out, Dominant, Length);
+			Out += Length;
+
+			if (l == LiteralCount) break;
+			if (Out == Size) return 0;
+			Dest[Out++] = Ctx.Symbols[l];
+		}
+
+		if ((Out != Size) || (Run != RunEnd)) return 0;
+		Result = Size;
+	}
+
+	if (!Result) return 0;
+
+	*InP = In;
+	return Result;
+}
@@ -81,8 +81,8 @@ struct Rans16Dec
 		}
 	}
 
-	template<u32 N>
-	inline u8 decodeSym(rans_sym_table<N>& Tab, u32 CumFreqBound, u32 ScaleBit)
+	template<u32 N, typename SymT>
+	inline SymT decodeSym(rans_sym_table<N, SymT>& Tab, u32 CumFreqBound, u32 ScaleBit)
 	{
 		Assert(IsPowerOf2(CumFreqBound));
 		u32 Slot = State & (CumFreqBound - 1);
@@ -93,7 +93,7 @@ struct Rans16Dec
 		State = Freq * (State >> ScaleBit) + Bias;*/
 
 		State = Tab.Slot[Slot].Freq * (State >> ScaleBit) + Tab.Slot[Slot].Bias;
-		u8 Sym = Tab.Slot2Sym[Slot];
+		SymT Sym = Tab.Slot2Sym[Slot];
 		return Sym;
 	}
 
@@ -106,8 +106,57 @@ struct Rans16Dec
 			Assert(State >= Rans16L)
 		}
 	}
+
+	// NOTE: branchless (cmov), always loads next word, so at least one word must be readable
+	inline void decodeRenormFast(u16** InP)
+	{
+		u16* In = *InP;
+		u32 Less = State < Rans16L;
+		u32 Next = (State << 16) | *In;
+		State = Less ? Next : State;
+		*InP = In + Less;
+	}
+
+	// returns false if renorm needs word past InEnd
+	inline b32 decodeRenormChecked(u16** InP, const u16* InEnd)
+	{
+		if (State < Rans16L)
+		{
+			if (*InP == InEnd) return false;
+
+			State = (State << 16) | **InP;
+			*InP += 1;
+		}
+
+		return true;
+	}
 };
 
+// NOTE: file scope constant tables, no function static init on hot path
+#define _ 0x80 // move 0 to this elem on _mm_shuffle_epi8
+static ALIGN(const u8, Rans16SIMDShuffles[16][16], 16) =
+{
+	{ _,_,_,_, _,_,_,_, _,_,_,_, _,_,_,_ }, // 0000
+	{ 0,1,_,_, _,_,_,_, _,_,_,_, _,_,_,_ }, // 0001
+	{ _,_,_,_, 0,1,_,_, _,_,_,_, _,_,_,_ }, // 0010
+	{ 0,1,_,_, 2,3,_,_, _,_,_,_, _,_,_,_ }, // 0011
+	{ _,_,_,_, _,_,_,_, 0,1,_,_, _,_,_,_ }, // 0100
+	{ 0,1,_,_, _,_,_,_, 2,3,_,_, _,_,_,_ }, // 0101
+	{ _,_,_,_, 0,1,_,_, 2,3,_,_, _,_,_,_ }, // 0110
+	{ 0,1,_,_, 2,3,_,_, 4,5,_,_, _,_,_,_ }, // 0111
+	{ _,_,_,_, _,_,_,_, _,_,_,_, 0,1,_,_ }, // 1000
+	{ 0,1,_,_, _,_,_,_, _,_,_,_, 2,3,_,_ }, // 1001
+	{ _,_,_,_, 0,1,_,_, _,_,_,_, 2,3,_,_ }, // 1010
+	{ 0,1,_,_, 2,3,_,_, _,_,_,_, 4,5,_,_ }, // 1011
+	{ _,_,_,_, _,_,_,_, 0,1,_,_, 2,3,_,_ }, // 1100
+	{ 0,1,_,_, _,_,_,_, 2,3,_,_, 4,5,_,_ }, // 1101
+	{ _,_,_,_, 0,1,_,_, 2,3,_,_, 4,5,_,_ }, // 1110
+	{ 0,1,_,_, 2,3,_,_, 4,5,_,_, 6,7,_,_ }, // 1111
+};
+#undef _
+
+static const u8 Rans16SIMDInMoveCount[16] = { 0,1,1,2, 1,2,2,3, 1,2,2,3, 2,3,3,4 };
+
 struct Rans16DecSIMD
 {
 	union
@@ -153,30 +202,6 @@ struct Rans16DecSIMD
 
 	inline void decodeRenorm(u16** In)
 	{
-#define _ 0x80 // move 0 to this elem on _mm_shuffle_epi8
-		static ALIGN(const u8, Shuffles[16][16], 16) =
-		{
-			{ _,_,_,_, _,_,_,_, _,_,_,_, _,_,_,_ }, // 0000
-			{ 0,1,_,_, _,_,_,_, _,_,_,_, _,_,_,_ }, // 0001
-			{ _,_,_,_, 0,1,_,_, _,_,_,_, _,_,_,_ }, // 0010
-			{ 0,1,_,_, 2,3,_,_, _,_,_,_, _,_,_,_ }, // 0011
-			{ _,_,_,_, _,_,_,_, 0,1,_,_, _,_,_,_ }, // 0100
-			{ 0,1,_,_, _,_,_,_, 2,3,_,_, _,_,_,_ }, // 0101
-			{ _,_,_,_, 0,1,_,_, 2,3,_,_, _,_,_,_ }, // 0110
-			{ 0,1,_,_, 2,3,_,_, 4,5,_,_, _,_,_,_ }, // 0111
-			{ _,_,_,_, _,_,_,_, _,_,_,_, 0,1,_,_ }, // 1000
-			{ 0,1,_,_, _,_,_,_, _,_,_,_, 2,3,_,_ }, // 1001
-			{ _,_,_,_, 0,1,_,_, _,_,_,_, 2,3,_,_ }, // 1010
-			{ 0,1,_,_, 2,3,_,_, _,_,_,_, 4,5,_,_ }, // 1011
-			{ _,_,_,_, _,_,_,_, 0,1,_,_, 2,3,_,_ }, // 1100
-			{ 0,1,_,_, _,_,_,_, 2,3,_,_, 4,5,_,_ }, // 1101
-			{ _,_,_,_, 0,1,_,_, 2,3,_,_, 4,5,_,_ }, // 1110
-			{ 0,1,_,_, 2,3,_,_, 4,5,_,_, 6,7,_,_ }, // 1111
-		};
-#undef _
-
-		static const u8 InMoveCount[16] = { 0,1,1,2, 1,2,2,3, 1,2,2,3, 2,3,3,4 };
-
 		const u32 BiasVal = 1 << 31;
 		__m128i State_4x = State.simd;
 		__m128i BiasedState_4x = _mm_xor_si128(State_4x, _mm_set1_epi32(BiasVal));
@@ -185,10 +210,10 @@ struct Rans16DecSIMD
 
 		__m128i MemVals = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(*In)); //  4 16bit values
 		__m128i ShiftedState_4x = _mm_slli_epi32(State_4x, 16);
-		__m128i ShuffMask = _mm_load_si128(reinterpret_cast<const __m128i*>(Shuffles[Mask]));
+		__m128i ShuffMask = _mm_load_si128(reinterpret_cast<const __m128i*>(Rans16SIMDShuffles[Mask]));
 		__m128i NewState_4x = _mm_or_si128(ShiftedState_4x, _mm_shuffle_epi8(MemVals, ShuffMask));
 		State.simd = _mm_blendv_epi8(State_4x, NewState_4x, GtMask);
 
-		*In += InMoveCount[Mask];
+		*In += Rans16SIMDInMoveCount[Mask];
 	}
 };
\ No newline at end of file
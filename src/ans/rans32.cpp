@@ -32,7 +32,7 @@ struct Rans32Enc
 		State = ((NormState / Freq) << ScaleBit) + (NormState % Freq) + CumStart;
 	}
 
-	inline void encode(u32** OutP, rans_enc_sym64* Sym, u32 ScaleBit)
+	inline void encode(u32** OutP, const rans_enc_sym64* Sym, u32 ScaleBit)
 	{
 		u64 NormState = Rans32Enc::renorm(State, OutP, Sym->Freq, ScaleBit);
 		
@@ -92,8 +92,8 @@ struct Rans32Dec
 		decodeAdvance(InP, Sym->CumStart, Sym->Freq, ScaleBit);
 	}
 
-	template<u32 N>
-	inline u8 decodeSym(rans_sym_table<N>& Tab, u32 CumFreqBound, u32 ScaleBit)
+	template<u32 N, typename SymT>
+	inline SymT decodeSym(const rans_sym_table<N, SymT>& Tab, u32 CumFreqBound, u32 ScaleBit)
 	{
 		Assert(IsPowerOf2(CumFreqBound));
 		u32 Slot = State & (CumFreqBound - 1);
@@ -104,7 +104,7 @@ struct Rans32Dec
 		State = Freq * (State >> ScaleBit) + Bias;*/
 
 		State = Tab.Slot[Slot].Freq * (State >> ScaleBit) + Tab.Slot[Slot].Bias;
-		u8 Sym = Tab.Slot2Sym[Slot];
+		SymT Sym = Tab.Slot2Sym[Slot];
 		return Sym;
 	}
 
@@ -117,4 +117,28 @@ struct Rans32Dec
 			Assert(State >= Rans32L)
 		}
 	}
+
+	// NOTE: branchless (cmov), always loads next word, so at least one word must be readable
+	inline void decodeRenormFast(u32** InP)
+	{
+		u32* In = *InP;
+		u64 Less = State < Rans32L;
+		u64 Next = (State << 32) | *In;
+		State = Less ? Next : State;
+		*InP = In + Less;
+	}
+
+	// returns false if renorm needs word past InEnd
+	inline b32 decodeRenormChecked(u32** InP, const u32* InEnd)
+	{
+		if (State < Rans32L)
+		{
+			if (*InP == InEnd) return false;
+
+			State = (State << 32) | **InP;
+			*InP += 1;
+		}
+
+		return true;
+	}
 };
\ No newline at end of file
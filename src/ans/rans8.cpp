@@ -60,6 +60,28 @@ struct Rans8Enc
 		State = NormState + Sym->Bias + q * Sym->CmplFreq;
 	}
 
+	// NOTE: branchless, byte count from compares. Always stores 4 bytes below Out, extra ones are
+	// overwritten by next renorm or flush, so no slack is needed past flush bytes. ScaleBit <= 24
+	static inline u32 renormFast(u32 StateToNorm, u8** OutP, u32 Max)
+	{
+		u64 State64 = StateToNorm;
+		u32 ByteCount = (State64 >= Max) + (State64 >= (static_cast<u64>(Max) << 8)) + (State64 >= (static_cast<u64>(Max) << 16));
+
+		u32 Bytes = ByteSwap32(StateToNorm);
+		memcpy(*OutP - 4, &Bytes, sizeof(u32));
+		*OutP -= ByteCount;
+
+		u32 Result = static_cast<u32>(State64 >> (8 * ByteCount));
+		return Result;
+	}
+
+	inline void encodeFast(u8** OutP, rans_enc_sym32* Sym)
+	{
+		u32 NormState = Rans8Enc::renormFast(State, OutP, Sym->Max);
+		u32 q = (((u64)NormState * (u64)Sym->RcpFreq) >> 32) >> Sym->RcpShift;
+		State = NormState + Sym->Bias + q * Sym->CmplFreq;
+	}
+
 	inline void flush(u8** OutP)
 	{
 		u32 EndState = State;
@@ -119,4 +141,57 @@ struct Rans8Dec
 	{
 		decodeAdvance(InP, Sym->CumStart, Sym->Freq, ScaleBit);
 	}
+
+	template<u32 N, typename SymT>
+	inline SymT decodeSym(rans_sym_table<N, SymT>& Tab, u32 CumFreqBound, u32 ScaleBit)
+	{
+		Assert(IsPowerOf2(CumFreqBound));
+		u32 Slot = State & (CumFreqBound - 1);
+
+		State = Tab.Slot[Slot].Freq * (State >> ScaleBit) + Tab.Slot[Slot].Bias;
+		SymT Sym = Tab.Slot2Sym[Slot];
+		return Sym;
+	}
+
+	inline void decodeRenorm(u8** InP)
+	{
+		if (State < Rans8L)
+		{
+			u8* In = *InP;
+			do
+			{
+				State = State << 8 | *In++;
+			} while (State < Rans8L);
+			*InP = In;
+		}
+	}
+
+	// NOTE: branchless, byte count from top set bit (State is in [1, L << 8) after decodeSym),
+	// always loads 4 bytes, so they must be readable
+	inline void decodeRenormFast(u8** InP)
+	{
+		u8* In = *InP;
+		u32 ByteCount = (30 - FindMostSignificantSetBit32(State)) >> 3;
+
+		u32 Bytes;
+		memcpy(&Bytes, In, sizeof(u32));
+		u64 Next = static_cast<u64>(ByteSwap32(Bytes)) >> (32 - 8 * ByteCount);
+
+		State = static_cast<u32>((static_cast<u64>(State) << (8 * ByteCount)) | Next);
+		*InP = In + ByteCount;
+	}
+
+	// returns false if renorm needs byte past InEnd
+	inline b32 decodeRenormChecked(u8** InP, const u8* InEnd)
+	{
+		u8* In = *InP;
+		while (State < Rans8L)
+		{
+			if (In == InEnd) return false;
+			State = State << 8 | *In++;
+		}
+
+		*InP = In;
+		return true;
+	}
 };
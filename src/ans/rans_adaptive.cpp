@@ -0,0 +1,213 @@
+// Semi-adaptive rANS: running counts are re-normalized every RANS_ADAPT_INTERVAL symbols,
+// only the part of the tables that differs from previous distribution is rebuilt.
+// Table for interval K is built from symbols of intervals [0, K), so encoder and decoder
+// rebuild at the same points without side information.
+
+static constexpr u32 RANS_ADAPT_INTERVAL = 1 << 12;
+static constexpr u32 RANS_ADAPT_INC = 16;
+static constexpr u32 RANS_ADAPT_COUNT_LIMIT = 1 << 18;
+
+struct rans_adapt_stats
+{
+	u32 Count[256];
+	u32 Total;
+
+	inline void init()
+	{
+		for (u32 i = 0; i < 256; i++)
+		{
+			Count[i] = 1;
+		}
+		Total = 256;
+	}
+
+	inline void update(u8 Symbol)
+	{
+		Count[Symbol] += RANS_ADAPT_INC;
+		Total += RANS_ADAPT_INC;
+
+		if (Total > RANS_ADAPT_COUNT_LIMIT)
+		{
+			rescale();
+		}
+	}
+
+	inline void normalize(u16* NormFreq, u32 TargetTotal)
+	{
+		OptimalNormalizeFast(Count, NormFreq, Total, 256, TargetTotal);
+	}
+
+private:
+	void rescale()
+	{
+		Total = 0;
+		for (u32 i = 0; i < 256; i++)
+		{
+			Count[i] = (Count[i] + 1) >> 1;
+			Total += Count[i];
+		}
+	}
+};
+
+// NOTE: both distributions have same total, so symbols after the last changed one keep their CumStart
+inline b32
+RansFreqChangeRange(const u16* OldFreq, const u16* NewFreq, u32* First, u32* Last, u32 SymCount = 256)
+{
+	u32 i = 0;
+	while ((i < SymCount) && (OldFreq[i] == NewFreq[i])) i++;
+	if (i == SymCount) return false;
+
+	u32 j = SymCount - 1;
+	while (OldFreq[j] == NewFreq[j]) j--;
+
+	*First = i;
+	*Last = j;
+	return true;
+}
+
+template<u32 N> inline u32
+RansTableUpdateRange(rans_sym_table<N>& Tab, const u16* Freq, const u16* CumFreq, u32 First, u32 Last)
+{
+	for (u32 s = First; s <= Last; s++)
+	{
+		RansTableInitSym(Tab, s, CumFreq[s], Freq[s]);
+	}
+
+	u32 Result = CumFreq[Last + 1] - CumFreq[First];
+	return Result;
+}
+
+inline void
+RansEncSymUpdateRange(rans_enc_sym32* EncSym, const u16* Freq, const u16* CumFreq, u32 First, u32 Last, u32 ScaleBit, u32 L, u32 NormStep)
+{
+	for (u32 s = First; s <= Last; s++)
+	{
+		RansEncSymInit(&EncSym[s], CumFreq[s], Freq[s], ScaleBit, L, NormStep);
+	}
+}
+
+struct rans_adapt_rebuild_stats
+{
+	u64 RebuildCount;
+	u64 SymbolsRebuilt;
+	u64 SlotsRebuilt;
+};
+
+// returns begin of encoded data, data written backward from _Out_
+template<u32 ScaleBit> u8*
+RansAdaptiveEncode(u8* Out, const u8* Data, u64 Size, rans_adapt_rebuild_stats* RebuildStats = nullptr)
+{
+	const u32 Scale = 1 << ScaleBit;
+	u64 IntervalCount = (Size + RANS_ADAPT_INTERVAL - 1) / RANS_ADAPT_INTERVAL;
+
+	// forward pass: distribution used for every interval
+	std::vector<u16> Snapshot(IntervalCount * 256);
+
+	rans_adapt_stats Stats;
+	Stats.init();
+
+	for (u64 k = 0; k < IntervalCount; k++)
+	{
+		Stats.normalize(Snapshot.data() + k * 256, Scale);
+
+		u64 Start = k * RANS_ADAPT_INTERVAL;
+		u64 End = (Start + RANS_ADAPT_INTERVAL) < Size ? (Start + RANS_ADAPT_INTERVAL) : Size;
+		for (u64 i = Start; i < End; i++)
+		{
+			Stats.update(Data[i]);
+		}
+	}
+
+	// backward pass: tables move from interval K+1 to K with partial rebuild
+	rans_enc_sym32 EncSym[256];
+	u16 CurrFreq[256];
+	u16 CumFreq[257];
+
+	Rans8Enc Encoder;
+	Encoder.init();
+
+	for (u64 k = IntervalCount; k > 0; k--)
+	{
+		const u16* NewFreq = Snapshot.data() + (k - 1) * 256;
+
+		u32 First = 0;
+		u32 Last = 255;
+		b32 Changed = (k == IntervalCount) ? true : RansFreqChangeRange(CurrFreq, NewFreq, &First, &Last);
+
+		if (Changed)
+		{
+			for (u32 s = 0; s < 256; s++) CurrFreq[s] = NewFreq[s];
+			CalcCumFreq(CurrFreq, CumFreq, 256);
+			RansEncSymUpdateRange(EncSym, CurrFreq, CumFreq, First, Last, ScaleBit, Rans8L, 8);
+
+			if (RebuildStats)
+			{
+				RebuildStats->RebuildCount++;
+				RebuildStats->SymbolsRebuilt += Last - First + 1;
+				RebuildStats->SlotsRebuilt += CumFreq[Last + 1] - CumFreq[First];
+			}
+		}
+
+		u64 Start = (k - 1) * RANS_ADAPT_INTERVAL;
+		u64 End = (Start + RANS_ADAPT_INTERVAL) < Size ? (Start + RANS_ADAPT_INTERVAL) : Size;
+		for (u64 i = End; i > Start; i--)
+		{
+			Encoder.encode(&Out, &EncSym[Data[i - 1]]);
+		}
+	}
+
+	Encoder.flush(&Out);
+	return Out;
+}
+
+template<u32 ScaleBit> void
+RansAdaptiveDecode(u8* Dest, u64 Size, u8* In, rans_adapt_rebuild_stats* RebuildStats = nullptr)
+{
+	const u32 Scale = 1 << ScaleBit;
+
+	rans_sym_table<Scale>* Tab = new rans_sym_table<Scale>;
+	u16 CurrFreq[256];
+	u16 NewFreq[256];
+	u16 CumFreq[257];
+
+	rans_adapt_stats Stats;
+	Stats.init();
+
+	Rans8Dec Decoder;
+	Decoder.init(&In);
+
+	for (u64 Start = 0; Start < Size; Start += RANS_ADAPT_INTERVAL)
+	{
+		Stats.normalize(NewFreq, Scale);
+
+		u32 First = 0;
+		u32 Last = 255;
+		b32 Changed = (Start == 0) ? true : RansFreqChangeRange(CurrFreq, NewFreq, &First, &Last);
+
+		if (Changed)
+		{
+			for (u32 s = 0; s < 256; s++) CurrFreq[s] = NewFreq[s];
+			CalcCumFreq(CurrFreq, CumFreq, 256);
+			u32 Slots = RansTableUpdateRange(*Tab, CurrFreq, CumFreq, First, Last);
+
+			if (RebuildStats)
+			{
+				RebuildStats->RebuildCount++;
+				RebuildStats->SymbolsRebuilt += Last - First + 1;
+				RebuildStats->SlotsRebuilt += Slots;
+			}
+		}
+
+		u64 End = (Start + RANS_ADAPT_INTERVAL) < Size ? (Start + RANS_ADAPT_INTERVAL) : Size;
+		for (u64 i = Start; i < End; i++)
+		{
+			u8 Symbol = Decoder.decodeSym(*Tab, Scale, ScaleBit);
+			Decoder.decodeRenorm(&In);
+
+			Dest[i] = Symbol;
+			Stats.update(Symbol);
+		}
+	}
+
+	delete Tab;
+}
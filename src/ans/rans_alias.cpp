@@ -0,0 +1,152 @@
+static constexpr u32 RANS_ALIAS_BUCKET_COUNT = 256;
+static constexpr u32 RANS_ALIAS_BUCKET_BIT = 8;
+
+// Alias method rANS (see ryg "rANS with static probability distributions", Bloom "alias ANS").
+// Scale is split in 256 equal buckets, bucket i holds symbol i below Divider[i] and one alias symbol above.
+// Decoder side is O(alphabet); encoder remaps symbol's cumulative slot to its real slot, O(scale).
+struct RansAliasTable
+{
+	u32 ScaleBit;
+	u32 BucketShift;
+
+	// decoder
+	u32 Divider[RANS_ALIAS_BUCKET_COUNT];
+	u32 SlotAdjust[RANS_ALIAS_BUCKET_COUNT * 2];
+	u32 SlotFreq[RANS_ALIAS_BUCKET_COUNT * 2];
+	u8 Sym[RANS_ALIAS_BUCKET_COUNT * 2];
+
+	// encoder
+	rans_enc_sym64 EncSym[256];
+	std::vector<u32> Remap;
+
+	// Stats must be normalized to 1 << ScaleBit
+	void init(const SymbolStats& Stats, u32 InScaleBit)
+	{
+		Assert((InScaleBit >= RANS_ALIAS_BUCKET_BIT) && (InScaleBit <= 16));
+
+		ScaleBit = InScaleBit;
+		BucketShift = ScaleBit - RANS_ALIAS_BUCKET_BIT;
+
+		const u32 Scale = 1 << ScaleBit;
+		const u32 BucketSize = 1 << BucketShift;
+
+		// Vose: pair every underfull bucket with one overfull symbol
+		u32 Remain[256];
+		u32 Alias[256];
+		u32 Small[256];
+		u32 Large[256];
+		u32 SmallCount = 0;
+		u32 LargeCount = 0;
+
+		u32 Total = 0;
+		for (u32 i = 0; i < 256; i++)
+		{
+			Remain[i] = Stats.Freq[i];
+			Alias[i] = i;
+			Total += Stats.Freq[i];
+
+			if (Remain[i] < BucketSize)
+			{
+				Small[SmallCount++] = i;
+			}
+			else
+			{
+				Large[LargeCount++] = i;
+			}
+		}
+		Assert(Total == Scale);
+
+		while (SmallCount && LargeCount)
+		{
+			u32 S = Small[--SmallCount];
+			u32 L = Large[LargeCount - 1];
+
+			Divider[S] = Remain[S];
+			Alias[S] = L;
+
+			Remain[L] -= BucketSize - Remain[S];
+			if (Remain[L] < BucketSize)
+			{
+				LargeCount--;
+				Small[SmallCount++] = L;
+			}
+		}
+
+		// integer sizes sum exactly to scale, so whatever is left fills its own bucket
+		while (LargeCount)
+		{
+			u32 L = Large[--LargeCount];
+			Assert(Remain[L] == BucketSize);
+			Divider[L] = BucketSize;
+		}
+
+		while (SmallCount)
+		{
+			u32 S = Small[--SmallCount];
+			Assert(Remain[S] == BucketSize);
+			Divider[S] = BucketSize;
+		}
+
+		// assign real slots to each symbol's [0, Freq) range in bucket order
+		Remap.resize(Scale);
+
+		u32 NextVirtual[256] = {};
+		for (u32 Bucket = 0; Bucket < RANS_ALIAS_BUCKET_COUNT; Bucket++)
+		{
+			u32 BucketStart = Bucket << BucketShift;
+			u32 Split = BucketStart + Divider[Bucket];
+
+			u32 Primary = Bucket;
+			u32 Secondary = Alias[Bucket];
+
+			Sym[Bucket * 2 + 0] = static_cast<u8>(Primary);
+			SlotFreq[Bucket * 2 + 0] = Stats.Freq[Primary];
+			SlotAdjust[Bucket * 2 + 0] = BucketStart - NextVirtual[Primary];
+
+			for (u32 Slot = BucketStart; Slot < Split; Slot++)
+			{
+				Remap[Stats.CumFreq[Primary] + NextVirtual[Primary]++] = Slot;
+			}
+
+			Sym[Bucket * 2 + 1] = static_cast<u8>(Secondary);
+			SlotFreq[Bucket * 2 + 1] = Stats.Freq[Secondary];
+			SlotAdjust[Bucket * 2 + 1] = Split - NextVirtual[Secondary];
+
+			for (u32 Slot = Split; Slot < (BucketStart + BucketSize); Slot++)
+			{
+				Remap[Stats.CumFreq[Secondary] + NextVirtual[Secondary]++] = Slot;
+			}
+
+			// stored as absolute slot
+			Divider[Bucket] = Split;
+		}
+
+		for (u32 i = 0; i < 256; i++)
+		{
+			Assert(NextVirtual[i] == Stats.Freq[i]);
+			if (Stats.Freq[i])
+			{
+				RansEncSymInit(&EncSym[i], Stats.CumFreq[i], Stats.Freq[i], ScaleBit);
+			}
+		}
+	}
+
+	inline void encode(Rans32Enc& Enc, u32** OutP, u8 Symbol)
+	{
+		Enc.encode(OutP, &EncSym[Symbol], ScaleBit);
+
+		u64 Mask = (1 << ScaleBit) - 1;
+		Enc.State = (Enc.State & ~Mask) | Remap[Enc.State & Mask];
+	}
+
+	inline u8 decodeSym(Rans32Dec& Dec)
+	{
+		u32 Mask = (1 << ScaleBit) - 1;
+		u32 Slot = static_cast<u32>(Dec.State) & Mask;
+		u32 Bucket = Slot >> BucketShift;
+		u32 Index = (Bucket << 1) + (Slot >= Divider[Bucket]);
+
+		Dec.State = SlotFreq[Index] * (Dec.State >> ScaleBit) + (Slot - SlotAdjust[Index]);
+		return Sym[Index];
+	}
+};
@@ -0,0 +1,176 @@
+// Batch decode of many small independent Rans16 messages (plain Rans16Enc streams, one state each)
+// with shared table. Every SIMD lane decodes own message, Groups x 4 lanes (4/8/16) give more
+// independent work per step. Symbol and freq/bias lookup are done like Rans16DecSIMD, renorm loads
+// next word of every lane from its own offset and blends it in by mask.
+// When lane runs out of symbols it takes next message, lanes still busy at the end are drained scalar.
+//
+// NOTE: renorm loads next word even for lanes that don't need it, so RANS_BATCH_READ_PAD words
+// past last stream must be readable.
+static constexpr u32 RANS_BATCH_READ_PAD = 1;
+
+struct rans_batch_msg
+{
+	u32 InOffset; // u16 words from batch base
+	u32 Size;
+	u8* Dest;
+};
+
+template<u32 Groups, u32 ScaleBit>
+struct rans_batch_dec
+{
+	static constexpr u32 LANES = 4 * Groups;
+	static constexpr u32 SCALE = 1 << ScaleBit;
+
+	union
+	{
+		__m128i simd;
+		u32 lane[4];
+	} State[Groups];
+
+	u32 InOffset[LANES];
+	u32 Remaining[LANES];
+	u8* Dest[LANES];
+
+	inline void start(u32 Lane, const u16* Base, const rans_batch_msg& Msg)
+	{
+		const u16* In = Base + Msg.InOffset;
+		State[Lane >> 2].lane[Lane & 3] = In[0] | (In[1] << 16);
+		InOffset[Lane] = Msg.InOffset + 2;
+		Remaining[Lane] = Msg.Size;
+		Dest[Lane] = Msg.Dest;
+	}
+
+	inline void decodeStep(const rans_sym_table<SCALE>& Tab, const u16* Base, u32 Step)
+	{
+		for (u32 g = 0; g < Groups; g++)
+		{
+			__m128i State_4x = State[g].simd;
+			__m128i Slots = _mm_and_si128(State_4x, _mm_set1_epi32(SCALE - 1));
+			u32 Index0 = _mm_cvtsi128_si32(Slots);
+			u32 Index1 = _mm_extract_epi32(Slots, 1);
+			u32 Index2 = _mm_extract_epi32(Slots, 2);
+			u32 Index3 = _mm_extract_epi32(Slots, 3);
+
+			Dest[4 * g + 0][Step] = Tab.Slot2Sym[Index0];
+			Dest[4 * g + 1][Step] = Tab.Slot2Sym[Index1];
+			Dest[4 * g + 2][Step] = Tab.Slot2Sym[Index2];
+			Dest[4 * g + 3][Step] = Tab.Slot2Sym[Index3];
+
+			__m128i FreqBiasLo, FreqBiasHi;
+			FreqBiasLo = _mm_cvtsi32_si128(Tab.Slot[Index0].Val);
+			FreqBiasLo = _mm_insert_epi32(FreqBiasLo, Tab.Slot[Index1].Val, 1);
+			FreqBiasHi = _mm_cvtsi32_si128(Tab.Slot[Index2].Val);
+			FreqBiasHi = _mm_insert_epi32(FreqBiasHi, Tab.Slot[Index3].Val, 1);
+			__m128i FreqBias = _mm_unpacklo_epi64(FreqBiasLo, FreqBiasHi);
+
+			__m128i ScaledState_4x = _mm_srli_epi32(State_4x, ScaleBit);
+			__m128i Freq_4x = _mm_and_si128(FreqBias, _mm_set1_epi32(0xffff));
+			__m128i Bias_4x = _mm_srli_epi32(FreqBias, 16);
+			State_4x = _mm_add_epi32(_mm_mullo_epi32(Freq_4x, ScaledState_4x), Bias_4x);
+
+			// renorm: unsigned State < L by biased signed compare
+			const u32 BiasVal = 1u << 31;
+			__m128i BiasedState_4x = _mm_xor_si128(State_4x, _mm_set1_epi32(BiasVal));
+			__m128i LessMask = _mm_cmpgt_epi32(_mm_set1_epi32(Rans16L - BiasVal), BiasedState_4x);
+			u32 Mask = _mm_movemask_ps(_mm_castsi128_ps(LessMask));
+
+			u32* Offset = InOffset + 4 * g;
+			__m128i Words = _mm_cvtsi32_si128(Base[Offset[0]]);
+			Words = _mm_insert_epi32(Words, Base[Offset[1]], 1);
+			Words = _mm_insert_epi32(Words, Base[Offset[2]], 2);
+			Words = _mm_insert_epi32(Words, Base[Offset[3]], 3);
+
+			__m128i NewState_4x = _mm_or_si128(_mm_slli_epi32(State_4x, 16), Words);
+			State[g].simd = _mm_blendv_epi8(State_4x, NewState_4x, LessMask);
+
+			Offset[0] += (Mask >> 0) & 1;
+			Offset[1] += (Mask >> 1) & 1;
+			Offset[2] += (Mask >> 2) & 1;
+			Offset[3] += (Mask >> 3) & 1;
+		}
+	}
+
+	inline void drain(const rans_sym_table<SCALE>& Tab, const u16* Base, u32 Lane)
+	{
+		u32 LaneState = State[Lane >> 2].lane[Lane & 3];
+		u32 Offset = InOffset[Lane];
+
+		for (u32 i = 0; i < Remaining[Lane]; i++)
+		{
+			u32 Slot = LaneState & (SCALE - 1);
+			Dest[Lane][i] = Tab.Slot2Sym[Slot];
+			LaneState = Tab.Slot[Slot].Freq * (LaneState >> ScaleBit) + Tab.Slot[Slot].Bias;
+
+			if (LaneState < Rans16L)
+			{
+				LaneState = (LaneState << 16) | Base[Offset++];
+			}
+		}
+
+		Remaining[Lane] = 0;
+	}
+};
+
+template<u32 Groups, u32 ScaleBit> void
+Rans16DecodeBatch(const rans_sym_table<1 << ScaleBit>& Tab, const u16* Base, const rans_batch_msg* Msgs, u32 MsgCount)
+{
+	typedef rans_batch_dec<Groups, ScaleBit> batch;
+	batch Dec;
+
+	u32 NextMsg = 0;
+	u32 Active = 0;
+
+	for (u32 Lane = 0; Lane < batch::LANES; Lane++)
+	{
+		while ((NextMsg < MsgCount) && !Msgs[NextMsg].Size) NextMsg++;
+		if (NextMsg == MsgCount) break;
+
+		Dec.start(Lane, Base, Msgs[NextMsg++]);
+		Active++;
+	}
+
+	if (Active == batch::LANES)
+	{
+		for (;;)
+		{
+			u32 StepCount = Dec.Remaining[0];
+			for (u32 Lane = 1; Lane < batch::LANES; Lane++)
+			{
+				StepCount = Dec.Remaining[Lane] < StepCount ? Dec.Remaining[Lane] : StepCount;
+			}
+
+			for (u32 Step = 0; Step < StepCount; Step++)
+			{
+				Dec.decodeStep(Tab, Base, Step);
+			}
+
+			b32 Refilled = true;
+			for (u32 Lane = 0; Lane < batch::LANES; Lane++)
+			{
+				Dec.Remaining[Lane] -= StepCount;
+				Dec.Dest[Lane] += StepCount;
+
+				if (!Dec.Remaining[Lane])
+				{
+					while ((NextMsg < MsgCount) && !Msgs[NextMsg].Size) NextMsg++;
+
+					if (NextMsg < MsgCount)
+					{
+						Dec.start(Lane, Base, Msgs[NextMsg++]);
+					}
+					else
+					{
+						Refilled = false;
+					}
+				}
+			}
+
+			if (!Refilled) break;
+		}
+	}
+
+	for (u32 Lane = 0; Lane < Active; Lane++)
+	{
+		Dec.drain(Tab, Base, Lane);
+	}
+}
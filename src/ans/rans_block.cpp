@@ -0,0 +1,265 @@
+// Single block static rANS codec for small messages (same layout as one block of EncodeBlocksRans32):
+// block size word, freq table words, then Rans32 stream.
+// All scratch lives in caller owned context, so one context per thread can code any number of messages
+// without allocation. Contexts are never shared between threads, shared tables are only read.
+static constexpr u32 RANS_BLOCK_PROB_BIT = 12;
+static constexpr u32 RANS_BLOCK_PROB_SCALE = 1 << RANS_BLOCK_PROB_BIT;
+static constexpr u32 RANS_BLOCK_HEADER_MAX_WORDS = 1 + FreqTableBitmapWords + 128;
+
+struct rans_block_enc_ctx
+{
+	u32 Freq[256];
+	u32 CumFreq[257];
+	u16 NormFreq[256];
+	rans_enc_sym64 EncSym[256];
+	u32 HeaderWords[RANS_BLOCK_HEADER_MAX_WORDS];
+};
+
+struct rans_block_dec_ctx
+{
+	u32 Freq[256];
+	u32 CumFreq[257];
+	rans_sym_table<RANS_BLOCK_PROB_SCALE> Tab;
+};
+
+// output bound in bytes, Out end must be u32 aligned.
+// Any symbol has freq >= 1 of 1 << 12, so it costs at most 12 bits (dictionary table may fit data badly)
+inline u64
+RansBlockBound(u64 Size)
+{
+	u64 Result = Size + (Size >> 1) + sizeof(u32) * (RANS_BLOCK_HEADER_MAX_WORDS + 4);
+	return Result;
+}
+
+// writes backward from OutEnd, returns begin of encoded block
+u32*
+RansBlockEncode(rans_block_enc_ctx& Ctx, u32* OutEnd, const u8* Data, u32 Size)
+{
+	Assert(Size);
+
+	u32* Out = OutEnd;
+
+	ZeroSize(Ctx.Freq, sizeof(Ctx.Freq));
+	CountByteFast(Ctx.Freq, Data, Size);
+
+	OptimalNormalizeFast(Ctx.Freq, Ctx.NormFreq, Size, 256, RANS_BLOCK_PROB_SCALE);
+	for (u32 i = 0; i < 256; i++)
+	{
+		Ctx.Freq[i] = Ctx.NormFreq[i];
+	}
+	CalcCumFreq(Ctx.Freq, Ctx.CumFreq, 256);
+
+	for (u32 i = 0; i < 256; i++)
+	{
+		if (Ctx.Freq[i])
+		{
+			RansEncSymInit(&Ctx.EncSym[i], Ctx.CumFreq[i], Ctx.Freq[i], RANS_BLOCK_PROB_BIT);
+		}
+	}
+
+	Rans32Enc Encoder;
+	Encoder.init();
+
+	for (u64 i = Size; i > 0; i--)
+	{
+		Encoder.encode(&Out, &Ctx.EncSym[Data[i - 1]], RANS_BLOCK_PROB_BIT);
+	}
+	Encoder.flush(&Out);
+
+	Ctx.HeaderWords[0] = Size;
+	u32 HeaderCount = 1 + WriteFreqTable(Ctx.HeaderWords + 1, Ctx.Freq);
+
+	Out -= HeaderCount;
+	MemCopy(sizeof(u32) * HeaderCount, Out, Ctx.HeaderWords);
+
+	return Out;
+}
+
+// returns decoded size, 0 if block doesn't fit in DestCapacity; In is moved past the block
+u32
+RansBlockDecode(rans_block_dec_ctx& Ctx, u8* Dest, u32 DestCapacity, u32** InP)
+{
+	u32* In = *InP;
+
+	u32 BlockSize = *In++;
+	if (!BlockSize || (BlockSize > DestCapacity)) return 0;
+
+	In += ReadFreqTable(Ctx.Freq, In);
+	CalcCumFreq(Ctx.Freq, Ctx.CumFreq, 256);
+
+	for (u32 i = 0; i < 256; i++)
+	{
+		RansTableInitSym(Ctx.Tab, i, Ctx.CumFreq[i], Ctx.Freq[i]);
+	}
+
+	Rans32Dec Decoder;
+	Decoder.init(&In);
+
+	for (u32 i = 0; i < BlockSize; i++)
+	{
+		Dest[i] = Decoder.decodeSym(Ctx.Tab, RANS_BLOCK_PROB_SCALE, RANS_BLOCK_PROB_BIT);
+		Decoder.decodeRenorm(&In);
+	}
+
+	*InP = In;
+	return BlockSize;
+}
+
+// Same for untrusted input: every read is bounded by InEnd, freq table must sum to scale and
+// decoder must end in initial state. Main loop decodes 4 symbols per step without checks while
+// at least 4 words remain (Rans32 reads at most one word per symbol), rest goes through checked tail.
+u32
+RansBlockDecode(rans_block_dec_ctx& Ctx, u8* Dest, u32 DestCapacity, u32** InP, const u32* InEnd)
+{
+	u32* In = *InP;
+	if (In >= InEnd) return 0;
+
+	u32 BlockSize = *In++;
+	if (!BlockSize || (BlockSize > DestCapacity)) return 0;
+
+	u32 TableWords = ReadFreqTableChecked(Ctx.Freq, In, InEnd - In);
+	if (!TableWords) return 0;
+	In += TableWords;
+
+	CalcCumFreq(Ctx.Freq, Ctx.CumFreq, 256);
+	if (Ctx.CumFreq[256] != RANS_BLOCK_PROB_SCALE) return 0;
+
+	for (u32 i = 0; i < 256; i++)
+	{
+		RansTableInitSym(Ctx.Tab, i, Ctx.CumFreq[i], Ctx.Freq[i]);
+	}
+
+	if ((InEnd - In) < 2) return 0;
+
+	Rans32Dec Decoder;
+	Decoder.init(&In);
+
+	u32 i = 0;
+	for (;;)
+	{
+		u64 StepCount = (BlockSize - i) >> 2;
+		u64 SafeCount = static_cast<u64>(InEnd - In) >> 2;
+		StepCount = StepCount < SafeCount ? StepCount : SafeCount;
+		if (!StepCount) break;
+
+		for (u32 End = i + static_cast<u32>(StepCount * 4); i < End; i += 4)
+		{
+			Dest[i + 0] = Decoder.decodeSym(Ctx.Tab, RANS_BLOCK_PROB_SCALE, RANS_BLOCK_PROB_BIT);
+			Decoder.decodeRenormFast(&In);
+			Dest[i + 1] = Decoder.decodeSym(Ctx.Tab, RANS_BLOCK_PROB_SCALE, RANS_BLOCK_PROB_BIT);
+			Decoder.decodeRenormFast(&In);
+			Dest[i + 2] = Decoder.decodeSym(Ctx.Tab, RANS_BLOCK_PROB_SCALE, RANS_BLOCK_PROB_BIT);
+			Decoder.decodeRenormFast(&In);
+			Dest[i + 3] = Decoder.decodeSym(Ctx.Tab, RANS_BLOCK_PROB_SCALE, RANS_BLOCK_PROB_BIT);
+			Decoder.decodeRenormFast(&In);
+		}
+	}
+
+	for (; i < BlockSize; i++)
+	{
+		Dest[i] = Decoder.decodeSym(Ctx.Tab, RANS_BLOCK_PROB_SCALE, RANS_BLOCK_PROB_BIT);
+		if (!Decoder.decodeRenormChecked(&In, InEnd)) return 0;
+	}
+
+	if (Decoder.State != Rans32L) return 0;
+
+	*InP = In;
+	return BlockSize;
+}
+
+// Pretrained table for messages too small to carry their own: block is just size word + Rans32 stream.
+// Every symbol keeps at least 1 slot so any message can be coded. Dict is only read while coding.
+struct rans_block_dict
+{
+	u32 Freq[256];
+	u32 CumFreq[257];
+	rans_enc_sym64 EncSym[256];
+	rans_sym_table<RANS_BLOCK_PROB_SCALE> Tab;
+
+	void train(const u8* Samples, u64 Size)
+	{
+		Assert(Size <= (MaxUInt32 - 256));
+
+		ZeroSize(Freq, sizeof(Freq));
+		CountByteFast(Freq, Samples, Size);
+
+		for (u32 i = 0; i < 256; i++)
+		{
+			Freq[i]++;
+		}
+
+		u16 NormFreq[256];
+		OptimalNormalizeFast(Freq, NormFreq, static_cast<u32>(Size) + 256, 256, RANS_BLOCK_PROB_SCALE);
+		for (u32 i = 0; i < 256; i++)
+		{
+			Freq[i] = NormFreq[i];
+		}
+
+		build();
+	}
+
+	// serialized as freq table words, returns word count
+	u32 save(u32* Words) const
+	{
+		u32 Result = WriteFreqTable(Words, Freq);
+		return Result;
+	}
+
+	u32 load(const u32* Words)
+	{
+		u32 Result = ReadFreqTable(Freq, Words);
+		build();
+		return Result;
+	}
+
+	u32* encode(u32* OutEnd, const u8* Data, u32 Size) const
+	{
+		u32* Out = OutEnd;
+
+		Rans32Enc Encoder;
+		Encoder.init();
+
+		for (u64 i = Size; i > 0; i--)
+		{
+			Encoder.encode(&Out, &EncSym[Data[i - 1]], RANS_BLOCK_PROB_BIT);
+		}
+		Encoder.flush(&Out);
+
+		*--Out = Size;
+		return Out;
+	}
+
+	u32 decode(u8* Dest, u32 DestCapacity, u32** InP) const
+	{
+		u32* In = *InP;
+
+		u32 BlockSize = *In++;
+		if (BlockSize > DestCapacity) return 0;
+
+		Rans32Dec Decoder;
+		Decoder.init(&In);
+
+		for (u32 i = 0; i < BlockSize; i++)
+		{
+			Dest[i] = Decoder.decodeSym(Tab, RANS_BLOCK_PROB_SCALE, RANS_BLOCK_PROB_BIT);
+			Decoder.decodeRenorm(&In);
+		}
+
+		*InP = In;
+		return BlockSize;
+	}
+
+private:
+	void build()
+	{
+		CalcCumFreq(Freq, CumFreq, 256);
+		Assert(CumFreq[256] == RANS_BLOCK_PROB_SCALE);
+
+		for (u32 i = 0; i < 256; i++)
+		{
+			Assert(Freq[i]);
+			RansEncSymInit(&EncSym[i], CumFreq[i], Freq[i], RANS_BLOCK_PROB_BIT);
+			RansTableInitSym(Tab, i, CumFreq[i], Freq[i]);
+		}
+	}
+};
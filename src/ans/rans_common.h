@@ -1,6 +1,14 @@
 #if !defined(RANS_COMMON_H)
 #define RANS_COMMON_H
 
+#include <type_traits>
+
+static constexpr u32 ANS_MAX_ALPH_SIZE = 4096;
+
+// byte alphabets keep u8 symbols, larger ones (up to 4096) use u16
+template<u32 AlphSize>
+using ans_sym_type = typename std::conditional<(AlphSize <= 256), u8, u16>::type;
+
 struct rans_sym
 {
 	u16 Freq;
@@ -47,23 +55,24 @@ union rans_sym_slot
 	};
 };
 
-template<u32 N>
+template<u32 N, typename SymT = u8>
 struct rans_sym_table
 {
 	rans_sym_slot Slot[N];
-	u8 Slot2Sym[N];
+	SymT Slot2Sym[N];
 };
 
-template<u32 N> inline void
-RansTableInitSym(rans_sym_table<N>& Tab, u8 Sym, u32 CumStart, u32 Freq)
+template<u32 N, typename SymT> inline void
+RansTableInitSym(rans_sym_table<N, SymT>& Tab, u32 Sym, u32 CumStart, u32 Freq)
 {
-	Assert(Freq < N);
+	Assert(Freq <= N);
+	Assert(Freq < (1 << 16));
 	Assert(CumStart <= N);
 
 	for (u32 i = 0; i < Freq; i++)
 	{
 		u32 Index = CumStart + i;
-		Tab.Slot2Sym[Index] = Sym;
+		Tab.Slot2Sym[Index] = static_cast<SymT>(Sym);
 		Tab.Slot[Index].Freq = (u16)Freq;
 		Tab.Slot[Index].Bias = (u16)i;
 	}
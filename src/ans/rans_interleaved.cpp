@@ -0,0 +1,143 @@
+// Generic N-way interleaved scalar rANS. Symbol i is coded by lane i % Lanes, all lanes share one
+// output stream. ScaleBit is compile time, so shifts and masks fold to immediates.
+// u32 state uses Rans16 layout (16 bit words), u64 state uses Rans32 layout (32 bit words);
+// 2 lanes give same stream as TestTableInterleavedRans16/32.
+template<typename StateT>
+struct rans_state_traits;
+
+template<>
+struct rans_state_traits<u32>
+{
+	typedef u16 word;
+	static constexpr u32 WORD_BITS = 16;
+	static constexpr u32 L = Rans16L;
+};
+
+template<>
+struct rans_state_traits<u64>
+{
+	typedef u32 word;
+	static constexpr u32 WORD_BITS = 32;
+	static constexpr u64 L = Rans32L;
+};
+
+template<typename StateT, u32 Lanes, u32 ScaleBit>
+struct rans_interleaved
+{
+	typedef rans_state_traits<StateT> traits;
+	typedef typename traits::word word;
+
+	static constexpr StateT L = traits::L;
+	static constexpr u32 WORD_BITS = traits::WORD_BITS;
+	static constexpr u32 SCALE = 1 << ScaleBit;
+
+	static_assert(Lanes && !(Lanes & (Lanes - 1)), "lane count must be power of 2");
+	static_assert((ScaleBit >= 8) && (ScaleBit <= 15), "table slots keep freq and bias in u16");
+
+	// worst case output in words: ScaleBit bits per symbol plus lane flush
+	static u64 bound(u64 Size)
+	{
+		u64 Result = (Size * ScaleBit + WORD_BITS - 1) / WORD_BITS + 2 * Lanes;
+		return Result;
+	}
+
+	static inline void encodeStep(StateT& State, word** OutP, u32 CumStart, u32 Freq)
+	{
+		u64 Max = (static_cast<u64>(L >> ScaleBit) << WORD_BITS) * Freq;
+		if (State >= Max)
+		{
+			*OutP -= 1;
+			**OutP = static_cast<word>(State);
+			State >>= WORD_BITS;
+		}
+
+		State = ((State / Freq) << ScaleBit) + (State % Freq) + CumStart;
+	}
+
+	static inline u8 decodeStep(StateT& State, const rans_sym_table<SCALE>& Tab)
+	{
+		u32 Slot = static_cast<u32>(State) & (SCALE - 1);
+		State = Tab.Slot[Slot].Freq * (State >> ScaleBit) + Tab.Slot[Slot].Bias;
+		return Tab.Slot2Sym[Slot];
+	}
+
+	static inline void renormStep(StateT& State, const word** InP)
+	{
+		if (State < L)
+		{
+			State = (State << WORD_BITS) | **InP;
+			*InP += 1;
+		}
+	}
+
+	// writes backward from OutEnd, returns begin of stream
+	static word* encode(word* OutEnd, const u8* Data, u64 Size, const u32* CumFreq, const u32* Freq)
+	{
+		word* Out = OutEnd;
+
+		StateT State[Lanes];
+		for (u32 j = 0; j < Lanes; j++) State[j] = L;
+
+		// tail symbols are decoded last, so they are encoded first
+		u64 Body = Size & ~static_cast<u64>(Lanes - 1);
+		for (u64 i = Size; i > Body; i--)
+		{
+			u8 Symbol = Data[i - 1];
+			encodeStep(State[(i - 1) & (Lanes - 1)], &Out, CumFreq[Symbol], Freq[Symbol]);
+		}
+
+		for (u64 i = Body; i > 0; i -= Lanes)
+		{
+			const u8* Group = Data + i - Lanes;
+			for (u32 j = Lanes; j > 0; j--)
+			{
+				u8 Symbol = Group[j - 1];
+				encodeStep(State[j - 1], &Out, CumFreq[Symbol], Freq[Symbol]);
+			}
+		}
+
+		for (u32 j = Lanes; j > 0; j--)
+		{
+			Out -= 2;
+			Out[0] = static_cast<word>(State[j - 1]);
+			Out[1] = static_cast<word>(State[j - 1] >> WORD_BITS);
+		}
+
+		return Out;
+	}
+
+	// returns end of consumed stream
+	static const word* decode(u8* Dest, u64 Size, const word* Begin, const rans_sym_table<SCALE>& Tab)
+	{
+		const word* In = Begin;
+
+		StateT State[Lanes];
+		for (u32 j = 0; j < Lanes; j++)
+		{
+			State[j] = static_cast<StateT>(In[0]) | (static_cast<StateT>(In[1]) << WORD_BITS);
+			In += 2;
+		}
+
+		u64 Body = Size & ~static_cast<u64>(Lanes - 1);
+		for (u64 i = 0; i < Body; i += Lanes)
+		{
+			for (u32 j = 0; j < Lanes; j++)
+			{
+				Dest[i + j] = decodeStep(State[j], Tab);
+			}
+
+			for (u32 j = 0; j < Lanes; j++)
+			{
+				renormStep(State[j], &In);
+			}
+		}
+
+		for (u32 j = 0; j < (Size - Body); j++)
+		{
+			Dest[Body + j] = decodeStep(State[j], Tab);
+			renormStep(State[j], &In);
+		}
+
+		return In;
+	}
+};
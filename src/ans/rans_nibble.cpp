@@ -0,0 +1,185 @@
+static constexpr u32 RANS_NIBBLE_SCALE_BIT = 16;
+static constexpr u32 RANS_NIBBLE_SCALE = 1 << RANS_NIBBLE_SCALE_BIT;
+
+// Byte is coded as high nibble, then low nibble conditioned on high one, each at 16 bit scale.
+// Decoder keeps only 17 cdf of 16 symbols (~1.1 KB) instead of 1 << 16 slot table.
+struct rans_nibble_cdf
+{
+	// Cum[0] == 0, Cum[16] == scale
+	u32 Cum[17];
+};
+
+// index of last Cum[k] <= Slot, SSE compare of all 16 bounds
+inline u32
+RansNibbleFind(const rans_nibble_cdf& Cdf, u32 Slot)
+{
+	const __m128i* Cum = reinterpret_cast<const __m128i*>(Cdf.Cum + 1);
+	__m128i SlotV = _mm_set1_epi32(Slot);
+
+	__m128i Gt0 = _mm_cmpgt_epi32(_mm_loadu_si128(Cum + 0), SlotV);
+	__m128i Gt1 = _mm_cmpgt_epi32(_mm_loadu_si128(Cum + 1), SlotV);
+	__m128i Gt2 = _mm_cmpgt_epi32(_mm_loadu_si128(Cum + 2), SlotV);
+	__m128i Gt3 = _mm_cmpgt_epi32(_mm_loadu_si128(Cum + 3), SlotV);
+
+	// every lane is 0 or -1
+	__m128i Sum = _mm_add_epi32(_mm_add_epi32(Gt0, Gt1), _mm_add_epi32(Gt2, Gt3));
+	Sum = _mm_add_epi32(Sum, _mm_shuffle_epi32(Sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	Sum = _mm_add_epi32(Sum, _mm_shuffle_epi32(Sum, _MM_SHUFFLE(2, 3, 0, 1)));
+
+	u32 Result = 16 + _mm_cvtsi128_si32(Sum);
+	return Result;
+}
+
+struct RansNibbleModel
+{
+	rans_nibble_cdf Hi;
+	rans_nibble_cdf Lo[16];
+
+	rans_enc_sym64 EncHi[16];
+	rans_enc_sym64 EncLo[16][16];
+
+	void init(const u32* ByteFreq)
+	{
+		u32 HiFreq[16] = {};
+		u32 HiTotal = 0;
+		for (u32 i = 0; i < 256; i++)
+		{
+			HiFreq[i >> 4] += ByteFreq[i];
+			HiTotal += ByteFreq[i];
+		}
+
+		initCdf(Hi, EncHi, HiFreq, HiTotal);
+
+		for (u32 h = 0; h < 16; h++)
+		{
+			initCdf(Lo[h], EncLo[h], ByteFreq + (h << 4), HiFreq[h]);
+		}
+	}
+
+private:
+	static void initCdf(rans_nibble_cdf& Cdf, rans_enc_sym64* Enc, const u32* Freq, u32 Total)
+	{
+		u32 NormFreq[16] = {};
+
+		u32 UsedCount = 0;
+		u32 LastUsed = 0;
+		for (u32 i = 0; i < 16; i++)
+		{
+			if (Freq[i])
+			{
+				UsedCount++;
+				LastUsed = i;
+			}
+		}
+
+		// NOTE: single symbol takes whole scale, that doesn't fit u16 of normalizer
+		if (UsedCount == 1)
+		{
+			NormFreq[LastUsed] = RANS_NIBBLE_SCALE;
+		}
+		else if (UsedCount > 1)
+		{
+			u16 Norm16[16];
+			OptimalNormalizeFast(Freq, Norm16, Total, 16, RANS_NIBBLE_SCALE);
+
+			for (u32 i = 0; i < 16; i++)
+			{
+				NormFreq[i] = Norm16[i];
+			}
+		}
+
+		Cdf.Cum[0] = 0;
+		for (u32 i = 0; i < 16; i++)
+		{
+			Cdf.Cum[i + 1] = Cdf.Cum[i] + NormFreq[i];
+			if (NormFreq[i])
+			{
+				RansEncSymInit(&Enc[i], Cdf.Cum[i], NormFreq[i], RANS_NIBBLE_SCALE_BIT);
+			}
+		}
+
+		Assert(!UsedCount || (Cdf.Cum[16] == RANS_NIBBLE_SCALE));
+	}
+};
+
+// NOTE: decode is latency bound (search -> cdf load -> state update per nibble), so byte i uses state i % 4
+static constexpr u32 RANS_NIBBLE_STATE_COUNT = 4;
+
+inline void
+RansNibbleEncodeByte(Rans32Enc& Enc, u32** OutP, u8 Byte, RansNibbleModel& Model)
+{
+	Enc.encode(OutP, &Model.EncLo[Byte >> 4][Byte & 0xf], RANS_NIBBLE_SCALE_BIT);
+	Enc.encode(OutP, &Model.EncHi[Byte >> 4], RANS_NIBBLE_SCALE_BIT);
+}
+
+u32*
+RansNibbleEncode(u32* Out, const u8* Data, u64 Size, RansNibbleModel& Model)
+{
+	Rans32Enc Enc[RANS_NIBBLE_STATE_COUNT];
+	for (u32 k = 0; k < RANS_NIBBLE_STATE_COUNT; k++)
+	{
+		Enc[k].init();
+	}
+
+	u64 GroupEnd = Size - (Size % RANS_NIBBLE_STATE_COUNT);
+	for (u64 i = Size; i > GroupEnd; i--)
+	{
+		RansNibbleEncodeByte(Enc[(i - 1) % RANS_NIBBLE_STATE_COUNT], &Out, Data[i - 1], Model);
+	}
+
+	for (u64 i = GroupEnd; i > 0; i -= RANS_NIBBLE_STATE_COUNT)
+	{
+		const u8* Group = Data + i - RANS_NIBBLE_STATE_COUNT;
+		for (u32 k = RANS_NIBBLE_STATE_COUNT; k > 0; k--)
+		{
+			RansNibbleEncodeByte(Enc[k - 1], &Out, Group[k - 1], Model);
+		}
+	}
+
+	for (u32 k = RANS_NIBBLE_STATE_COUNT; k > 0; k--)
+	{
+		Enc[k - 1].flush(&Out);
+	}
+
+	return Out;
+}
+
+inline u8
+RansNibbleDecodeByte(Rans32Dec& Dec, u32** InP, const RansNibbleModel& Model)
+{
+	u32 Slot = Dec.decodeGet(RANS_NIBBLE_SCALE_BIT);
+	u32 Hi = RansNibbleFind(Model.Hi, Slot);
+	Dec.decodeAdvance(InP, Model.Hi.Cum[Hi], Model.Hi.Cum[Hi + 1] - Model.Hi.Cum[Hi], RANS_NIBBLE_SCALE_BIT);
+
+	const rans_nibble_cdf& LoCdf = Model.Lo[Hi];
+	Slot = Dec.decodeGet(RANS_NIBBLE_SCALE_BIT);
+	u32 Lo = RansNibbleFind(LoCdf, Slot);
+	Dec.decodeAdvance(InP, LoCdf.Cum[Lo], LoCdf.Cum[Lo + 1] - LoCdf.Cum[Lo], RANS_NIBBLE_SCALE_BIT);
+
+	u8 Result = static_cast<u8>((Hi << 4) | Lo);
+	return Result;
+}
+
+void
+RansNibbleDecode(u8* Dest, u64 Size, u32* In, const RansNibbleModel& Model)
+{
+	Rans32Dec Dec[RANS_NIBBLE_STATE_COUNT];
+	for (u32 k = 0; k < RANS_NIBBLE_STATE_COUNT; k++)
+	{
+		Dec[k].init(&In);
+	}
+
+	u64 GroupEnd = Size - (Size % RANS_NIBBLE_STATE_COUNT);
+	for (u64 i = 0; i < GroupEnd; i += RANS_NIBBLE_STATE_COUNT)
+	{
+		for (u32 k = 0; k < RANS_NIBBLE_STATE_COUNT; k++)
+		{
+			Dest[i + k] = RansNibbleDecodeByte(Dec[k], &In, Model);
+		}
+	}
+
+	for (u64 i = GroupEnd; i < Size; i++)
+	{
+		Dest[i] = RansNibbleDecodeByte(Dec[i % RANS_NIBBLE_STATE_COUNT], &In, Model);
+	}
+}
@@ -0,0 +1,237 @@
+#include <atomic>
+#include <thread>
+
+// Parallel decode of one Rans32 stream from stored split points.
+// Decoder state before symbol i equals encoder state after encoding symbol i (encoder goes backward),
+// so encoder can record (state, word offset) at every Interval symbols. Decoder threads start at
+// these points and decode one stream on many cores; freq table stays shared, cost is only index.
+// Same index can be built by one sequential decode of existing stream, so old files need no re-encode.
+//
+// Serialized index (u32 words): Interval, PointCount, PointCount x (state lo, state hi, word offset)
+static constexpr u32 RANS_SPLIT_POINT_WORDS = 3;
+
+struct rans_split_point
+{
+	u64 State;
+	u32 InOffset; // words from stream begin
+};
+
+struct rans_split_index
+{
+	u32 Interval;
+	std::vector<rans_split_point> Points; // point k is entry to symbol k * Interval, point 0 is stream begin
+};
+
+// writes backward from OutEnd, returns begin of stream
+template<u32 ScaleBit> u32*
+Rans32EncodeSplit(u32* OutEnd, const u8* Data, u64 Size, const rans_enc_sym64* EncSym, u32 Interval, rans_split_index& Index)
+{
+	Assert(Interval);
+
+	u64 PointCount = Size ? (Size + Interval - 1) / Interval : 1;
+	Index.Interval = Interval;
+	Index.Points.resize(PointCount);
+
+	u32* Out = OutEnd;
+
+	Rans32Enc Encoder;
+	Encoder.init();
+
+	for (u64 i = Size; i > 0; i--)
+	{
+		Encoder.encode(&Out, &EncSym[Data[i - 1]], ScaleBit);
+
+		if (((i - 1) % Interval) == 0)
+		{
+			rans_split_point& Point = Index.Points[(i - 1) / Interval];
+			Point.State = Encoder.State;
+			Point.InOffset = static_cast<u32>(OutEnd - Out); // NOTE: fixed up to offset from begin below
+		}
+	}
+
+	Encoder.flush(&Out);
+
+	// decoder init reads state words, so stream begin is entry to symbol 0 as well
+	u32 StreamWords = static_cast<u32>(OutEnd - Out);
+	for (rans_split_point& Point : Index.Points)
+	{
+		Point.InOffset = StreamWords - Point.InOffset;
+	}
+
+	if (!Size)
+	{
+		Index.Points[0].State = Encoder.State;
+		Index.Points[0].InOffset = 2;
+	}
+
+	return Out;
+}
+
+// builds same index from existing stream by one sequential decode
+template<u32 ScaleBit, u32 N> void
+Rans32BuildSplitIndex(const rans_sym_table<N>& Tab, const u32* Begin, u64 Size, u32 Interval, rans_split_index& Index)
+{
+	Assert(Interval);
+
+	u64 PointCount = Size ? (Size + Interval - 1) / Interval : 1;
+	Index.Interval = Interval;
+	Index.Points.resize(PointCount);
+
+	u32* In = const_cast<u32*>(Begin);
+
+	Rans32Dec Decoder;
+	Decoder.init(&In);
+
+	for (u64 i = 0; i < Size; i++)
+	{
+		if ((i % Interval) == 0)
+		{
+			rans_split_point& Point = Index.Points[i / Interval];
+			Point.State = Decoder.State;
+			Point.InOffset = static_cast<u32>(In - Begin);
+		}
+
+		Decoder.decodeSym(Tab, N, ScaleBit);
+		Decoder.decodeRenorm(&In);
+	}
+
+	if (!Size)
+	{
+		Index.Points[0].State = Decoder.State;
+		Index.Points[0].InOffset = static_cast<u32>(In - Begin);
+	}
+}
+
+inline u32
+Rans32SplitIndexWords(const rans_split_index& Index)
+{
+	u32 Result = 2 + RANS_SPLIT_POINT_WORDS * static_cast<u32>(Index.Points.size());
+	return Result;
+}
+
+u32
+WriteSplitIndex(u32* Words, const rans_split_index& Index)
+{
+	Words[0] = Index.Interval;
+	Words[1] = static_cast<u32>(Index.Points.size());
+
+	u32* Out = Words + 2;
+	for (const rans_split_point& Point : Index.Points)
+	{
+		Out[0] = static_cast<u32>(Point.State);
+		Out[1] = static_cast<u32>(Point.State >> 32);
+		Out[2] = Point.InOffset;
+		Out += RANS_SPLIT_POINT_WORDS;
+	}
+
+	u32 Result = static_cast<u32>(Out - Words);
+	return Result;
+}
+
+// returns words read, 0 if index is malformed
+u32
+ReadSplitIndex(rans_split_index& Index, const u32* Words, u32 WordCount)
+{
+	if (WordCount < 2) return 0;
+
+	Index.Interval = Words[0];
+	u32 PointCount = Words[1];
+	if (!Index.Interval || !PointCount || (((WordCount - 2) / RANS_SPLIT_POINT_WORDS) < PointCount)) return 0;
+
+	Index.Points.resize(PointCount);
+
+	const u32* In = Words + 2;
+	for (rans_split_point& Point : Index.Points)
+	{
+		Point.State = In[0] | (static_cast<u64>(In[1]) << 32);
+		Point.InOffset = In[2];
+		In += RANS_SPLIT_POINT_WORDS;
+	}
+
+	u32 Result = static_cast<u32>(In - Words);
+	return Result;
+}
+
+// Decodes segments on ThreadCount threads (0 - all hardware threads), calling thread is worker 0.
+// Every segment must end exactly in state and offset of next point (last one in initial encoder state),
+// returns false otherwise.
+template<u32 ScaleBit, u32 N> b32
+Rans32DecodeSplit(u8* Dest, u64 Size, const u32* Begin, u64 WordCount, const rans_sym_table<N>& Tab,
+				  const rans_split_index& Index, u32 ThreadCount)
+{
+	u64 PointCount = Index.Points.size();
+	if (!Index.Interval || (PointCount != (Size ? (Size + Index.Interval - 1) / Index.Interval : 1))) return false;
+
+	for (const rans_split_point& Point : Index.Points)
+	{
+		if ((Point.InOffset < 2) || (Point.InOffset > WordCount) || (Point.State < Rans32L)) return false;
+	}
+
+	if (ThreadCount == 0)
+	{
+		ThreadCount = std::thread::hardware_concurrency();
+		ThreadCount = ThreadCount ? ThreadCount : 1;
+	}
+	ThreadCount = ThreadCount < PointCount ? ThreadCount : static_cast<u32>(PointCount);
+
+	std::atomic<u64> NextSegment(0);
+	std::atomic<b32> Valid(true);
+
+	auto WorkerLoop = [&]()
+	{
+		for (u64 Segment = NextSegment++; Segment < PointCount; Segment = NextSegment++)
+		{
+			const rans_split_point& Point = Index.Points[Segment];
+			u64 Start = Segment * Index.Interval;
+			u64 End = (Start + Index.Interval) < Size ? (Start + Index.Interval) : Size;
+
+			u32* In = const_cast<u32*>(Begin) + Point.InOffset;
+			u32* InEnd = const_cast<u32*>(Begin) + WordCount;
+
+			Rans32Dec Decoder;
+			Decoder.State = Point.State;
+
+			for (u64 i = Start; i < End; i++)
+			{
+				Dest[i] = Decoder.decodeSym(Tab, N, ScaleBit);
+
+				// NOTE: renorm inlined to bound reads by stream end
+				if (Decoder.State < Rans32L)
+				{
+					if (In == InEnd)
+					{
+						Valid = false;
+						return;
+					}
+					Decoder.State = (Decoder.State << 32) | *In++;
+				}
+			}
+
+			b32 Last = (Segment + 1) == PointCount;
+			u64 ExpectState = Last ? Rans32L : Index.Points[Segment + 1].State;
+			u64 ExpectOffset = Last ? WordCount : Index.Points[Segment + 1].InOffset;
+			if ((Decoder.State != ExpectState) || (static_cast<u64>(In - Begin) != ExpectOffset))
+			{
+				Valid = false;
+			}
+		}
+	};
+
+	std::vector<std::thread> Workers;
+	Workers.reserve(ThreadCount ? ThreadCount - 1 : 0);
+
+	for (u32 i = 1; i < ThreadCount; i++)
+	{
+		Workers.emplace_back(WorkerLoop);
+	}
+
+	WorkerLoop();
+
+	for (auto& Worker : Workers)
+	{
+		Worker.join();
+	}
+
+	b32 Result = Valid;
+	return Result;
+}
@@ -9,7 +9,7 @@ struct SymbolStats
 	void countSymbol(u8* Input, u64 Size)
 	{
 		ZeroSize(Freq, sizeof(Freq));
-		CountByte(Freq, Input, Size);
+		CountByteFast(Freq, Input, Size);
 	}
 
 	void normalize(u32 TargetTotal)
@@ -59,9 +59,114 @@ struct SymbolStats
 		caclCumFreq();
 	}
 
+	void optimalNormalizeFast(u32 TargetTotal)
+	{
+		u32 TotalSum = 0;
+		for (u32 i = 0; i < 256; i++)
+		{
+			TotalSum += Freq[i];
+		}
+
+		u16 NormFreq[256] = {};
+		OptimalNormalizeFast(Freq, NormFreq, TotalSum, 256, TargetTotal);
+
+		for (u32 s = 0; s < 256; s++)
+		{
+			Freq[s] = NormFreq[s];
+		}
+		caclCumFreq();
+	}
+
 private:
 	void caclCumFreq()
 	{
 		CalcCumFreq(Freq, CumFreq, 256);
 	}
-};
\ No newline at end of file
+};
+
+// NOTE: table layout in u32 words: 8 words presence bitmap, then freq of each present symbol as u16 (2 per word)
+static constexpr u32 FreqTableBitmapWords = 256 / 32;
+
+inline u32
+FreqTableWordCount(const u32* Freq, u32 AlphSize = 256)
+{
+	u32 PresentCount = 0;
+	for (u32 i = 0; i < AlphSize; i++)
+	{
+		PresentCount += Freq[i] ? 1 : 0;
+	}
+
+	u32 Result = FreqTableBitmapWords + ((PresentCount + 1) >> 1);
+	return Result;
+}
+
+inline u32
+WriteFreqTable(u32* Words, const u32* Freq, u32 AlphSize = 256)
+{
+	Assert(AlphSize <= 256);
+
+	u32* Bitmap = Words;
+	u16* FreqOut = reinterpret_cast<u16*>(Words + FreqTableBitmapWords);
+
+	ZeroSize(Bitmap, sizeof(u32) * FreqTableBitmapWords);
+
+	u32 PresentCount = 0;
+	for (u32 i = 0; i < AlphSize; i++)
+	{
+		if (Freq[i])
+		{
+			Assert(Freq[i] <= MaxUInt16);
+
+			Bitmap[i >> 5] |= 1 << (i & 31);
+			FreqOut[PresentCount++] = static_cast<u16>(Freq[i]);
+		}
+	}
+
+	if (PresentCount & 1)
+	{
+		FreqOut[PresentCount] = 0;
+	}
+
+	u32 Result = FreqTableBitmapWords + ((PresentCount + 1) >> 1);
+	return Result;
+}
+
+inline u32
+ReadFreqTable(u32* Freq, const u32* Words, u32 AlphSize = 256)
+{
+	Assert(AlphSize <= 256);
+
+	const u32* Bitmap = Words;
+	const u16* FreqIn = reinterpret_cast<const u16*>(Words + FreqTableBitmapWords);
+
+	u32 PresentCount = 0;
+	for (u32 i = 0; i < AlphSize; i++)
+	{
+		Freq[i] = 0;
+		if (Bitmap[i >> 5] & (1 << (i & 31)))
+		{
+			Freq[i] = FreqIn[PresentCount++];
+		}
+	}
+
+	u32 Result = FreqTableBitmapWords + ((PresentCount + 1) >> 1);
+	return Result;
+}
+
+// returns words read, 0 if table doesn't fit in WordCount
+inline u32
+ReadFreqTableChecked(u32* Freq, const u32* Words, u64 WordCount, u32 AlphSize = 256)
+{
+	if (WordCount < FreqTableBitmapWords) return 0;
+
+	u32 PresentCount = 0;
+	for (u32 i = 0; i < AlphSize; i++)
+	{
+		PresentCount += (Words[i >> 5] >> (i & 31)) & 1;
+	}
+
+	if (WordCount < (FreqTableBitmapWords + ((PresentCount + 1) >> 1))) return 0;
+
+	u32 Result = ReadFreqTable(Freq, Words, AlphSize);
+	return Result;
+}
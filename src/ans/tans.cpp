@@ -28,31 +28,41 @@ TansRadixSort8(u32* RadixHisto, const u32 RadixNumber, const u16* NormFreq, u32
 	return RadixCum;
 }
 
-struct TansEncTable
+static constexpr u32 TANS_MAX_TABLE_LOG = 16;
+static constexpr u32 TANS_RADIX_MAX_TABLE_LOG = 15;
+static constexpr u32 TANS_CACHE_MAX_TABLE_LOG = 14; // default table memory per TansTableCache entry
+
+// NOTE: States keeps (state - L), so it fits u16 up to TableLog 16
+template<u32 AlphSize>
+struct TansEncTableAlph
 {
+	static_assert(AlphSize <= ANS_MAX_ALPH_SIZE, "tANS alphabet is too big");
+	using sym_type = ans_sym_type<AlphSize>;
+
 	struct entry
 	{
 		s32 deltaState;
 		u32 deltaNumBits;
 	};
 
-	TansEncTable::entry* Entries;
+	entry* Entries;
 	u16* States;
 	u32 StateBits;
 	u32 L;
 
-	TansEncTable() = default;
+	TansEncTableAlph() = default;
 
-	void initRadix(TansEncTable::entry* EntriesMem, u32 TableLog, u16* TableMem, const u16* NormFreq, u32 AlphSymCount = 256)
+	void initRadix(entry* EntriesMem, u32 TableLog, u16* TableMem, const u16* NormFreq, u32 AlphSymCount = AlphSize)
 	{
-		Assert(TableLog <= 14);
+		Assert(TableLog <= TANS_RADIX_MAX_TABLE_LOG);
+		Assert(AlphSymCount <= AlphSize);
 		StateBits = TableLog;
 		L = 1 << TableLog;
 
 		Entries = EntriesMem;
 		States = TableMem;
 
-		u16 CumFreq[256] = {};
+		u32 CumFreq[AlphSize] = {};
 		for (u32 i = 1; i < AlphSymCount; i++)
 		{
 			CumFreq[i] = CumFreq[i - 1] + NormFreq[i - 1];
@@ -71,8 +81,8 @@ struct TansEncTable
 			u16 Freq = NormFreq[SymIndex];
 			if (!Freq) continue;
 
-			u8 NumBits = TableLog - FindMostSignificantSetBit32(Freq - 1);
-			u16 MinStatePlus = Freq << NumBits;
+			u32 NumBits = TableLog - FindMostSignificantSetBit32(Freq - 1);
+			u32 MinStatePlus = Freq << NumBits;
 			Entries[SymIndex].deltaNumBits = (NumBits << 16) - MinStatePlus;
 			Entries[SymIndex].deltaState = Total - Freq;
 			Total += Freq;
@@ -87,28 +97,28 @@ struct TansEncTable
 				Rank += Invp;
 
 				u32 To = RadixHisto[Index]++;
-				u16 ToState = (L + To);
-				*SymStates++ = ToState;
+				*SymStates++ = static_cast<u16>(To);
 			}
 		}
 	}
 
-	void init(TansEncTable::entry* EntriesMem, u32 TableLog, u16* TableMem, const u8* SortedSym, const u16* NormFreq, u32 AlphSymCount = 256)
+	void init(entry* EntriesMem, u32 TableLog, u16* TableMem, const sym_type* SortedSym, const u16* NormFreq, u32 AlphSymCount = AlphSize)
 	{
-		Assert(TableLog <= 14);
+		Assert(TableLog <= TANS_MAX_TABLE_LOG);
+		Assert(AlphSymCount <= AlphSize);
 		StateBits = TableLog;
 		L = 1 << TableLog;
 
 		Entries = EntriesMem;
 		States = TableMem;
 
-		u16 NextState[256];
+		u32 NextState[AlphSize];
 		for (u32 i = 0; i < AlphSymCount; i++)
 		{
 			NextState[i] = NormFreq[i];
 		}
 
-		u16 CumFreq[256] = {};
+		u32 CumFreq[AlphSize] = {};
 		for (u32 i = 1; i < AlphSymCount; i++)
 		{
 			CumFreq[i] = CumFreq[i - 1] + NormFreq[i - 1];
@@ -116,23 +126,21 @@ struct TansEncTable
 
 		for (u32 i = 0; i < L; i++)
 		{
-			u32 ToState = L + i;
-
-			u8 Sym = SortedSym[i];
-			u16 FromState = NextState[Sym]++;
-			u16 SymNormFreq = NormFreq[Sym];
+			sym_type Sym = SortedSym[i];
+			u32 FromState = NextState[Sym]++;
+			u32 SymNormFreq = NormFreq[Sym];
 
-			States[CumFreq[Sym] + FromState - SymNormFreq] = ToState;
+			States[CumFreq[Sym] + FromState - SymNormFreq] = static_cast<u16>(i);
 		}
 
 		u32 Total = 0;
 		for (u32 i = 0; i < AlphSymCount; i++)
 		{
-			u16 Freq = NormFreq[i];
+			u32 Freq = NormFreq[i];
 			if (!Freq) continue;
 
-			u8 NumBits = TableLog - FindMostSignificantSetBit32(Freq - 1);
-			u16 MinStatePlus = Freq << NumBits;
+			u32 NumBits = TableLog - FindMostSignificantSetBit32(Freq - 1);
+			u32 MinStatePlus = Freq << NumBits;
 			Entries[i].deltaNumBits = (NumBits << 16) - MinStatePlus;
 			Entries[i].deltaState = Total - Freq;
 			Total += Freq;
@@ -140,24 +148,29 @@ struct TansEncTable
 	}
 };
 
-struct TansDecTable
+template<u32 AlphSize>
+struct TansDecTableAlph
 {
+	static_assert(AlphSize <= ANS_MAX_ALPH_SIZE, "tANS alphabet is too big");
+	using sym_type = ans_sym_type<AlphSize>;
+
 	struct entry
 	{
 		u16 NextState;
 		u8 Bits;
-		u8 Sym;
+		sym_type Sym;
 	};
 
 	entry* Entry;
 	u32 StateBits;
 	u32 L;
 
-	TansDecTable() = default;
+	TansDecTableAlph() = default;
 
-	void initRadix(TansDecTable::entry* EntriesMem, u32 TableLog, const u16* NormFreq, u32 AlphSymCount = 256)
+	void initRadix(entry* EntriesMem, u32 TableLog, const u16* NormFreq, u32 AlphSymCount = AlphSize)
 	{
-		Assert(TableLog <= 14);
+		Assert(TableLog <= TANS_RADIX_MAX_TABLE_LOG);
+		Assert(AlphSymCount <= AlphSize);
 
 		StateBits = TableLog;
 		L = 1 << TableLog;
@@ -176,7 +189,7 @@ struct TansDecTable
 		u32 Total = 0;
 		for (u32 SymIndex = 0; SymIndex < AlphSymCount; SymIndex++)
 		{
-			u16 Freq = NormFreq[SymIndex];
+			u32 Freq = NormFreq[SymIndex];
 			if (!Freq) continue;
 
 			u32 Invp = RadixNumber / Freq;
@@ -190,23 +203,24 @@ struct TansDecTable
 				u32 To = RadixHisto[Index]++;
 				u32 FromState = Freq + i;
 
-				Entry[To].Sym = SymIndex;
+				Entry[To].Sym = static_cast<sym_type>(SymIndex);
 				Entry[To].Bits = TableLog - FindMostSignificantSetBit32(FromState);
 				Entry[To].NextState = (FromState << Entry[To].Bits) - L;
 			}
 		}
 	}
 
-	void init(TansDecTable::entry* EntriesMem, u32 TableLog, const u8* SortedSym, const u16* NormFreq, u32 AlphSymCount = 256)
+	void init(entry* EntriesMem, u32 TableLog, const sym_type* SortedSym, const u16* NormFreq, u32 AlphSymCount = AlphSize)
 	{
-		Assert(TableLog <= 14);
+		Assert(TableLog <= TANS_MAX_TABLE_LOG);
+		Assert(AlphSymCount <= AlphSize);
 
 		StateBits = TableLog;
 		L = 1 << TableLog;
 
 		Entry = EntriesMem;
 
-		u16 NextState[256];
+		u32 NextState[AlphSize];
 		for (u32 i = 0; i < AlphSymCount; i++)
 		{
 			NextState[i] = NormFreq[i];
@@ -214,7 +228,7 @@ struct TansDecTable
 
 		for (u32 i = 0; i < L; i++)
 		{
-			u8 Sym = SortedSym[i];
+			sym_type Sym = SortedSym[i];
 			u32 FromState = NextState[Sym]++;
 
 			Entry[i].Sym = Sym;
@@ -224,25 +238,31 @@ struct TansDecTable
 	}
 };
 
+using TansEncTable = TansEncTableAlph<256>;
+using TansDecTable = TansDecTableAlph<256>;
+
 struct TansState
 {
 	u64 State;
 
-	void encode(BitWriter& Writer, const TansEncTable& Table, u8 Symbol)
+	template<u32 AlphSize>
+	void encode(BitWriter& Writer, const TansEncTableAlph<AlphSize>& Table, u32 Symbol)
 	{
-		const TansEncTable::entry& Entry = Table.Entries[Symbol];
+		const typename TansEncTableAlph<AlphSize>::entry& Entry = Table.Entries[Symbol];
 
-		u8 NumBits = (State + Entry.deltaNumBits) >> 16;
-		Writer.writeMaskMSB(State, NumBits);
+		// NOTE: 32 bit wrap is intended, deltaNumBits is negative for Freq > L/2 at TableLog 16
+		u32 NumBits = (static_cast<u32>(State) + Entry.deltaNumBits) >> 16;
+		Writer.writeMaskMSB(static_cast<u32>(State), NumBits);
 
-		State = Table.States[(State >> NumBits) + Entry.deltaState];
+		State = Table.L + Table.States[(State >> NumBits) + Entry.deltaState];
 	}
 
-	u8 decode(BitReaderReverseMSB& Reader, const TansDecTable& Table)
+	template<u32 AlphSize>
+	ans_sym_type<AlphSize> decode(BitReaderReverseMSB& Reader, const TansDecTableAlph<AlphSize>& Table)
 	{
 		u64 CurrState = State;
 
-		const TansDecTable::entry& Entry = Table.Entry[CurrState];
+		const typename TansDecTableAlph<AlphSize>::entry& Entry = Table.Entry[CurrState];
 		CurrState = Entry.NextState;
 
 		u64 ReadBits = Reader.peek(Entry.Bits);
@@ -0,0 +1,253 @@
+static constexpr u32 TANS_MIN_TABLE_LOG = 5;
+
+inline u32
+TansSpreadStep(u32 TableSize)
+{
+	u32 Result = (TableSize >> 1) + (TableSize >> 3) + 3;
+	return Result;
+}
+
+// FSE style spread: symbols laid out linearly 8 bytes per store, then scattered with odd step over table
+// Linear needs (1 << TableLog) + 8 bytes of room
+template<typename SymT> inline void
+TansSpreadSymbols(SymT* Spread, SymT* Linear, u32 TableLog, const u16* NormFreq, u32 AlphSymCount)
+{
+	Assert((TableLog >= TANS_MIN_TABLE_LOG) && (TableLog <= TANS_MAX_TABLE_LOG));
+
+	const u32 L = 1 << TableLog;
+	const u32 Mask = L - 1;
+	const u32 Step = TansSpreadStep(L);
+
+	constexpr u32 SymPerWord = sizeof(u64) / sizeof(SymT);
+	constexpr u64 Broadcast = (sizeof(SymT) == 1) ? 0x0101010101010101ull : 0x0001000100010001ull;
+
+	u32 Pos = 0;
+	for (u32 SymIndex = 0; SymIndex < AlphSymCount; SymIndex++)
+	{
+		u32 Freq = NormFreq[SymIndex];
+		u64 Val = static_cast<u64>(SymIndex) * Broadcast;
+
+		for (u32 i = 0; i < Freq; i += SymPerWord)
+		{
+			memcpy(Linear + Pos + i, &Val, sizeof(u64));
+		}
+
+		Pos += Freq;
+	}
+	Assert(Pos == L);
+
+	u32 Position = 0;
+	for (u32 i = 0; i < L; i += 2)
+	{
+		Spread[Position] = Linear[i];
+		Spread[(Position + Step) & Mask] = Linear[i + 1];
+		Position = (Position + 2 * Step) & Mask;
+	}
+	Assert(Position == 0);
+}
+
+template<typename SymT> inline void
+TansSpreadSymbols(SymT* Spread, u32 TableLog, const u16* NormFreq, u32 AlphSymCount)
+{
+	SymT Linear[(1 << TANS_MAX_TABLE_LOG) + sizeof(u64) / sizeof(SymT)];
+	TansSpreadSymbols(Spread, Linear, TableLog, NormFreq, AlphSymCount);
+}
+
+// Scratch of one table build, owned by caller so builds can run on many threads without big stack frames
+template<u32 AlphSize>
+struct tans_build_workspace
+{
+	using sym_type = ans_sym_type<AlphSize>;
+
+	sym_type Linear[(1 << TANS_MAX_TABLE_LOG) + sizeof(u64) / sizeof(sym_type)];
+	sym_type Spread[1 << TANS_MAX_TABLE_LOG];
+	u32 NextState[AlphSize];
+	u32 StateBase[AlphSize];
+};
+
+// builds both tables from one spread in one pass over states
+template<u32 AlphSize> void
+TansBuildTables(tans_build_workspace<AlphSize>& Workspace,
+				TansEncTableAlph<AlphSize>& EncTable, typename TansEncTableAlph<AlphSize>::entry* EncEntriesMem, u16* EncStatesMem,
+				TansDecTableAlph<AlphSize>& DecTable, typename TansDecTableAlph<AlphSize>::entry* DecEntriesMem,
+				u32 TableLog, const u16* NormFreq, u32 AlphSymCount = AlphSize)
+{
+	using sym_type = ans_sym_type<AlphSize>;
+	Assert(AlphSymCount <= AlphSize);
+
+	const u32 L = 1 << TableLog;
+
+	sym_type* Spread = Workspace.Spread;
+	TansSpreadSymbols(Spread, Workspace.Linear, TableLog, NormFreq, AlphSymCount);
+
+	EncTable.StateBits = DecTable.StateBits = TableLog;
+	EncTable.L = DecTable.L = L;
+	EncTable.Entries = EncEntriesMem;
+	EncTable.States = EncStatesMem;
+	DecTable.Entry = DecEntriesMem;
+
+	u32* NextState = Workspace.NextState;
+	u32* StateBase = Workspace.StateBase;
+
+	u32 Total = 0;
+	for (u32 SymIndex = 0; SymIndex < AlphSymCount; SymIndex++)
+	{
+		u32 Freq = NormFreq[SymIndex];
+		NextState[SymIndex] = Freq;
+		StateBase[SymIndex] = Total - Freq;
+
+		if (Freq)
+		{
+			u32 NumBits = TableLog - FindMostSignificantSetBit32(Freq - 1);
+			u32 MinStatePlus = Freq << NumBits;
+			EncEntriesMem[SymIndex].deltaNumBits = (NumBits << 16) - MinStatePlus;
+			EncEntriesMem[SymIndex].deltaState = Total - Freq;
+		}
+
+		Total += Freq;
+	}
+
+	for (u32 i = 0; i < L; i++)
+	{
+		sym_type Sym = Spread[i];
+		u32 FromState = NextState[Sym]++;
+		u32 Bits = TableLog - FindMostSignificantSetBit32(FromState);
+
+		if constexpr (sizeof(sym_type) == 1)
+		{
+			u32 Packed = ((FromState << Bits) - L) | (Bits << 16) | (static_cast<u32>(Sym) << 24);
+			memcpy(DecEntriesMem + i, &Packed, sizeof(Packed));
+		}
+		else
+		{
+			DecEntriesMem[i].Sym = Sym;
+			DecEntriesMem[i].Bits = Bits;
+			DecEntriesMem[i].NextState = (FromState << Bits) - L;
+		}
+
+		EncStatesMem[StateBase[Sym] + FromState] = static_cast<u16>(i);
+	}
+}
+
+template<u32 AlphSize> void
+TansBuildTables(TansEncTableAlph<AlphSize>& EncTable, typename TansEncTableAlph<AlphSize>::entry* EncEntriesMem, u16* EncStatesMem,
+				TansDecTableAlph<AlphSize>& DecTable, typename TansDecTableAlph<AlphSize>::entry* DecEntriesMem,
+				u32 TableLog, const u16* NormFreq, u32 AlphSymCount = AlphSize)
+{
+	tans_build_workspace<AlphSize> Workspace;
+	TansBuildTables(Workspace, EncTable, EncEntriesMem, EncStatesMem, DecTable, DecEntriesMem, TableLog, NormFreq, AlphSymCount);
+}
+
+inline u64
+TansNormFreqHash(const u16* NormFreq, u32 TableLog, u32 AlphSymCount = 256)
+{
+	// FNV-1a over frequencies
+	u64 Result = 0xcbf29ce484222325ull ^ TableLog;
+	for (u32 i = 0; i < AlphSymCount; i++)
+	{
+		Result = (Result ^ NormFreq[i]) * 0x100000001b3ull;
+	}
+
+	return Result;
+}
+
+// Small LRU of built enc/dec tables, identical normalized frequencies across blocks reuse the table.
+// Hash only selects candidates, frequencies are compared exactly.
+struct TansTableCache
+{
+	struct entry
+	{
+		u64 Hash;
+		u64 LastUse;
+		u32 TableLog;
+		b32 Valid;
+		u16 NormFreq[256];
+
+		TansEncTable Enc;
+		TansDecTable Dec;
+		std::vector<TansEncTable::entry> EncEntriesMem;
+		std::vector<u16> EncStatesMem;
+		std::vector<TansDecTable::entry> DecEntriesMem;
+	};
+
+	std::vector<entry> Entries;
+	std::vector<tans_build_workspace<256>> BuildWorkspace;
+	u64 UseCounter;
+	u64 Hits;
+	u64 Misses;
+
+	TansTableCache() : UseCounter(0), Hits(0), Misses(0) {}
+
+	void init(u32 Capacity, u32 MaxTableLog = TANS_CACHE_MAX_TABLE_LOG)
+	{
+		Assert(Capacity);
+		Assert(MaxTableLog <= TANS_MAX_TABLE_LOG);
+
+		Entries.resize(Capacity);
+		BuildWorkspace.resize(1);
+		for (entry& Entry : Entries)
+		{
+			Entry.Valid = false;
+			Entry.EncEntriesMem.resize(256);
+			Entry.EncStatesMem.resize(1 << MaxTableLog);
+			Entry.DecEntriesMem.resize(1 << MaxTableLog);
+		}
+
+		UseCounter = Hits = Misses = 0;
+	}
+
+	entry* get(const u16* NormFreq, u32 TableLog, u32 AlphSymCount = 256)
+	{
+		Assert(AlphSymCount <= 256);
+		Assert((1u << TableLog) <= Entries[0].DecEntriesMem.size());
+
+		u64 Hash = TansNormFreqHash(NormFreq, TableLog, AlphSymCount);
+		UseCounter++;
+
+		entry* Victim = &Entries[0];
+		for (entry& Entry : Entries)
+		{
+			if (Entry.Valid && (Entry.Hash == Hash) && (Entry.TableLog == TableLog) && isSameFreq(Entry, NormFreq, AlphSymCount))
+			{
+				Entry.LastUse = UseCounter;
+				Hits++;
+				return &Entry;
+			}
+
+			if (!Entry.Valid || (Victim->Valid && (Entry.LastUse < Victim->LastUse)))
+			{
+				Victim = &Entry;
+			}
+		}
+
+		Misses++;
+
+		Victim->Hash = Hash;
+		Victim->LastUse = UseCounter;
+		Victim->TableLog = TableLog;
+		Victim->Valid = true;
+		ZeroSize(Victim->NormFreq, sizeof(Victim->NormFreq));
+		MemCopy(AlphSymCount * sizeof(u16), Victim->NormFreq, const_cast<u16*>(NormFreq));
+
+		TansBuildTables(BuildWorkspace[0], Victim->Enc, Victim->EncEntriesMem.data(), Victim->EncStatesMem.data(),
+						Victim->Dec, Victim->DecEntriesMem.data(), TableLog, NormFreq, AlphSymCount);
+
+		return Victim;
+	}
+
+private:
+	b32 isSameFreq(const entry& Entry, const u16* NormFreq, u32 AlphSymCount)
+	{
+		for (u32 i = 0; i < AlphSymCount; i++)
+		{
+			if (Entry.NormFreq[i] != NormFreq[i]) return false;
+		}
+
+		for (u32 i = AlphSymCount; i < 256; i++)
+		{
+			if (Entry.NormFreq[i]) return false;
+		}
+
+		return true;
+	}
+};
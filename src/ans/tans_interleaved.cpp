@@ -0,0 +1,124 @@
+static constexpr u32 TANS_INTERLEAVED_MAX_BITS = 56;
+
+static_assert(sizeof(TansDecTable::entry) == sizeof(u32), "tANS decode entry must be packed in 32 bit");
+
+// NOTE: little endian layout of TansDecTable::entry - NextState | Bits << 16 | Sym << 24
+inline u32
+TansLoadDecEntry(const TansDecTable::entry* Entry)
+{
+	u32 Result;
+	memcpy(&Result, Entry, sizeof(Result));
+	return Result;
+}
+
+// N states over one bit stream, symbol i is coded by state i % N.
+// Decoder refills once per N symbols while N * TableLog fits in refill guarantee of BitReaderReverseFast,
+// larger tables (4 states of 15-16 bits) refill after every state.
+template<u32 StateCount>
+struct TansInterleaved
+{
+	static_assert((StateCount == 2) || (StateCount == 4), "tANS interleave supports 2 or 4 states");
+
+	TansState State[StateCount];
+
+	u64 encode(u8* Out, u64 OutSize, const u8* Data, u64 Size, const TansEncTable& Table)
+	{
+		BitWriter Writer(Out, OutSize);
+
+		for (u32 k = 0; k < StateCount; k++)
+		{
+			State[k].State = Table.L;
+		}
+
+		u64 i = Size;
+		u64 TailStart = Size - (Size % StateCount);
+		for (; i > TailStart; i--)
+		{
+			State[(i - 1) % StateCount].encode(Writer, Table, Data[i - 1]);
+		}
+
+		for (; i > 0; i -= StateCount)
+		{
+			const u8* Group = Data + i - StateCount;
+			for (u32 k = StateCount; k > 0; k--)
+			{
+				State[k - 1].encode(Writer, Table, Group[k - 1]);
+			}
+		}
+
+		for (u32 k = StateCount; k > 0; k--)
+		{
+			Writer.writeMaskMSB(State[k - 1].State, Table.StateBits);
+		}
+
+		u64 Result = Writer.finishReverse();
+		return Result;
+	}
+
+	template<b32 RefillEachState> inline void
+	decodeGroups(u8* Dest, u64 GroupCount, u32* CurrState, BitReaderReverseFast& Reader, const TansDecTable::entry* Entry)
+	{
+		for (u64 i = 0; i < GroupCount; i++)
+		{
+			for (u32 k = 0; k < StateCount; k++)
+			{
+				u32 Packed = TansLoadDecEntry(Entry + CurrState[k]);
+				u32 Bits = (Packed >> 16) & 0xff;
+
+				CurrState[k] = (Packed & 0xffff) + static_cast<u32>(Reader.peek(Bits));
+				Reader.consume(Bits);
+				if (RefillEachState) Reader.refill();
+
+				*Dest++ = static_cast<u8>(Packed >> 24);
+			}
+
+			if (!RefillEachState) Reader.refill();
+		}
+	}
+
+	// returns false if stream wasn't consumed exactly
+	b32 decode(u8* Dest, u64 Size, u8* In, u64 InSize, const TansDecTable& Table)
+	{
+		BitReaderReverseFast Reader(In, InSize);
+
+		u32 CurrState[StateCount];
+		for (u32 k = 0; k < StateCount; k++)
+		{
+			CurrState[k] = Reader.getBits(Table.StateBits);
+			Reader.refill();
+		}
+
+		const TansDecTable::entry* Entry = Table.Entry;
+
+		u64 GroupCount = Size / StateCount;
+		if ((Table.StateBits * StateCount) <= TANS_INTERLEAVED_MAX_BITS)
+		{
+			decodeGroups<false>(Dest, GroupCount, CurrState, Reader, Entry);
+		}
+		else
+		{
+			decodeGroups<true>(Dest, GroupCount, CurrState, Reader, Entry);
+		}
+		Dest += GroupCount * StateCount;
+
+		for (u32 k = 0; k < (Size % StateCount); k++)
+		{
+			u32 Packed = TansLoadDecEntry(Entry + CurrState[k]);
+			u32 Bits = (Packed >> 16) & 0xff;
+
+			CurrState[k] = (Packed & 0xffff) + static_cast<u32>(Reader.peek(Bits));
+			Reader.consume(Bits);
+			Reader.refill();
+
+			*Dest++ = static_cast<u8>(Packed >> 24);
+		}
+
+		for (u32 k = 0; k < StateCount; k++)
+		{
+			State[k].State = CurrState[k];
+		}
+
+		b32 Result = Reader.isFinished();
+		return Result;
+	}
+};
@@ -4,8 +4,20 @@
 #include "ans/rans8.cpp"
 #include "ans/rans16.cpp"
 #include "ans/rans32.cpp"
+#include "ans/rans_interleaved.cpp"
 #include "ans/tans.cpp"
+#include "ans/tans_interleaved.cpp"
+#include "ans/tans_build.cpp"
 #include "ans/static_basic_stats.cpp"
+#include "ans/block_split.cpp"
+#include "ans/rans_adaptive.cpp"
+#include "ans/rans_nibble.cpp"
+#include "ans/rans_alias.cpp"
+#include "ans/rans_block.cpp"
+#include "ans/rans_split.cpp"
+#include "ans/rans_batch.cpp"
+#include "ans/codec_select.cpp"
+#include "bwt/bwt.cpp"
 
 static constexpr u32 RANS_PROB_BIT = 12;
 static constexpr u32 RANS_PROB_SCALE = 1 << RANS_PROB_BIT;
@@ -13,6 +25,93 @@ static constexpr u32 RANS_PROB_SCALE = 1 << RANS_PROB_BIT;
 static constexpr u32 TANS_PROB_BITS = 12;
 static constexpr u32 TANS_PROB_SCALE = 1 << TANS_PROB_BITS;
 
+void
+TestByteHistogram(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+
+	Timer Timer;
+	AccumTime Accum;
+
+	u32 RefFreq[256] = {};
+	u32 Freq[256];
+
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		ZeroSize(RefFreq, sizeof(RefFreq));
+
+		Timer.start();
+		CountByte(RefFreq, InputFile.Data, InputFile.Size);
+		Timer.end();
+		Accum.update(Timer);
+	}
+
+	printf(" single table\n");
+	PrintAvgPerSymbolPerfStats(Accum, RUNS_COUNT, InputFile.Size);
+	Accum.reset();
+
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		ZeroSize(Freq, sizeof(Freq));
+
+		Timer.start();
+		CountByteFast(Freq, InputFile.Data, InputFile.Size);
+		Timer.end();
+		Accum.update(Timer);
+
+		for (u32 i = 0; i < 256; i++) Assert(Freq[i] == RefFreq[i]);
+	}
+
+	printf(" %u sub tables\n", HISTO_SUB_TABLES);
+	PrintAvgPerSymbolPerfStats(Accum, RUNS_COUNT, InputFile.Size);
+	Accum.reset();
+
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		ZeroSize(Freq, sizeof(Freq));
+
+		Timer.start();
+		CountByteParallel(Freq, InputFile.Data, InputFile.Size);
+		Timer.end();
+		Accum.update(Timer);
+
+		for (u32 i = 0; i < 256; i++) Assert(Freq[i] == RefFreq[i]);
+	}
+
+	printf(" parallel (min %lu bytes per thread)\n", HISTO_PARALLEL_MIN_SIZE);
+	PrintAvgPerSymbolPerfStats(Accum, RUNS_COUNT, InputFile.Size);
+	Accum.reset();
+
+	u64 SampleCount = 0;
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		ZeroSize(Freq, sizeof(Freq));
+
+		Timer.start();
+		SampleCount = CountByteSampled(Freq, InputFile.Data, InputFile.Size);
+		Timer.end();
+		Accum.update(Timer);
+	}
+
+	f64 SampledH = Entropy(Freq, 256);
+	f64 FullH = Entropy(RefFreq, 256);
+	printf(" sampled %lu bytes H:%.3f (full H:%.3f)\n", SampleCount, SampledH, FullH);
+	PrintAvgPerSymbolPerfStats(Accum, RUNS_COUNT, InputFile.Size);
+
+	// sample sizes below two chunks take one chunk
+	for (u32 SampleSize : {0u, HISTO_SAMPLE_CHUNK - 1, 2 * HISTO_SAMPLE_CHUNK - 1})
+	{
+		ZeroSize(Freq, sizeof(Freq));
+		u64 Expected = InputFile.Size < HISTO_SAMPLE_CHUNK ? InputFile.Size : HISTO_SAMPLE_CHUNK;
+		if (InputFile.Size <= SampleSize) Expected = InputFile.Size;
+
+		SampleCount = CountByteSampled(Freq, InputFile.Data, InputFile.Size, SampleSize);
+		u64 Counted = 0;
+		for (u32 i = 0; i < 256; i++) Counted += Freq[i];
+		Verify((SampleCount == Expected) && (Counted == Expected));
+	}
+}
+
 void
 TestBasicRans8(file_data& InputFile)
 {
@@ -649,6 +748,157 @@ TestTableInterleavedRans32(file_data& InputFile)
 	PrintAvgPerSymbolPerfStats(Accum, RUNS_COUNT, InputFile.Size);
 }
 
+template<typename StateT, u32 Lanes, u32 ScaleBit> static void
+RunInterleavedRans(file_data& InputFile)
+{
+	typedef rans_interleaved<StateT, Lanes, ScaleBit> coder;
+	typedef typename coder::word word;
+
+	Timer Timer;
+
+	std::vector<word> OutBuff(coder::bound(InputFile.Size));
+	std::vector<u8> DecBuff(InputFile.Size);
+
+	SymbolStats Stats;
+	Stats.countSymbol(InputFile.Data, InputFile.Size);
+	Stats.optimalNormalize(coder::SCALE);
+
+	std::vector<rans_sym_table<coder::SCALE>> Tab(1);
+	for (u32 i = 0; i < 256; i++)
+	{
+		RansTableInitSym(Tab[0], i, Stats.CumFreq[i], Stats.Freq[i]);
+	}
+
+	word* OutEnd = OutBuff.data() + OutBuff.size();
+	word* DecodeBegin = nullptr;
+
+	AccumTime EncAccum;
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		Timer.start();
+		DecodeBegin = coder::encode(OutEnd, InputFile.Data, InputFile.Size, Stats.CumFreq, Stats.Freq);
+		Timer.end();
+		EncAccum.update(Timer);
+	}
+
+	AccumTime DecAccum;
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		Timer.start();
+		const word* DecodeEnd = coder::decode(DecBuff.data(), InputFile.Size, DecodeBegin, Tab[0]);
+		Timer.end();
+		DecAccum.update(Timer);
+
+		Verify(DecodeEnd == OutEnd);
+		Assert(!memcmp(DecBuff.data(), InputFile.Data, InputFile.Size));
+	}
+
+	printf(" %s state, %u lanes, %u bit scale\n", sizeof(StateT) == 4 ? "u32" : "u64", Lanes, ScaleBit);
+	printf(" encode");
+	PrintAvgPerSymbolPerfStats(EncAccum, RUNS_COUNT, InputFile.Size);
+	printf(" decode");
+	PrintAvgPerSymbolPerfStats(DecAccum, RUNS_COUNT, InputFile.Size);
+	PrintCompressionSize(InputFile.Size, (OutEnd - DecodeBegin) * sizeof(word));
+}
+
+template<typename StateT, u32 ScaleBit> static void
+RunInterleavedRansLanes(file_data& InputFile)
+{
+	RunInterleavedRans<StateT, 1, ScaleBit>(InputFile);
+	RunInterleavedRans<StateT, 2, ScaleBit>(InputFile);
+	RunInterleavedRans<StateT, 4, ScaleBit>(InputFile);
+	RunInterleavedRans<StateT, 8, ScaleBit>(InputFile);
+}
+
+void
+TestInterleavedRansSweep(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+
+	RunInterleavedRansLanes<u32, 11>(InputFile);
+	RunInterleavedRansLanes<u32, 14>(InputFile);
+	RunInterleavedRansLanes<u64, 12>(InputFile);
+	RunInterleavedRansLanes<u64, 15>(InputFile);
+}
+
+void
+TestBwtRans32(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+
+	if (InputFile.Size >= MaxUInt32)
+	{
+		printf("File to big for _TestBwtRans32_\n");
+		return;
+	}
+
+	Timer Timer;
+
+	// inverse BWT alone on first block
+	{
+		u32 n = InputFile.Size < BwtDefaultParams().BlockSize ? static_cast<u32>(InputFile.Size) : BwtDefaultParams().BlockSize;
+		std::vector<s32> SA(n);
+		std::vector<u8> Block(n);
+		std::vector<u8> DecBuff(n);
+		std::vector<u32> Vec(n + 1ull);
+		u32 WalkStart[BWT_WALK_COUNT];
+
+		Timer.start();
+		BwtForward(InputFile.Data, Block.data(), n, SA.data(), WalkStart);
+		Timer.end();
+
+		printf(" BWT forward");
+		PrintSymbolEncPerfStats(Timer.Clock, Timer.Time, n);
+
+		AccumTime Accum;
+		for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+		{
+			Timer.start();
+			BwtInverse(Block.data(), DecBuff.data(), n, WalkStart, Vec.data());
+			Timer.end();
+			Accum.update(Timer);
+
+			Assert(!memcmp(DecBuff.data(), InputFile.Data, n));
+		}
+
+		printf(" BWT inverse, %u walks", BWT_WALK_COUNT);
+		PrintAvgPerSymbolPerfStats(Accum, RUNS_COUNT, n);
+	}
+
+	std::vector<u32> CompBuff;
+	std::vector<u8> DecBuff(InputFile.Size);
+
+	for (u32 ContextCount : {1u, BWT_MAX_CONTEXTS})
+	{
+		bwt_params Params = BwtDefaultParams();
+		Params.ContextCount = ContextCount;
+
+		Timer.start();
+		BwtCompress(InputFile.Data, InputFile.Size, CompBuff, Params);
+		Timer.end();
+
+		printf(" BWT + MTF/RLE0 + rANS %s\n", ContextCount == 1 ? "order-0" : "order-1 bucketed");
+		printf(" encode");
+		PrintSymbolEncPerfStats(Timer.Clock, Timer.Time, InputFile.Size);
+
+		AccumTime Accum;
+		for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+		{
+			Timer.start();
+			u64 DecodedSize = BwtDecompress(DecBuff.data(), DecBuff.size(), CompBuff.data(), CompBuff.size());
+			Timer.end();
+			Accum.update(Timer);
+
+			Verify(DecodedSize == InputFile.Size);
+			Assert(!memcmp(DecBuff.data(), InputFile.Data, InputFile.Size));
+		}
+
+		printf(" decode");
+		PrintAvgPerSymbolPerfStats(Accum, RUNS_COUNT, InputFile.Size);
+		PrintCompressionSize(InputFile.Size, CompBuff.size() * sizeof(u32));
+	}
+}
+
 #define Check4SymDecBuff(Buff, i) ((u32)(Buff[(i)] | (Buff[(i) + 1] << 8) | (Buff[(i) + 2] << 16) | (Buff[(i) + 3] << 24)))
 
 void
@@ -796,6 +1046,128 @@ DecodeRans32(u8* RefData, u32 RefSize, u8* DecBuff, u32* DecodeBegin, u16* Freq,
 	}
 }
 
+template<u32 Groups> static void
+RunBatchDecodeRans16(const rans_sym_table<RANS_PROB_SCALE>& Tab, const u16* Base, const std::vector<rans_batch_msg>& Msgs,
+					 const u8* Ref, u64 Size, std::vector<u8>& DecBuff)
+{
+	Timer Timer;
+	AccumTime Accum;
+
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		ZeroSize(DecBuff.data(), Size);
+
+		Timer.start();
+		Rans16DecodeBatch<Groups, RANS_PROB_BIT>(Tab, Base, Msgs.data(), static_cast<u32>(Msgs.size()));
+		Timer.end();
+		Accum.update(Timer);
+
+		Verify(!memcmp(DecBuff.data(), Ref, Size));
+	}
+
+	printf(" batch decode, %u lanes", 4 * Groups);
+	PrintAvgPerSymbolPerfStats(Accum, RUNS_COUNT, Size);
+}
+
+void
+TestBatchDecodeRans16(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+	Timer Timer;
+
+	SymbolStats Stats;
+	Stats.countSymbol(InputFile.Data, InputFile.Size);
+	Stats.optimalNormalize(RANS_PROB_SCALE);
+
+	rans_sym_table<RANS_PROB_SCALE> Tab;
+	for (u32 i = 0; i < 256; i++)
+	{
+		RansTableInitSym(Tab, i, Stats.CumFreq[i], Stats.Freq[i]);
+	}
+
+	std::vector<u8> DecBuff(InputFile.Size);
+
+	// message sizes spread over 100 B - 2 KB
+	std::vector<rans_batch_msg> Msgs;
+	u32 Seed = 0x2545F491;
+	for (u64 Start = 0; Start < InputFile.Size;)
+	{
+		Seed ^= Seed << 13;
+		Seed ^= Seed >> 17;
+		Seed ^= Seed << 5;
+
+		u64 Size = 100 + Seed % (2048 - 100 + 1);
+		Size = Size < (InputFile.Size - Start) ? Size : (InputFile.Size - Start);
+
+		rans_batch_msg Msg = {};
+		Msg.Size = static_cast<u32>(Size);
+		Msg.Dest = DecBuff.data() + Start;
+		Msgs.push_back(Msg);
+
+		Start += Size;
+	}
+
+	// every message is plain Rans16Enc stream, packed one after other
+	std::vector<u16> Batch;
+	std::vector<u16> Scratch(2 * 2048 + 16);
+	const u8* Data = InputFile.Data;
+
+	for (rans_batch_msg& Msg : Msgs)
+	{
+		u64 Start = Msg.Dest - DecBuff.data();
+		u16* Out = Scratch.data() + Scratch.size();
+
+		Rans16Enc Encoder;
+		Encoder.init();
+		for (u64 i = Start + Msg.Size; i > Start; i--)
+		{
+			u8 Symbol = Data[i - 1];
+			Encoder.encode(&Out, Stats.CumFreq[Symbol], Stats.Freq[Symbol], RANS_PROB_BIT);
+		}
+		Encoder.flush(&Out);
+
+		Msg.InOffset = static_cast<u32>(Batch.size());
+		Batch.insert(Batch.end(), Out, Scratch.data() + Scratch.size());
+	}
+
+	u64 CompressedSize = Batch.size() * sizeof(u16);
+	Batch.resize(Batch.size() + RANS_BATCH_READ_PAD);
+
+	printf(" %lu messages\n", Msgs.size());
+	PrintCompressionSize(InputFile.Size, CompressedSize);
+
+	AccumTime Accum;
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		ZeroSize(DecBuff.data(), InputFile.Size);
+
+		Timer.start();
+		for (const rans_batch_msg& Msg : Msgs)
+		{
+			u16* In = Batch.data() + Msg.InOffset;
+
+			Rans16Dec Decoder;
+			Decoder.init(&In);
+			for (u32 i = 0; i < Msg.Size; i++)
+			{
+				Msg.Dest[i] = Decoder.decodeSym(Tab, RANS_PROB_SCALE, RANS_PROB_BIT);
+				Decoder.decodeRenorm(&In);
+			}
+		}
+		Timer.end();
+		Accum.update(Timer);
+
+		Assert(!memcmp(DecBuff.data(), InputFile.Data, InputFile.Size));
+	}
+
+	printf(" per message decode");
+	PrintAvgPerSymbolPerfStats(Accum, RUNS_COUNT, InputFile.Size);
+
+	RunBatchDecodeRans16<1>(Tab, Batch.data(), Msgs, InputFile.Data, InputFile.Size, DecBuff);
+	RunBatchDecodeRans16<2>(Tab, Batch.data(), Msgs, InputFile.Data, InputFile.Size, DecBuff);
+	RunBatchDecodeRans16<4>(Tab, Batch.data(), Msgs, InputFile.Data, InputFile.Size, DecBuff);
+}
+
 void
 TestNormalizationRans32(file_data& InputFile)
 {
@@ -872,8 +1244,44 @@ TestNormalizationRans32(file_data& InputFile)
 		printf("(optm) ");
 		PrintCompressionSize(InputFile.Size, CompressedSizeOpt);
 
+		// optimal normalize without allocation
+		ZeroSize(NormFreq, sizeof(NormFreq));
+		ZeroSize(CumFreq, sizeof(CumFreq));
+
+		OptimalNormalizeFast(RawFreq, NormFreq, TotalSum, 256, ProbScale);
+		CalcCumFreq(NormFreq, CumFreq, 256);
+
+		DecodeBegin = EncodeRans32(Out, InputFile.Data, InputFile.Size, NormFreq, CumFreq, ProbBit);
+
+		u64 CompressedSizeOptFast = (OutBuff.data() + BuffSize) - reinterpret_cast<u8*>(DecodeBegin);
+		DecodeRans32(InputFile.Data, InputFile.Size, DecBuff.data(), DecodeBegin, NormFreq, CumFreq, ProbBit); // decode ok?
+
+		printf("(optf) ");
+		PrintCompressionSize(InputFile.Size, CompressedSizeOptFast);
+
 		printf("\n");
 	}
+
+	// table build cost matters when normalization runs per block
+	static constexpr u32 NormRunsCount = 1 << 10;
+	Timer Timer;
+	AccumTime AccumOpt, AccumOptFast;
+
+	for (u32 Run = 0; Run < NormRunsCount; Run++)
+	{
+		Timer.start();
+		OptimalNormalize(RawFreq, NormFreq, TotalSum, 256, TANS_PROB_SCALE);
+		Timer.end();
+		AccumOpt.update(Timer);
+
+		Timer.start();
+		OptimalNormalizeFast(RawFreq, NormFreq, TotalSum, 256, TANS_PROB_SCALE);
+		Timer.end();
+		AccumOptFast.update(Timer);
+	}
+
+	printf("normalize to %d: (optm) %.0f clocks, (optf) %.0f clocks per call\n", TANS_PROB_SCALE,
+		(f64)AccumOpt.Clock / NormRunsCount, (f64)AccumOptFast.Clock / NormRunsCount);
 }
 
 using freq_val_o1 = array2d<u32, 256, 256>;
@@ -1075,28 +1483,297 @@ TestPrecomputeAdaptiveOrder1Rans32(file_data& InputFile)
 	delete MixCDF;
 }
 
-void
-TansSortSymBitReverse(u8* SortedSym, u32 SortCount, const u16* NormFreq, u32 AlphSymCount = 256)
+static u32*
+EncodeBlocksRans32(u32* Out, u8* Data, const std::vector<split_block>& Blocks)
 {
-	u32 SymbolCounter = 0;
-	for (u32 Sym = 0; Sym < AlphSymCount; Sym++)
+	SymbolStats Stats;
+	rans_enc_sym64 EncSymArr[256];
+	u32 HeaderWords[1 + FreqTableBitmapWords + 128];
+
+	for (u64 BlockIndex = Blocks.size(); BlockIndex > 0; BlockIndex--)
 	{
-		u16 Freq = NormFreq[Sym];
-		for (u32 Count = 0; Count < Freq; Count++)
+		const split_block& Block = Blocks[BlockIndex - 1];
+		u8* BlockData = Data + Block.Start;
+
+		Stats.countSymbol(BlockData, Block.Size);
+		Stats.optimalNormalize(RANS_PROB_SCALE);
+
+		for (u32 i = 0; i < 256; i++)
 		{
-			u32 ReverseCounter = BitReverseSlow(SymbolCounter++, TANS_PROB_BITS);
-			SortedSym[ReverseCounter] = Sym;
+			RansEncSymInit(&EncSymArr[i], Stats.CumFreq[i], Stats.Freq[i], RANS_PROB_BIT);
 		}
-	}
 
-	Assert(SymbolCounter == SortCount);
-}
+		Rans32Enc Encoder;
+		Encoder.init();
 
-void
-TansRadix8SortToBuffer(u8* SortedSym, u32 SortCount, const u16* NormFreq, u32 AlphSymCount = 256)
-{
-	const u32 RadixNumber = 255 << 8;
-	//const u32 RadixNumber = (256 << 8) - 1;
+		for (u64 i = Block.Size; i > 0; i--)
+		{
+			u8 Symbol = BlockData[i - 1];
+			Encoder.encode(&Out, &EncSymArr[Symbol], RANS_PROB_BIT);
+		}
+		Encoder.flush(&Out);
+
+		Assert(Block.Size <= MaxUInt32);
+		HeaderWords[0] = static_cast<u32>(Block.Size);
+		u32 HeaderCount = 1 + WriteFreqTable(HeaderWords + 1, Stats.Freq);
+
+		Out -= HeaderCount;
+		MemCopy(sizeof(u32) * HeaderCount, Out, HeaderWords);
+	}
+
+	return Out;
+}
+
+static void
+DecodeBlocksRans32(u64 Size, u8* DecBuff, u32* DecodeBegin)
+{
+	SymbolStats Stats;
+	rans_sym_table<RANS_PROB_SCALE> Tab;
+
+	u32* In = DecodeBegin;
+
+	u64 ByteIndex = 0;
+	while (ByteIndex < Size)
+	{
+		u32 BlockSize = *In++;
+		In += ReadFreqTable(Stats.Freq, In);
+		CalcCumFreq(Stats.Freq, Stats.CumFreq, 256);
+
+		for (u32 i = 0; i < 256; i++)
+		{
+			RansTableInitSym(Tab, i, Stats.CumFreq[i], Stats.Freq[i]);
+		}
+
+		Rans32Dec Decoder;
+		Decoder.init(&In);
+
+		for (u64 End = ByteIndex + BlockSize; ByteIndex < End; ByteIndex++)
+		{
+			u8 Symbol = Decoder.decodeSym(Tab, RANS_PROB_SCALE, RANS_PROB_BIT);
+
+			DecBuff[ByteIndex] = Symbol;
+			Decoder.decodeRenorm(&In);
+		}
+	}
+}
+
+void
+TestBlockSplitRans32(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+
+	Timer Timer;
+
+	std::vector<split_block> GlobalBlocks;
+	std::vector<split_block> FixedBlocks;
+	std::vector<split_block> SplitBlocks;
+
+	FixedBlockSplits(GlobalBlocks, InputFile.Size, InputFile.Size);
+	FixedBlockSplits(FixedBlocks, InputFile.Size, 1 << 16);
+
+	Timer.start();
+	FindBlockSplits(SplitBlocks, InputFile.Data, InputFile.Size);
+	Timer.end();
+
+	printf(" split search - %lu clocks, %0.6f ms\n", Timer.Clock, Timer.Time * 1000.0);
+
+	std::vector<split_block>* BlockSets[] = { &GlobalBlocks, &FixedBlocks, &SplitBlocks };
+	const char* BlockSetNames[] = { "global", "fixed64K", "adaptive" };
+
+	for (u32 SetIndex = 0; SetIndex < ArrayCount(BlockSets); SetIndex++)
+	{
+		std::vector<split_block>& Blocks = *BlockSets[SetIndex];
+
+		u64 HeaderMaxSize = Blocks.size() * sizeof(u32) * (SplitBlockOverheadWords + FreqTableBitmapWords + 128);
+		u64 BuffSize = AlignSizeForward(InputFile.Size + (InputFile.Size >> 3) + HeaderMaxSize);
+		std::vector<u8> OutBuff(BuffSize);
+		std::vector<u8> DecBuff(InputFile.Size);
+
+		u32* Out = reinterpret_cast<u32*>(OutBuff.data() + BuffSize);
+		u32* DecodeBegin = EncodeBlocksRans32(Out, InputFile.Data, Blocks);
+
+		u64 CompressedSize = (OutBuff.data() + BuffSize) - reinterpret_cast<u8*>(DecodeBegin);
+
+		Timer.start();
+		DecodeBlocksRans32(InputFile.Size, DecBuff.data(), DecodeBegin);
+		Timer.end();
+
+		Verify(!memcmp(DecBuff.data(), InputFile.Data, InputFile.Size));
+
+		printf(" (%s) blocks %lu", BlockSetNames[SetIndex], Blocks.size());
+		PrintCompressionSize(InputFile.Size, CompressedSize);
+		PrintSymbolEncPerfStats(Timer.Clock, Timer.Time, InputFile.Size);
+	}
+
+	printf("\n");
+}
+
+void
+TestSplitDecodeRans32(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+
+	if (InputFile.Size >= MaxUInt32)
+	{
+		printf("File to big for _TestSplitDecodeRans32_\n");
+		return;
+	}
+
+	Timer Timer;
+
+	u64 BuffSize = AlignSizeForward(InputFile.Size + InputFile.Size / 2 + 1024);
+	std::vector<u8> OutBuff(BuffSize);
+	std::vector<u8> BlockBuff(BuffSize);
+	std::vector<u8> DecBuff(InputFile.Size);
+
+	SymbolStats Stats;
+	Stats.countSymbol(InputFile.Data, InputFile.Size);
+	Stats.optimalNormalize(RANS_PROB_SCALE);
+
+	rans_enc_sym64 EncSym[256];
+	rans_sym_table<RANS_PROB_SCALE> Tab;
+	for (u32 i = 0; i < 256; i++)
+	{
+		RansEncSymInit(&EncSym[i], Stats.CumFreq[i], Stats.Freq[i], RANS_PROB_BIT);
+		RansTableInitSym(Tab, i, Stats.CumFreq[i], Stats.Freq[i]);
+	}
+
+	u32 MaxThreadCount = std::thread::hardware_concurrency();
+	MaxThreadCount = MaxThreadCount ? MaxThreadCount : 1;
+
+	for (u32 Interval : {1u << 14, 1u << 16})
+	{
+		u32* OutEnd = reinterpret_cast<u32*>(OutBuff.data() + BuffSize);
+
+		rans_split_index Index;
+		u32* Begin = Rans32EncodeSplit<RANS_PROB_BIT>(OutEnd, InputFile.Data, InputFile.Size, EncSym, Interval, Index);
+		u64 WordCount = OutEnd - Begin;
+
+		// same index from plain stream
+		rans_split_index Rebuilt;
+		Timer.start();
+		Rans32BuildSplitIndex<RANS_PROB_BIT>(Tab, Begin, InputFile.Size, Interval, Rebuilt);
+		Timer.end();
+
+		Assert(Rebuilt.Points.size() == Index.Points.size());
+		for (u64 i = 0; i < Index.Points.size(); i++)
+		{
+			Assert(Rebuilt.Points[i].State == Index.Points[i].State);
+			Assert(Rebuilt.Points[i].InOffset == Index.Points[i].InOffset);
+		}
+
+		std::vector<split_block> Blocks;
+		FixedBlockSplits(Blocks, InputFile.Size, Interval);
+		u32* BlockEnd = reinterpret_cast<u32*>(BlockBuff.data() + BuffSize);
+		u32* BlockBegin = EncodeBlocksRans32(BlockEnd, InputFile.Data, Blocks);
+
+		u64 StreamSize = WordCount * sizeof(u32);
+		u64 IndexSize = Rans32SplitIndexWords(Index) * sizeof(u32);
+		u64 BlocksSize = (BlockEnd - BlockBegin) * sizeof(u32);
+
+		printf(" interval %u, %lu split points\n", Interval, Index.Points.size());
+		printf(" stream %lu + index %lu bytes, independent blocks %lu bytes\n", StreamSize, IndexSize, BlocksSize);
+		printf(" index rebuild");
+		PrintSymbolEncPerfStats(Timer.Clock, Timer.Time, InputFile.Size);
+
+		for (u32 ThreadCount : {1u, MaxThreadCount})
+		{
+			AccumTime Accum;
+			for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+			{
+				Timer.start();
+				b32 Valid = Rans32DecodeSplit<RANS_PROB_BIT>(DecBuff.data(), InputFile.Size, Begin, WordCount, Tab, Index, ThreadCount);
+				Timer.end();
+				Accum.update(Timer);
+
+				Verify(Valid);
+				Assert(!memcmp(DecBuff.data(), InputFile.Data, InputFile.Size));
+			}
+
+			printf(" decode %u threads", ThreadCount);
+			PrintAvgPerSymbolPerfStats(Accum, RUNS_COUNT, InputFile.Size);
+		}
+	}
+}
+
+void
+TestAdaptiveRans8(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+	Timer Timer;
+
+	u64 BuffSize = InputFile.Size + (InputFile.Size >> 3) + 16;
+	std::vector<u8> OutBuff(BuffSize);
+	std::vector<u8> DecBuff(InputFile.Size);
+
+	u8* DecodeBegin = nullptr;
+	rans_adapt_rebuild_stats EncRebuild = {};
+	rans_adapt_rebuild_stats DecRebuild = {};
+
+	AccumTime Accum;
+	printf(" rANS encode (rebuild every %u symbols)\n", RANS_ADAPT_INTERVAL);
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		EncRebuild = {};
+
+		Timer.start();
+		DecodeBegin = RansAdaptiveEncode<RANS_PROB_BIT>(OutBuff.data() + BuffSize, InputFile.Data, InputFile.Size, &EncRebuild);
+		Timer.end();
+		Accum.update(Timer);
+	}
+
+	PrintAvgPerSymbolPerfStats(Accum, RUNS_COUNT, InputFile.Size);
+	Accum.reset();
+
+	u64 CompressedSize = (OutBuff.data() + BuffSize) - DecodeBegin;
+	PrintCompressionSize(InputFile.Size, CompressedSize);
+
+	printf(" rANS decode\n");
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		DecRebuild = {};
+
+		Timer.start();
+		RansAdaptiveDecode<RANS_PROB_BIT>(DecBuff.data(), InputFile.Size, DecodeBegin, &DecRebuild);
+		Timer.end();
+		Accum.update(Timer);
+
+		for (u64 i = 0; i < InputFile.Size; i++)
+		{
+			Assert(DecBuff[i] == InputFile.Data[i]);
+		}
+	}
+
+	PrintAvgPerSymbolPerfStats(Accum, RUNS_COUNT, InputFile.Size);
+
+	Assert(EncRebuild.SlotsRebuilt == DecRebuild.SlotsRebuilt);
+	u64 FullSlots = DecRebuild.RebuildCount * RANS_PROB_SCALE;
+	printf(" rebuilds %lu, symbols %lu, slots %lu (%.1f%% of full rebuild)\n", DecRebuild.RebuildCount,
+		DecRebuild.SymbolsRebuilt, DecRebuild.SlotsRebuilt, FullSlots ? 100.0 * DecRebuild.SlotsRebuilt / FullSlots : 0.0);
+}
+
+void
+TansSortSymBitReverse(u8* SortedSym, u32 SortCount, const u16* NormFreq, u32 AlphSymCount = 256)
+{
+	u32 SymbolCounter = 0;
+	for (u32 Sym = 0; Sym < AlphSymCount; Sym++)
+	{
+		u16 Freq = NormFreq[Sym];
+		for (u32 Count = 0; Count < Freq; Count++)
+		{
+			u32 ReverseCounter = BitReverseSlow(SymbolCounter++, TANS_PROB_BITS);
+			SortedSym[ReverseCounter] = Sym;
+		}
+	}
+
+	Assert(SymbolCounter == SortCount);
+}
+
+void
+TansRadix8SortToBuffer(u8* SortedSym, u32 SortCount, const u16* NormFreq, u32 AlphSymCount = 256)
+{
+	const u32 RadixNumber = 255 << 8;
+	//const u32 RadixNumber = (256 << 8) - 1;
 	u32 RadixHisto[256] = {};
 	u32 RadixSum = TansRadixSort8(RadixHisto, RadixNumber, NormFreq, AlphSymCount);
 
@@ -1118,6 +1795,89 @@ TansRadix8SortToBuffer(u8* SortedSym, u32 SortCount, const u16* NormFreq, u32 Al
 	}
 }
 
+// Raw compiler intrinsics, inputs are never 0 here so they are defined on every compiler
+inline u64
+BitScanMixRaw(u64 V)
+{
+	u64 Hi = V | (1ull << 63);
+	u64 Lo = V | 1;
+
+#if _MSC_VER
+	unsigned long Ctz32, Clz32, Ctz64, Clz64;
+	_BitScanForward(&Ctz32, static_cast<u32>(Hi >> 32));
+	_BitScanReverse(&Clz32, static_cast<u32>(Lo));
+	_BitScanForward64(&Ctz64, Hi);
+	_BitScanReverse64(&Clz64, Lo);
+	u64 Result = Ctz32 + Clz32 + Ctz64 + Clz64 + (_byteswap_uint64(V) >> 56) + (__umulh(V, 0x9E3779B97F4A7C15ull) >> 56);
+#else
+	u64 Result = __builtin_ctz(static_cast<u32>(Hi >> 32)) + (31 - __builtin_clz(static_cast<u32>(Lo))) +
+		__builtin_ctzll(Hi) + (63 - __builtin_clzll(Lo)) + (__builtin_bswap64(V) >> 56) +
+		(static_cast<u64>((static_cast<unsigned __int128>(V) * 0x9E3779B97F4A7C15ull) >> 64) >> 56);
+#endif
+	return Result;
+}
+
+inline u64
+BitScanMixWrapped(u64 V)
+{
+	u64 Hi = V | (1ull << 63);
+	u64 Lo = V | 1;
+
+	u64 Result = FindLeastSignificantSetBit32(static_cast<u32>(Hi >> 32)) + FindMostSignificantSetBit32(static_cast<u32>(Lo)) +
+		FindLeastSignificantSetBit64(Hi) + FindMostSignificantSetBit64(Lo) + (ByteSwap64(V) >> 56) + (MulHi64(V, 0x9E3779B97F4A7C15ull) >> 56);
+	return Result;
+}
+
+// common.h wrappers vs raw intrinsics, same results and same speed expected
+void
+TestBitScanIntrinsics(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+
+	u64 WordCount = InputFile.Size / sizeof(u64);
+	if (!WordCount) return;
+
+	std::vector<u64> Words(WordCount);
+	memcpy(Words.data(), InputFile.Data, WordCount * sizeof(u64));
+
+	Assert(!FindLeastSignificantSetBit32(0) && !FindMostSignificantSetBit32(0));
+	Assert(!FindLeastSignificantSetBit64(0) && !FindMostSignificantSetBit64(0));
+
+	Timer Timer;
+	AccumTime RawAccum;
+	AccumTime WrappedAccum;
+	u64 RawSum = 0;
+	u64 WrappedSum = 0;
+
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		RawSum = 0;
+		Timer.start();
+		for (u64 i = 0; i < WordCount; i++)
+		{
+			RawSum += BitScanMixRaw(Words[i]);
+		}
+		Timer.end();
+		RawAccum.update(Timer);
+
+		WrappedSum = 0;
+		Timer.start();
+		for (u64 i = 0; i < WordCount; i++)
+		{
+			WrappedSum += BitScanMixWrapped(Words[i]);
+		}
+		Timer.end();
+		WrappedAccum.update(Timer);
+	}
+
+	Assert(RawSum == WrappedSum);
+
+	printf(" raw intrinsics (sum %lu)\n", RawSum);
+	PrintAvgPerSymbolPerfStats(RawAccum, RUNS_COUNT, WordCount);
+	printf(" common.h wrappers (sum %lu)\n", WrappedSum);
+	PrintAvgPerSymbolPerfStats(WrappedAccum, RUNS_COUNT, WordCount);
+}
+
 template <b32 IsRadixSort = true> void
 TestBasicTans(file_data& InputFile)
 {
@@ -1340,7 +2100,7 @@ TestInterleavedTans(file_data& InputFile)
 		}
 		else
 		{
-			DecTable.init(DecEntriesMem.data(), TANS_PROB_BITS, SortedSym, NormFreq);
+			DecTable.init(DecEntriesMem.data(), TANS_PROB_BITS, SortedSym.data(), NormFreq);
 		}
 
 		Reader.refillTo(DecTable.StateBits);
@@ -1389,3 +2149,1348 @@ TestInterleavedTans(file_data& InputFile)
 	PrintAvgPerSymbolPerfStats(DecAccum, RUNS_COUNT, InputFile.Size);
 	PrintCompressionSize(InputFile.Size, TotalEncSize);
 }
+
+template<u32 StateCount> void
+TestInterleavedTansFast(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+
+	u64 OutSize = InputFile.Size + (InputFile.Size >> 3) + 64;
+	std::vector<u8> OutBuff(OutSize);
+	std::vector<u8> DecBuff(InputFile.Size);
+
+	u32 Freq[256] = {};
+	u16 NormFreq[256] = {};
+
+	CountByte(Freq, InputFile.Data, InputFile.Size);
+	OptimalNormalizeFast(Freq, NormFreq, InputFile.Size, 256, TANS_PROB_SCALE);
+
+	std::vector<TansEncTable::entry> EncEntriesMem(256);
+	std::vector<TansDecTable::entry> DecEntriesMem(TANS_PROB_SCALE);
+	std::vector<u16> TableMem(TANS_PROB_SCALE);
+
+	TansEncTable EncTable;
+	TansDecTable DecTable;
+	EncTable.initRadix(EncEntriesMem.data(), TANS_PROB_BITS, TableMem.data(), NormFreq);
+	DecTable.initRadix(DecEntriesMem.data(), TANS_PROB_BITS, NormFreq);
+
+	TansInterleaved<StateCount> Coder;
+
+	Timer Timer;
+	AccumTime EncAccum, DecAccum;
+
+	u64 TotalEncSize = 0;
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		Timer.start();
+		TotalEncSize = Coder.encode(OutBuff.data(), OutSize, InputFile.Data, InputFile.Size, EncTable);
+		Timer.end();
+		EncAccum.update(Timer);
+	}
+
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		Timer.start();
+		b32 Finished = Coder.decode(DecBuff.data(), InputFile.Size, OutBuff.data(), TotalEncSize, DecTable);
+		Timer.end();
+		DecAccum.update(Timer);
+
+		Verify(Finished);
+		for (u64 i = 0; i < InputFile.Size; i++)
+		{
+			Assert(DecBuff[i] == InputFile.Data[i]);
+		}
+	}
+
+	printf(" tANS %u states encode\n", StateCount);
+	PrintAvgPerSymbolPerfStats(EncAccum, RUNS_COUNT, InputFile.Size);
+	printf(" tANS %u states decode (branchless reader)\n", StateCount);
+	PrintAvgPerSymbolPerfStats(DecAccum, RUNS_COUNT, InputFile.Size);
+	PrintCompressionSize(InputFile.Size, TotalEncSize);
+}
+
+void
+TestTansTableBuild(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+
+	u32 Freq[256] = {};
+	u16 NormFreq[256] = {};
+
+	CountByte(Freq, InputFile.Data, InputFile.Size);
+	OptimalNormalizeFast(Freq, NormFreq, InputFile.Size, 256, TANS_PROB_SCALE);
+
+	std::vector<TansEncTable::entry> EncEntriesMem(256);
+	std::vector<TansDecTable::entry> DecEntriesMem(TANS_PROB_SCALE);
+	std::vector<u16> TableMem(TANS_PROB_SCALE);
+
+	TansEncTable EncTable;
+	TansDecTable DecTable;
+
+	Timer Timer;
+	AccumTime RadixAccum, CombinedAccum, CacheAccum;
+
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		Timer.start();
+		EncTable.initRadix(EncEntriesMem.data(), TANS_PROB_BITS, TableMem.data(), NormFreq);
+		DecTable.initRadix(DecEntriesMem.data(), TANS_PROB_BITS, NormFreq);
+		Timer.end();
+		RadixAccum.update(Timer);
+
+		Timer.start();
+		TansBuildTables(EncTable, EncEntriesMem.data(), TableMem.data(), DecTable, DecEntriesMem.data(), TANS_PROB_BITS, NormFreq);
+		Timer.end();
+		CombinedAccum.update(Timer);
+	}
+
+	// combined build must match separate builds from the same spread
+	{
+		std::vector<u8> Spread(TANS_PROB_SCALE);
+		TansSpreadSymbols(Spread.data(), TANS_PROB_BITS, NormFreq, 256);
+
+		std::vector<TansEncTable::entry> RefEncEntriesMem(256);
+		std::vector<TansDecTable::entry> RefDecEntriesMem(TANS_PROB_SCALE);
+		std::vector<u16> RefTableMem(TANS_PROB_SCALE);
+
+		TansEncTable RefEncTable;
+		TansDecTable RefDecTable;
+		RefEncTable.init(RefEncEntriesMem.data(), TANS_PROB_BITS, RefTableMem.data(), Spread.data(), NormFreq);
+		RefDecTable.init(RefDecEntriesMem.data(), TANS_PROB_BITS, Spread.data(), NormFreq);
+
+		for (u32 i = 0; i < TANS_PROB_SCALE; i++)
+		{
+			Assert(RefTableMem[i] == TableMem[i]);
+			Assert(TansLoadDecEntry(&RefDecEntriesMem[i]) == TansLoadDecEntry(&DecEntriesMem[i]));
+		}
+	}
+
+	// small messages with per block tables from a few slices of input, more slices than cache entries
+	static constexpr u32 SliceCount = 4;
+	static constexpr u32 CacheCapacity = 3;
+	static constexpr u32 SliceOrder[] = { 0, 0, 1, 0, 2, 1, 3, 0, 3, 2, 2, 1, 3, 3, 0 };
+
+	u64 SliceSize = InputFile.Size / SliceCount;
+	Assert(SliceSize);
+	u64 MessageSize = SliceSize < (1 << 12) ? SliceSize : (1 << 12);
+	u64 MessageCount = InputFile.Size / MessageSize;
+	MessageCount = MessageCount < ArrayCount(SliceOrder) ? ArrayCount(SliceOrder) : MessageCount;
+
+	u16 SliceNormFreq[SliceCount][256] = {};
+	u32 SliceTable[SliceCount]; // first slice with the same frequencies, cache must not tell them apart
+	for (u32 i = 0; i < SliceCount; i++)
+	{
+		u32 SliceFreq[256] = {};
+		CountByte(SliceFreq, InputFile.Data + i * SliceSize, SliceSize);
+		OptimalNormalizeFast(SliceFreq, SliceNormFreq[i], SliceSize, 256, TANS_PROB_SCALE);
+
+		SliceTable[i] = i;
+		for (u32 j = 0; j < i; j++)
+		{
+			if (!memcmp(SliceNormFreq[i], SliceNormFreq[j], sizeof(SliceNormFreq[i])))
+			{
+				SliceTable[i] = SliceTable[j];
+				break;
+			}
+		}
+	}
+
+	TansTableCache Cache;
+	Cache.init(CacheCapacity, TANS_PROB_BITS);
+
+	// reference LRU, most recent first
+	std::vector<u32> RefLru;
+	u64 RefHits = 0;
+	u64 RefMisses = 0;
+
+	u64 OutSize = MessageSize + (MessageSize >> 3) + 64;
+	std::vector<u8> OutBuff(OutSize);
+	std::vector<u8> DecBuff(MessageSize);
+	TansInterleaved<4> Coder;
+
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		for (u64 Message = 0; Message < MessageCount; Message++)
+		{
+			u32 Slice = SliceOrder[Message % ArrayCount(SliceOrder)];
+			u64 Offset = Slice * SliceSize + (Message * MessageSize) % (SliceSize - MessageSize + 1);
+
+			Timer.start();
+			TansTableCache::entry* Tables = Cache.get(SliceNormFreq[Slice], TANS_PROB_BITS);
+			Timer.end();
+			CacheAccum.update(Timer);
+
+			auto Used = std::find(RefLru.begin(), RefLru.end(), SliceTable[Slice]);
+			if (Used != RefLru.end())
+			{
+				RefLru.erase(Used);
+				RefHits++;
+			}
+			else
+			{
+				if (RefLru.size() == CacheCapacity) RefLru.pop_back();
+				RefMisses++;
+			}
+			RefLru.insert(RefLru.begin(), SliceTable[Slice]);
+
+			// NOTE: entry built for another slice would fail the round trip
+			u64 EncSize = Coder.encode(OutBuff.data(), OutSize, InputFile.Data + Offset, MessageSize, Tables->Enc);
+			Verify(Coder.decode(DecBuff.data(), MessageSize, OutBuff.data(), EncSize, Tables->Dec));
+
+			for (u64 i = 0; i < MessageSize; i++)
+			{
+				Assert(DecBuff[i] == InputFile.Data[Offset + i]);
+			}
+		}
+	}
+
+	Verify((Cache.Hits == RefHits) && (Cache.Misses == RefMisses));
+
+	RadixAccum.avg(RUNS_COUNT);
+	CombinedAccum.avg(RUNS_COUNT);
+	CacheAccum.avg(RUNS_COUNT * MessageCount);
+
+	printf(" tANS enc+dec radix init - %lu clocks, %0.6f ms \n", RadixAccum.Clock, RadixAccum.Time * 1000.0);
+	printf(" tANS combined spread init - %lu clocks, %0.6f ms \n", CombinedAccum.Clock, CombinedAccum.Time * 1000.0);
+	printf(" tANS cache lookup per %lu byte message - %lu clocks (%lu hits, %lu misses)\n\n",
+		MessageSize, CacheAccum.Clock, Cache.Hits, Cache.Misses);
+}
+
+void
+TestWideAlphabetAns(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+
+	static constexpr u32 AlphSize = 4096;
+	static constexpr u32 ProbBit = 16;
+	static constexpr u32 ProbScale = 1 << ProbBit;
+
+	using sym_type = ans_sym_type<AlphSize>;
+
+	// 12 bit tokens made from byte pairs, stand in for LZ lengths or quantized deltas
+	u64 SymCount = InputFile.Size / 2;
+	std::vector<sym_type> Symbols(SymCount);
+	for (u64 i = 0; i < SymCount; i++)
+	{
+		Symbols[i] = static_cast<sym_type>(((InputFile.Data[2 * i] << 4) | (InputFile.Data[2 * i + 1] >> 4)) & (AlphSize - 1));
+	}
+
+	std::vector<u32> Freq(AlphSize);
+	std::vector<u16> NormFreq(AlphSize);
+	std::vector<u32> CumFreq(AlphSize + 1);
+
+	for (u64 i = 0; i < SymCount; i++)
+	{
+		Freq[Symbols[i]]++;
+	}
+
+	OptimalNormalizeFast(Freq.data(), NormFreq.data(), SymCount, AlphSize, ProbScale);
+	for (u32 i = 0; i < AlphSize; i++)
+	{
+		CumFreq[i + 1] = CumFreq[i] + NormFreq[i];
+	}
+	Assert(CumFreq[AlphSize] == ProbScale);
+
+	u64 BuffSize = AlignSizeForward(SymCount * sizeof(sym_type) + (SymCount >> 2) + 64);
+	std::vector<u8> OutBuff(BuffSize);
+	std::vector<sym_type> DecBuff(SymCount);
+
+	Timer Timer;
+	AccumTime EncAccum, DecAccum;
+
+	// tANS
+	std::vector<TansEncTableAlph<AlphSize>::entry> EncEntriesMem(AlphSize);
+	std::vector<TansDecTableAlph<AlphSize>::entry> DecEntriesMem(ProbScale);
+	std::vector<u16> TableMem(ProbScale);
+
+	TansEncTableAlph<AlphSize> EncTable;
+	TansDecTableAlph<AlphSize> DecTable;
+	TansBuildTables(EncTable, EncEntriesMem.data(), TableMem.data(), DecTable, DecEntriesMem.data(), ProbBit, NormFreq.data());
+
+	u64 TansEncSize = 0;
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		BitWriter Writer(OutBuff.data(), BuffSize);
+		TansState State;
+		State.State = EncTable.L;
+
+		Timer.start();
+		for (u64 i = SymCount; i > 0; i--)
+		{
+			State.encode(Writer, EncTable, Symbols[i - 1]);
+		}
+
+		Writer.writeMaskMSB(static_cast<u32>(State.State), EncTable.StateBits);
+		TansEncSize = Writer.finishReverse();
+		Timer.end();
+		EncAccum.update(Timer);
+	}
+
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		BitReaderReverseMSB Reader(OutBuff.data(), TansEncSize);
+		TansState State;
+
+		Timer.start();
+		Reader.refillTo(DecTable.StateBits);
+		State.State = Reader.getBits(DecTable.StateBits);
+
+		for (u64 i = 0; i < SymCount; i++)
+		{
+			DecBuff[i] = State.decode(Reader, DecTable);
+			Reader.refillTo(DecTable.StateBits);
+		}
+		Timer.end();
+		DecAccum.update(Timer);
+
+		for (u64 i = 0; i < SymCount; i++)
+		{
+			Assert(DecBuff[i] == Symbols[i]);
+		}
+	}
+
+	printf(" tANS %u symbols, table log %u encode\n", AlphSize, ProbBit);
+	PrintAvgPerSymbolPerfStats(EncAccum, RUNS_COUNT, SymCount);
+	printf(" tANS decode\n");
+	PrintAvgPerSymbolPerfStats(DecAccum, RUNS_COUNT, SymCount);
+	PrintCompressionSize(SymCount * sizeof(sym_type), TansEncSize);
+
+	// rANS
+	EncAccum.reset();
+	DecAccum.reset();
+
+	std::vector<rans_enc_sym64> EncSym(AlphSize);
+	rans_sym_table<ProbScale, sym_type>* Tab = new rans_sym_table<ProbScale, sym_type>;
+
+	for (u32 i = 0; i < AlphSize; i++)
+	{
+		if (!NormFreq[i]) continue;
+
+		RansEncSymInit(&EncSym[i], CumFreq[i], NormFreq[i], ProbBit);
+		RansTableInitSym(*Tab, i, CumFreq[i], NormFreq[i]);
+	}
+
+	u32* DecodeBegin = nullptr;
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		u32* Out = reinterpret_cast<u32*>(OutBuff.data() + BuffSize);
+
+		Rans32Enc Enc;
+		Enc.init();
+
+		Timer.start();
+		for (u64 i = SymCount; i > 0; i--)
+		{
+			Enc.encode(&Out, &EncSym[Symbols[i - 1]], ProbBit);
+		}
+		Enc.flush(&Out);
+		Timer.end();
+		EncAccum.update(Timer);
+
+		DecodeBegin = Out;
+	}
+
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		u32* In = DecodeBegin;
+
+		Rans32Dec Dec;
+		Dec.init(&In);
+
+		Timer.start();
+		for (u64 i = 0; i < SymCount; i++)
+		{
+			DecBuff[i] = Dec.decodeSym(*Tab, ProbScale, ProbBit);
+			Dec.decodeRenorm(&In);
+		}
+		Timer.end();
+		DecAccum.update(Timer);
+
+		for (u64 i = 0; i < SymCount; i++)
+		{
+			Assert(DecBuff[i] == Symbols[i]);
+		}
+	}
+
+	u64 RansEncSize = (OutBuff.data() + BuffSize) - reinterpret_cast<u8*>(DecodeBegin);
+
+	printf(" rANS %u symbols, scale bit %u encode\n", AlphSize, ProbBit);
+	PrintAvgPerSymbolPerfStats(EncAccum, RUNS_COUNT, SymCount);
+	printf(" rANS decode\n");
+	PrintAvgPerSymbolPerfStats(DecAccum, RUNS_COUNT, SymCount);
+	PrintCompressionSize(SymCount * sizeof(sym_type), RansEncSize);
+
+	delete Tab;
+}
+
+void
+TestNibbleSplitRans32(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+
+	static constexpr u32 DirectScale = RANS_NIBBLE_SCALE;
+
+	u64 BuffSize = AlignSizeForward(InputFile.Size + (InputFile.Size >> 2) + 64);
+	std::vector<u8> OutBuff(BuffSize);
+	std::vector<u8> DecBuff(InputFile.Size);
+
+	u32* OutEnd = reinterpret_cast<u32*>(OutBuff.data() + BuffSize);
+
+	u32 Freq[256] = {};
+	CountByteFast(Freq, InputFile.Data, InputFile.Size);
+
+	Timer Timer;
+	AccumTime EncAccum, DecAccum;
+
+	// direct slot table at the same precision
+	SymbolStats Stats;
+	MemCopy(sizeof(Freq), Stats.Freq, Freq);
+	Stats.optimalNormalizeFast(DirectScale);
+
+	rans_sym_table<DirectScale>* Tab = new rans_sym_table<DirectScale>;
+	rans_enc_sym64 EncSym[256];
+	for (u32 i = 0; i < 256; i++)
+	{
+		if (!Stats.Freq[i]) continue;
+
+		RansEncSymInit(&EncSym[i], Stats.CumFreq[i], Stats.Freq[i], RANS_NIBBLE_SCALE_BIT);
+		RansTableInitSym(*Tab, i, Stats.CumFreq[i], Stats.Freq[i]);
+	}
+
+	u32* DecodeBegin = nullptr;
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		u32* Out = OutEnd;
+
+		Timer.start();
+		Rans32Enc Enc0, Enc1;
+		Enc0.init();
+		Enc1.init();
+
+		if (InputFile.Size & 1)
+		{
+			Enc0.encode(&Out, &EncSym[InputFile.Data[InputFile.Size - 1]], RANS_NIBBLE_SCALE_BIT);
+		}
+
+		for (u64 i = (InputFile.Size & ~1ull); i > 0; i -= 2)
+		{
+			Enc1.encode(&Out, &EncSym[InputFile.Data[i - 1]], RANS_NIBBLE_SCALE_BIT);
+			Enc0.encode(&Out, &EncSym[InputFile.Data[i - 2]], RANS_NIBBLE_SCALE_BIT);
+		}
+		Enc1.flush(&Out);
+		Enc0.flush(&Out);
+		Timer.end();
+		EncAccum.update(Timer);
+
+		DecodeBegin = Out;
+	}
+
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		u32* In = DecodeBegin;
+
+		Timer.start();
+		Rans32Dec Dec0, Dec1;
+		Dec0.init(&In);
+		Dec1.init(&In);
+
+		for (u64 i = 0; i < (InputFile.Size & ~1ull); i += 2)
+		{
+			DecBuff[i] = Dec0.decodeSym(*Tab, DirectScale, RANS_NIBBLE_SCALE_BIT);
+			DecBuff[i + 1] = Dec1.decodeSym(*Tab, DirectScale, RANS_NIBBLE_SCALE_BIT);
+			Dec0.decodeRenorm(&In);
+			Dec1.decodeRenorm(&In);
+		}
+
+		if (InputFile.Size & 1)
+		{
+			DecBuff[InputFile.Size - 1] = Dec0.decodeSym(*Tab, DirectScale, RANS_NIBBLE_SCALE_BIT);
+		}
+		Timer.end();
+		DecAccum.update(Timer);
+
+		for (u64 i = 0; i < InputFile.Size; i++)
+		{
+			Assert(DecBuff[i] == InputFile.Data[i]);
+		}
+	}
+
+	u64 DirectSize = reinterpret_cast<u8*>(OutEnd) - reinterpret_cast<u8*>(DecodeBegin);
+
+	printf(" rANS direct table (%lu bytes) encode\n", sizeof(rans_sym_table<DirectScale>));
+	PrintAvgPerSymbolPerfStats(EncAccum, RUNS_COUNT, InputFile.Size);
+	printf(" rANS direct table decode\n");
+	PrintAvgPerSymbolPerfStats(DecAccum, RUNS_COUNT, InputFile.Size);
+	PrintCompressionSize(InputFile.Size, DirectSize);
+
+	delete Tab;
+
+	// nibble split
+	EncAccum.reset();
+	DecAccum.reset();
+
+	RansNibbleModel Model;
+	Model.init(Freq);
+
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		Timer.start();
+		DecodeBegin = RansNibbleEncode(OutEnd, InputFile.Data, InputFile.Size, Model);
+		Timer.end();
+		EncAccum.update(Timer);
+	}
+
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		Timer.start();
+		RansNibbleDecode(DecBuff.data(), InputFile.Size, DecodeBegin, Model);
+		Timer.end();
+		DecAccum.update(Timer);
+
+		for (u64 i = 0; i < InputFile.Size; i++)
+		{
+			Assert(DecBuff[i] == InputFile.Data[i]);
+		}
+	}
+
+	u64 NibbleSize = reinterpret_cast<u8*>(OutEnd) - reinterpret_cast<u8*>(DecodeBegin);
+
+	printf(" rANS nibble split (%lu bytes of decode cdf) encode\n", sizeof(Model.Hi) + sizeof(Model.Lo));
+	PrintAvgPerSymbolPerfStats(EncAccum, RUNS_COUNT, InputFile.Size);
+	printf(" rANS nibble split decode\n");
+	PrintAvgPerSymbolPerfStats(DecAccum, RUNS_COUNT, InputFile.Size);
+	PrintCompressionSize(InputFile.Size, NibbleSize);
+}
+
+void
+TestAliasRans32(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+
+	static constexpr u32 ScaleBit = 16;
+	static constexpr u32 Scale = 1 << ScaleBit;
+
+	u64 BuffSize = AlignSizeForward(InputFile.Size + (InputFile.Size >> 2) + 64);
+	std::vector<u8> OutBuff(BuffSize);
+	std::vector<u8> DecBuff(InputFile.Size);
+
+	u32* OutEnd = reinterpret_cast<u32*>(OutBuff.data() + BuffSize);
+
+	SymbolStats Stats;
+	Stats.countSymbol(InputFile.Data, InputFile.Size);
+	Stats.optimalNormalizeFast(Scale);
+
+	Timer Timer;
+	AccumTime BuildAccum, EncAccum, DecAccum;
+
+	RansAliasTable* Tab = new RansAliasTable;
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		Timer.start();
+		Tab->init(Stats, ScaleBit);
+		Timer.end();
+		BuildAccum.update(Timer);
+	}
+
+	u32* DecodeBegin = nullptr;
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		u32* Out = OutEnd;
+
+		Timer.start();
+		Rans32Enc Enc0, Enc1;
+		Enc0.init();
+		Enc1.init();
+
+		if (InputFile.Size & 1)
+		{
+			Tab->encode(Enc0, &Out, InputFile.Data[InputFile.Size - 1]);
+		}
+
+		for (u64 i = (InputFile.Size & ~1ull); i > 0; i -= 2)
+		{
+			Tab->encode(Enc1, &Out, InputFile.Data[i - 1]);
+			Tab->encode(Enc0, &Out, InputFile.Data[i - 2]);
+		}
+		Enc1.flush(&Out);
+		Enc0.flush(&Out);
+		Timer.end();
+		EncAccum.update(Timer);
+
+		DecodeBegin = Out;
+	}
+
+	for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+	{
+		u32* In = DecodeBegin;
+
+		Timer.start();
+		Rans32Dec Dec0, Dec1;
+		Dec0.init(&In);
+		Dec1.init(&In);
+
+		for (u64 i = 0; i < (InputFile.Size & ~1ull); i += 2)
+		{
+			DecBuff[i] = Tab->decodeSym(Dec0);
+			DecBuff[i + 1] = Tab->decodeSym(Dec1);
+			Dec0.decodeRenorm(&In);
+			Dec1.decodeRenorm(&In);
+		}
+
+		if (InputFile.Size & 1)
+		{
+			DecBuff[InputFile.Size - 1] = Tab->decodeSym(Dec0);
+		}
+		Timer.end();
+		DecAccum.update(Timer);
+
+		for (u64 i = 0; i < InputFile.Size; i++)
+		{
+			Assert(DecBuff[i] == InputFile.Data[i]);
+		}
+	}
+
+	u64 CompressedSize = reinterpret_cast<u8*>(OutEnd) - reinterpret_cast<u8*>(DecodeBegin);
+	u64 DecTableSize = sizeof(Tab->Divider) + sizeof(Tab->SlotAdjust) + sizeof(Tab->SlotFreq) + sizeof(Tab->Sym);
+
+	BuildAccum.avg(RUNS_COUNT);
+	printf(" alias table build - %lu clocks, %0.6f ms \n", BuildAccum.Clock, BuildAccum.Time * 1000.0);
+	printf(" rANS alias encode (scale bit %u, %lu bytes remap)\n", ScaleBit, Scale * sizeof(u32));
+	PrintAvgPerSymbolPerfStats(EncAccum, RUNS_COUNT, InputFile.Size);
+	printf(" rANS alias decode (%lu bytes of decode table, %lu for direct table)\n", DecTableSize, sizeof(rans_sym_table<Scale>));
+	PrintAvgPerSymbolPerfStats(DecAccum, RUNS_COUNT, InputFile.Size);
+	PrintCompressionSize(InputFile.Size, CompressedSize);
+
+	delete Tab;
+}
+
+static constexpr u32 SMALL_MESSAGE_SIZE = 1 << 12;
+
+struct small_message_worker
+{
+	rans_block_enc_ctx EncCtx;
+	rans_block_dec_ctx DecCtx;
+	std::vector<u32> OutMem;
+	std::vector<u8> DecMem;
+	u64 CompressedSize;
+	b32 Valid;
+};
+
+static void
+CodeSmallMessages(small_message_worker& Worker, const u8* Data, u64 Size, u64 FirstMessage, u64 MessageStep)
+{
+	u32* OutEnd = Worker.OutMem.data() + Worker.OutMem.size();
+
+	Worker.CompressedSize = 0;
+	Worker.Valid = true;
+
+	for (u64 Start = FirstMessage * SMALL_MESSAGE_SIZE; Start < Size; Start += MessageStep * SMALL_MESSAGE_SIZE)
+	{
+		u32 MessageSize = static_cast<u32>((Size - Start) < SMALL_MESSAGE_SIZE ? (Size - Start) : SMALL_MESSAGE_SIZE);
+
+		u32* In = RansBlockEncode(Worker.EncCtx, OutEnd, Data + Start, MessageSize);
+		Worker.CompressedSize += (OutEnd - In) * sizeof(u32);
+
+		u32 DecodedSize = RansBlockDecode(Worker.DecCtx, Worker.DecMem.data(), SMALL_MESSAGE_SIZE, &In);
+		if ((DecodedSize != MessageSize) || (In != OutEnd) || memcmp(Worker.DecMem.data(), Data + Start, MessageSize))
+		{
+			Worker.Valid = false;
+		}
+	}
+}
+
+// encode + decode of independent 4K messages, each thread with its own context and reused buffers
+void
+TestSmallMessagesThreaded(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+	Timer Timer;
+
+	u32 MaxThreadCount = std::thread::hardware_concurrency();
+	MaxThreadCount = MaxThreadCount ? MaxThreadCount : 1;
+
+	u64 MessageCount = (InputFile.Size + SMALL_MESSAGE_SIZE - 1) / SMALL_MESSAGE_SIZE;
+
+	std::vector<small_message_worker> Workers(MaxThreadCount);
+	for (small_message_worker& Worker : Workers)
+	{
+		Worker.OutMem.resize(RansBlockBound(SMALL_MESSAGE_SIZE) / sizeof(u32));
+		Worker.DecMem.resize(SMALL_MESSAGE_SIZE);
+	}
+
+	for (u32 ThreadCount = 1; ThreadCount <= MaxThreadCount; ThreadCount *= 2)
+	{
+		AccumTime Accum;
+		u64 CompressedSize = 0;
+
+		for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+		{
+			std::vector<std::thread> Threads;
+			Threads.reserve(ThreadCount - 1);
+
+			Timer.start();
+			for (u32 i = 1; i < ThreadCount; i++)
+			{
+				small_message_worker* Worker = &Workers[i];
+				Threads.emplace_back([Worker, &InputFile, i, ThreadCount]()
+				{
+					CodeSmallMessages(*Worker, InputFile.Data, InputFile.Size, i, ThreadCount);
+				});
+			}
+
+			CodeSmallMessages(Workers[0], InputFile.Data, InputFile.Size, 0, ThreadCount);
+
+			for (auto& Thread : Threads)
+			{
+				Thread.join();
+			}
+			Timer.end();
+			Accum.update(Timer);
+
+			CompressedSize = 0;
+			for (u32 i = 0; i < ThreadCount; i++)
+			{
+				Assert(Workers[i].Valid);
+				CompressedSize += Workers[i].CompressedSize;
+			}
+		}
+
+		Accum.avg(RUNS_COUNT);
+		printf(" %u threads, %lu messages, %.0f messages/s\n", ThreadCount, MessageCount, MessageCount / Accum.Time);
+		PrintSymbolEncPerfStats(Accum.Clock, Accum.Time, InputFile.Size);
+
+		if (ThreadCount == 1)
+		{
+			PrintCompressionSize(InputFile.Size, CompressedSize);
+		}
+	}
+
+	printf("\n");
+}
+
+// small messages: per message freq table vs pretrained table from first half of file
+void
+TestRansBlockDictionary(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+	Timer Timer;
+
+	const u32 MessageSizes[] = { 256, 1024, 4096 };
+
+	u64 TrainSize = InputFile.Size / 2;
+	const u8* TestData = InputFile.Data + TrainSize;
+	u64 TestSize = InputFile.Size - TrainSize;
+
+	rans_block_dict* Dict = new rans_block_dict;
+	rans_block_enc_ctx* EncCtx = new rans_block_enc_ctx;
+	rans_block_dec_ctx* DecCtx = new rans_block_dec_ctx;
+
+	Timer.start();
+	Dict->train(InputFile.Data, TrainSize);
+	Timer.end();
+
+	u32 DictWords[FreqTableBitmapWords + 128];
+	u32 DictWordCount = Dict->save(DictWords);
+	printf(" dict train %lu bytes - %lu clocks, serialized %lu bytes\n", TrainSize, Timer.Clock, DictWordCount * sizeof(u32));
+
+	std::vector<u32> OutMem(RansBlockBound(4096) / sizeof(u32));
+	std::vector<u8> DecMem(4096);
+	u32* OutEnd = OutMem.data() + OutMem.size();
+
+	for (u32 MessageSize : MessageSizes)
+	{
+		if (TestSize < MessageSize) break;
+
+		u64 MessageCount = TestSize / MessageSize;
+		u64 TableSize = 0;
+		u64 DictSize = 0;
+
+		AccumTime TableAccum, DictAccum;
+		for (u64 m = 0; m < MessageCount; m++)
+		{
+			const u8* Message = TestData + m * MessageSize;
+
+			Timer.start();
+			u32* In = RansBlockEncode(*EncCtx, OutEnd, Message, MessageSize);
+			Timer.end();
+			TableAccum.update(Timer);
+			TableSize += (OutEnd - In) * sizeof(u32);
+
+			u32 DecodedSize = RansBlockDecode(*DecCtx, DecMem.data(), MessageSize, &In);
+			Verify((DecodedSize == MessageSize) && !memcmp(DecMem.data(), Message, MessageSize));
+
+			Timer.start();
+			In = Dict->encode(OutEnd, Message, MessageSize);
+			Timer.end();
+			DictAccum.update(Timer);
+			DictSize += (OutEnd - In) * sizeof(u32);
+
+			DecodedSize = Dict->decode(DecMem.data(), MessageSize, &In);
+			Verify((DecodedSize == MessageSize) && !memcmp(DecMem.data(), Message, MessageSize));
+		}
+
+		printf(" %lu messages of %u\n", MessageCount, MessageSize);
+		printf("  own table encode");
+		PrintSymbolEncPerfStats(TableAccum.Clock, TableAccum.Time, MessageCount * MessageSize);
+		PrintCompressionSize(MessageCount * MessageSize, TableSize);
+		printf("  dictionary encode");
+		PrintSymbolEncPerfStats(DictAccum.Clock, DictAccum.Time, MessageCount * MessageSize);
+		PrintCompressionSize(MessageCount * MessageSize, DictSize);
+	}
+
+	delete Dict;
+	delete EncCtx;
+	delete DecCtx;
+
+	printf("\n");
+}
+
+void
+TestCheckedDecodeRans(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+	Timer Timer;
+
+	if (InputFile.Size >= MaxUInt32)
+	{
+		printf("File to big for _TestCheckedDecodeRans_\n");
+		return;
+	}
+
+	// Rans8: loop renorm vs branchless renorm, streams must be same
+	{
+		u64 BuffSize = InputFile.Size + InputFile.Size / 2 + 16;
+		std::vector<u8> OutBuff(BuffSize);
+		std::vector<u8> FastOutBuff(BuffSize);
+		std::vector<u8> DecBuff(InputFile.Size);
+
+		SymbolStats Stats;
+		Stats.countSymbol(InputFile.Data, InputFile.Size);
+		Stats.optimalNormalize(RANS_PROB_SCALE);
+
+		rans_enc_sym32 EncSymArr[256];
+		rans_sym_table<RANS_PROB_SCALE> Tab;
+		for (u32 i = 0; i < 256; i++)
+		{
+			RansEncSymInit(&EncSymArr[i], Stats.CumFreq[i], Stats.Freq[i], RANS_PROB_BIT, Rans8L, 8);
+			RansTableInitSym(Tab, i, Stats.CumFreq[i], Stats.Freq[i]);
+		}
+
+		u8* DecodeBegin = nullptr;
+		u8* FastDecodeBegin = nullptr;
+		AccumTime Accum, FastAccum;
+
+		for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+		{
+			Rans8Enc Encoder;
+			u8* Out = OutBuff.data() + BuffSize;
+
+			Timer.start();
+			Encoder.init();
+			for (u64 i = InputFile.Size; i > 0; i--)
+			{
+				Encoder.encode(&Out, &EncSymArr[InputFile.Data[i - 1]]);
+			}
+			Encoder.flush(&Out);
+			Timer.end();
+			Accum.update(Timer);
+			DecodeBegin = Out;
+
+			Out = FastOutBuff.data() + BuffSize;
+
+			Timer.start();
+			Encoder.init();
+			for (u64 i = InputFile.Size; i > 0; i--)
+			{
+				Encoder.encodeFast(&Out, &EncSymArr[InputFile.Data[i - 1]]);
+			}
+			Encoder.flush(&Out);
+			Timer.end();
+			FastAccum.update(Timer);
+			FastDecodeBegin = Out;
+		}
+
+		u64 CompressedSize = (OutBuff.data() + BuffSize) - DecodeBegin;
+		Verify(CompressedSize == (u64)((FastOutBuff.data() + BuffSize) - FastDecodeBegin));
+		Verify(!memcmp(DecodeBegin, FastDecodeBegin, CompressedSize));
+
+		printf(" Rans8 encode, loop renorm");
+		PrintAvgPerSymbolPerfStats(Accum, RUNS_COUNT, InputFile.Size);
+		printf(" Rans8 encode, branchless renorm");
+		PrintAvgPerSymbolPerfStats(FastAccum, RUNS_COUNT, InputFile.Size);
+
+		Accum.reset();
+		FastAccum.reset();
+
+		const u8* InEnd = OutBuff.data() + BuffSize;
+		for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+		{
+			u8* In = DecodeBegin;
+			Rans8Dec Decoder;
+
+			Timer.start();
+			Decoder.init(&In);
+			for (u64 i = 0; i < InputFile.Size; i++)
+			{
+				DecBuff[i] = Decoder.decodeSym(Tab, RANS_PROB_SCALE, RANS_PROB_BIT);
+				Decoder.decodeRenorm(&In);
+			}
+			Timer.end();
+			Accum.update(Timer);
+
+			Assert(!memcmp(DecBuff.data(), InputFile.Data, InputFile.Size));
+
+			// NOTE: renorm reads at most 3 bytes per symbol, fast loop needs 4 readable
+			In = DecodeBegin;
+
+			Timer.start();
+			Decoder.init(&In);
+			u64 i = 0;
+			for (; (i < InputFile.Size) && ((InEnd - In) >= 4); i++)
+			{
+				DecBuff[i] = Decoder.decodeSym(Tab, RANS_PROB_SCALE, RANS_PROB_BIT);
+				Decoder.decodeRenormFast(&In);
+			}
+
+			b32 Valid = true;
+			for (; i < InputFile.Size; i++)
+			{
+				DecBuff[i] = Decoder.decodeSym(Tab, RANS_PROB_SCALE, RANS_PROB_BIT);
+				Valid &= Decoder.decodeRenormChecked(&In, InEnd);
+			}
+			Timer.end();
+			FastAccum.update(Timer);
+
+			Assert(Valid && (In == InEnd));
+			Assert(!memcmp(DecBuff.data(), InputFile.Data, InputFile.Size));
+		}
+
+		printf(" Rans8 decode, loop renorm");
+		PrintAvgPerSymbolPerfStats(Accum, RUNS_COUNT, InputFile.Size);
+		printf(" Rans8 decode, branchless + checked tail");
+		PrintAvgPerSymbolPerfStats(FastAccum, RUNS_COUNT, InputFile.Size);
+	}
+
+	// block rANS: unchecked vs checked decode, then corrupted and truncated streams
+	{
+		u32 Size = static_cast<u32>(InputFile.Size);
+		std::vector<u32> OutMem((RansBlockBound(Size) + sizeof(u32) - 1) / sizeof(u32));
+		std::vector<u8> DecBuff(Size);
+
+		rans_block_enc_ctx* EncCtx = new rans_block_enc_ctx;
+		rans_block_dec_ctx* DecCtx = new rans_block_dec_ctx;
+
+		u32* OutEnd = OutMem.data() + OutMem.size();
+		u32* Begin = RansBlockEncode(*EncCtx, OutEnd, InputFile.Data, Size);
+
+		AccumTime Accum, CheckedAccum;
+		for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+		{
+			u32* In = Begin;
+
+			Timer.start();
+			u32 DecodedSize = RansBlockDecode(*DecCtx, DecBuff.data(), Size, &In);
+			Timer.end();
+			Accum.update(Timer);
+
+			Verify((DecodedSize == Size) && !memcmp(DecBuff.data(), InputFile.Data, Size));
+
+			In = Begin;
+
+			Timer.start();
+			DecodedSize = RansBlockDecode(*DecCtx, DecBuff.data(), Size, &In, OutEnd);
+			Timer.end();
+			CheckedAccum.update(Timer);
+
+			Verify((DecodedSize == Size) && (In == OutEnd) && !memcmp(DecBuff.data(), InputFile.Data, Size));
+		}
+
+		printf(" block decode, unchecked");
+		PrintAvgPerSymbolPerfStats(Accum, RUNS_COUNT, Size);
+		printf(" block decode, fast loop + checked tail");
+		PrintAvgPerSymbolPerfStats(CheckedAccum, RUNS_COUNT, Size);
+
+		// NOTE: corrupted copy lives in own exact size buffer, so overread is caught by sanitizers
+		u64 WordCount = OutEnd - Begin;
+		u32 Rejected = 0;
+		u32 Seed = 0x9E3779B9;
+		const u32 CORRUPT_RUNS = 64;
+
+		for (u32 Run = 0; Run < CORRUPT_RUNS; Run++)
+		{
+			Seed ^= Seed << 13;
+			Seed ^= Seed >> 17;
+			Seed ^= Seed << 5;
+
+			u64 Count = (Run & 1) ? (Seed % WordCount) : WordCount;
+			std::vector<u32> Corrupt(Begin, Begin + Count);
+			if (!(Run & 1) && Count)
+			{
+				Corrupt[Seed % Count] ^= 1 << (Seed >> 27);
+			}
+
+			u32* In = Corrupt.data();
+			u32 DecodedSize = RansBlockDecode(*DecCtx, DecBuff.data(), Size, &In, Corrupt.data() + Count);
+			Rejected += !DecodedSize;
+		}
+
+		printf(" corrupted/truncated streams rejected %u of %u\n", Rejected, CORRUPT_RUNS);
+
+		delete EncCtx;
+		delete DecCtx;
+	}
+}
+
+void
+TestCodecAutoSelect(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+
+	if (InputFile.Size >= MaxUInt32)
+	{
+		printf("File to big for _TestCodecAutoSelect_\n");
+		return;
+	}
+
+	const u32 BlockSize = 64 << 10;
+	const u32 Size = static_cast<u32>(InputFile.Size);
+
+	std::vector<codec_select_ctx> SelectCtx(1);
+	std::vector<codec_block_enc_ctx> EncCtx(1);
+	std::vector<codec_block_dec_ctx> DecCtx(1);
+
+	std::vector<u32> Scratch(CodecBlockBound(BlockSize) / sizeof(u32) + 1);
+	u32* ScratchEnd = Scratch.data() + Scratch.size();
+
+	// every block coder codec tried, smallest kept
+	u64 TryAllSize = 0;
+	u64 ActualBytes[BlockCodec_Count] = {};
+	Timer Timer;
+	Timer.start();
+	for (u32 Start = 0; Start < Size; Start += BlockSize)
+	{
+		u32 Count = (Size - Start) < BlockSize ? (Size - Start) : BlockSize;
+
+		const u8* Block = InputFile.Data + Start;
+
+		u64 Best = MaxUInt64;
+		for (u32 Codec = 0; Codec < BlockCodec_Count; Codec++)
+		{
+			if (!(CODEC_BLOCK_CODERS & (1 << Codec))) continue;
+
+			u32* Begin = CodecBlockEncode(EncCtx[0], ScratchEnd, Block, Count, static_cast<block_codec>(Codec));
+			if (!Begin)
+			{
+				// NOTE: single rejects mixed block, Huffman rejects uniform one
+				Assert(((Count == 1) || !memcmp(Block, Block + 1, Count - 1)) ? (Codec == BlockCodec_Huffman) : (Codec == BlockCodec_Single));
+				continue;
+			}
+
+			u64 Bytes = sizeof(u32) * (ScratchEnd - Begin);
+			ActualBytes[Codec] += Bytes;
+			Best = Bytes < Best ? Bytes : Best;
+		}
+		TryAllSize += Best;
+	}
+	Timer.end();
+
+	printf(" try all block coders");
+	PrintSymbolEncPerfStats(Timer.Clock, Timer.Time, InputFile.Size);
+	PrintCompressionSize(InputFile.Size, TryAllSize);
+
+	struct select_test_config
+	{
+		const char* Name;
+		f64 MaxDecodeClocks;
+	};
+
+	const select_test_config Configs[] =
+	{
+		{"auto", BlockCodecDecodeClocks[BlockCodec_RansOrder1]},
+		{"auto, decode budget excludes order-1", BlockCodecDecodeClocks[BlockCodec_RansOrder0]},
+	};
+
+	for (const select_test_config& Config : Configs)
+	{
+		codec_select_params Params = CodecSelectDefaultParams();
+		Params.MaxDecodeClocks = Config.MaxDecodeClocks;
+
+		std::vector<u32> Stream;
+		u32 Picked[BlockCodec_Count] = {};
+		f64 EstimatedBytes[BlockCodec_Count] = {};
+		u32 IncompressibleCount = 0;
+
+		Timer.start();
+		for (u32 Start = 0; Start < Size; Start += BlockSize)
+		{
+			u32 Count = (Size - Start) < BlockSize ? (Size - Start) : BlockSize;
+
+			codec_estimate Est;
+			EstimateBlockCodecs(SelectCtx[0], InputFile.Data + Start, Count, Params, Est);
+			block_codec Codec = SelectBlockCodec(Est, Params);
+
+			u32* Begin = CodecBlockEncode(EncCtx[0], ScratchEnd, InputFile.Data + Start, Count, Codec);
+			Assert(Begin);
+			Stream.insert(Stream.end(), Begin, ScratchEnd);
+
+			Picked[Codec]++;
+			IncompressibleCount += Est.Incompressible;
+			for (u32 c = 0; c < BlockCodec_Count; c++) EstimatedBytes[c] += Est.Bytes[c];
+		}
+		Timer.end();
+
+		printf(" %s:", Config.Name);
+		for (u32 c = 0; c < BlockCodec_Count; c++)
+		{
+			if (Picked[c]) printf(" %s %u", BlockCodecNames[c], Picked[c]);
+		}
+		printf(", %u incompressible\n", IncompressibleCount);
+		PrintSymbolEncPerfStats(Timer.Clock, Timer.Time, InputFile.Size);
+		PrintCompressionSize(InputFile.Size, Stream.size() * sizeof(u32));
+
+		if (&Config == Configs)
+		{
+			printf(" estimated vs actual:");
+			for (u32 c = 0; c < BlockCodec_Count; c++)
+			{
+				if (ActualBytes[c]) printf(" %s %.0f/%lu", BlockCodecNames[c], EstimatedBytes[c], ActualBytes[c]);
+				else printf(" %s %.0f", BlockCodecNames[c], EstimatedBytes[c]);
+			}
+			printf("\n");
+		}
+
+		std::vector<u8> DecBuff(InputFile.Size);
+		u32* In = Stream.data();
+		const u32* InEnd = Stream.data() + Stream.size();
+		for (u32 Start = 0; Start < Size; Start += BlockSize)
+		{
+			u32 Count = (Size - Start) < BlockSize ? (Size - Start) : BlockSize;
+			Verify(CodecBlockDecode(DecCtx[0], DecBuff.data() + Start, Count, &In, InEnd) == Count);
+		}
+
+		Assert(In == InEnd);
+		Assert(!memcmp(DecBuff.data(), InputFile.Data, InputFile.Size));
+	}
+
+	// sample budget below one chunk on blocks smaller than a chunk samples only block bytes
+	{
+		codec_select_params Params = CodecSelectDefaultParams();
+		Params.SampleSize = 64;
+
+		for (u32 Count : {100u, 300u, 511u})
+		{
+			if (Count > Size) break;
+
+			// NOTE: exact size copy, so reads past block end are caught by sanitizers
+			std::vector<u8> Block(InputFile.Data, InputFile.Data + Count);
+
+			codec_estimate Est;
+			EstimateBlockCodecs(SelectCtx[0], Block.data(), Count, Params, Est);
+			Assert(Est.SampledSize <= Count);
+		}
+	}
+
+	// small and weakly compressible blocks: picked codec must code block, whatever estimates of
+	// codecs not applicable to it are
+	{
+		const u32 Counts[] = {1, 2, 7, 100, 511, 4096};
+		const u32 Densities[] = {0, 1, 2, 8};
+
+		std::vector<u8> Block;
+		std::vector<u8> DecBlock(4096);
+		u32 Picked[BlockCodec_Count] = {};
+
+		for (const select_test_config& Config : Configs)
+		{
+			codec_select_params Params = CodecSelectDefaultParams();
+			Params.MaxDecodeClocks = Config.MaxDecodeClocks;
+
+			for (u32 Count : Counts)
+			{
+				if (Count > Size) break;
+
+				// NOTE: density 0 - file bytes as they are, otherwise 1 of Density bytes kept, rest zero
+				for (u32 Density : Densities)
+				{
+					Block.assign(InputFile.Data, InputFile.Data + Count);
+					for (u32 i = 0; Density && (i < Count); i++)
+					{
+						if ((Density == 1) || ((i * 2654435761u) >> 16) % Density) Block[i] = 0;
+					}
+
+					codec_estimate Est;
+					EstimateBlockCodecs(SelectCtx[0], Block.data(), Count, Params, Est);
+					block_codec Codec = SelectBlockCodec(Est, Params);
+					Assert((Codec == BlockCodec_Stored) || (Est.ApplicableMask & (1 << Codec)));
+
+					u32* Begin = CodecBlockEncode(EncCtx[0], ScratchEnd, Block.data(), Count, Codec);
+					Assert(Begin);
+
+					u32* In = Begin;
+					Verify(CodecBlockDecode(DecCtx[0], DecBlock.data(), Count, &In, ScratchEnd) == Count);
+					Assert(In == ScratchEnd);
+					Assert(!memcmp(DecBlock.data(), Block.data(), Count));
+					Picked[Codec]++;
+				}
+			}
+		}
+
+		printf(" small blocks:");
+		for (u32 c = 0; c < BlockCodec_Count; c++)
+		{
+			if (Picked[c]) printf(" %s %u", BlockCodecNames[c], Picked[c]);
+		}
+		printf("\n");
+
+		// single is rejected on block with more than one symbol, Huffman on block with one symbol
+		const u8 Mixed[2] = {0, 1};
+		const u8 Same[2] = {7, 7};
+		Verify(!CodecBlockEncode(EncCtx[0], ScratchEnd, Mixed, 2, BlockCodec_Single));
+		Verify(!CodecBlockEncode(EncCtx[0], ScratchEnd, Same, 2, BlockCodec_Huffman));
+	}
+
+	// every block coder decodes its own block (flat block has all 256 symbols with same Huffman length),
+	// then corrupted and truncated copies
+	{
+		u32 Count = Size < BlockSize ? Size : BlockSize;
+		std::vector<u8> FileBlock(InputFile.Data, InputFile.Data + Count);
+		std::vector<u8> FlatBlock(4096);
+		for (u32 i = 0; i < FlatBlock.size(); i++) FlatBlock[i] = static_cast<u8>(i);
+
+		std::vector<u8> DecBlock(Count > FlatBlock.size() ? Count : FlatBlock.size());
+		u32 Rejected = 0;
+		u32 Corrupted = 0;
+		u32 Seed = 0x9E3779B9;
+
+		for (const std::vector<u8>* Block : {&FileBlock, &FlatBlock})
+		{
+			u32 BlockCount = static_cast<u32>(Block->size());
+			for (u32 Codec = 0; Codec < BlockCodec_Count; Codec++)
+			{
+				if (!(CODEC_BLOCK_CODERS & (1 << Codec))) continue;
+
+				u32* Begin = CodecBlockEncode(EncCtx[0], ScratchEnd, Block->data(), BlockCount, static_cast<block_codec>(Codec));
+				if (!Begin) continue;
+
+				u32* In = Begin;
+				Verify(CodecBlockDecode(DecCtx[0], DecBlock.data(), BlockCount, &In, ScratchEnd) == BlockCount);
+				Verify((In == ScratchEnd) && !memcmp(DecBlock.data(), Block->data(), BlockCount));
+
+				// NOTE: corrupted copy lives in own exact size buffer, so overread is caught by sanitizers
+				u64 WordCount = ScratchEnd - Begin;
+				for (u32 Run = 0; Run < 16; Run++)
+				{
+					Seed ^= Seed << 13;
+					Seed ^= Seed >> 17;
+					Seed ^= Seed << 5;
+
+					u64 CorruptCount = (Run & 1) ? (Seed % WordCount) : WordCount;
+					std::vector<u32> Corrupt(Begin, Begin + CorruptCount);
+					if (!(Run & 1) && (CorruptCount > 1))
+					{
+						Corrupt[1 + Seed % (CorruptCount - 1)] ^= 1 << (Seed >> 27);
+					}
+
+					In = Corrupt.data();
+					Rejected += !CodecBlockDecode(DecCtx[0], DecBlock.data(), BlockCount, &In, Corrupt.data() + CorruptCount);
+					Corrupted++;
+				}
+			}
+		}
+
+		printf(" corrupted/truncated blocks rejected %u of %u\n", Rejected, Corrupted);
+	}
+}
+
+// Sparse data from file bytes: nonzero byte kept at pseudo random positions with given density
+void
+TestSkewedBlocks(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+
+	if (InputFile.Size >= MaxUInt32)
+	{
+		printf("File to big for _TestSkewedBlocks_\n");
+		return;
+	}
+
+	const u32 BlockSize = 64 << 10;
+	const u32 Size = static_cast<u32>(InputFile.Size);
+	const u32 Densities[] = {0, 1000, 100, 10};
+
+	std::vector<codec_select_ctx> SelectCtx(1);
+	std::vector<codec_block_enc_ctx> EncCtx(1);
+	std::vector<codec_block_dec_ctx> DecCtx(1);
+
+	std::vector<u32> Scratch(CodecBlockBound(BlockSize) / sizeof(u32) + 1);
+	u32* ScratchEnd = Scratch.data() + Scratch.size();
+
+	std::vector<u8> Sparse(Size);
+	std::vector<u8> DecBuff(Size);
+	Timer Timer;
+
+	for (u32 Density : Densities)
+	{
+		for (u32 i = 0; i < Size; i++)
+		{
+			b32 Keep = Density && !(((i * 2654435761u) >> 16) % Density);
+			Sparse[i] = Keep ? (InputFile.Data[i] | 1) : 0;
+		}
+
+		if (Density) printf(" 1 of %u bytes nonzero\n", Density);
+		else printf(" all zero\n");
+
+		codec_select_params Params = CodecSelectDefaultParams();
+		for (u32 Auto = 0; Auto < 2; Auto++)
+		{
+			std::vector<u32> Stream;
+			u32 Picked[BlockCodec_Count] = {};
+
+			for (u32 Start = 0; Start < Size; Start += BlockSize)
+			{
+				u32 Count = (Size - Start) < BlockSize ? (Size - Start) : BlockSize;
+				block_codec Codec = BlockCodec_RansOrder0;
+				if (Auto)
+				{
+					codec_estimate Est;
+					EstimateBlockCodecs(SelectCtx[0], Sparse.data() + Start, Count, Params, Est);
+					Codec = SelectBlockCodec(Est, Params);
+				}
+
+				u32* Begin = CodecBlockEncode(EncCtx[0], ScratchEnd, Sparse.data() + Start, Count, Codec);
+				Assert(Begin);
+				Stream.insert(Stream.end(), Begin, ScratchEnd);
+				Picked[Codec]++;
+			}
+
+			AccumTime Accum;
+			for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+			{
+				u32* In = Stream.data();
+				const u32* InEnd = Stream.data() + Stream.size();
+
+				Timer.start();
+				for (u32 Start = 0; Start < Size; Start += BlockSize)
+				{
+					u32 Count = (Size - Start) < BlockSize ? (Size - Start) : BlockSize;
+					Verify(CodecBlockDecode(DecCtx[0], DecBuff.data() + Start, Count, &In, InEnd) == Count);
+				}
+				Timer.end();
+				Accum.update(Timer);
+
+				Assert(In == InEnd);
+				Assert(!memcmp(DecBuff.data(), Sparse.data(), Size));
+			}
+
+			printf("  %s:", Auto ? "auto" : "rANS o0 only");
+			for (u32 c = 0; c < BlockCodec_Count; c++)
+			{
+				if (Picked[c]) printf(" %s %u", BlockCodecNames[c], Picked[c]);
+			}
+			printf("\n  decode");
+			PrintAvgPerSymbolPerfStats(Accum, RUNS_COUNT, Size);
+			printf(" ");
+			PrintCompressionSize(Size, Stream.size() * sizeof(u32));
+		}
+	}
+}
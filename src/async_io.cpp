@@ -0,0 +1,542 @@
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <cerrno>
+#endif
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Positional async file reads/writes. io_uring (raw syscalls, no liburing) on Linux, otherwise or if
+// ring setup fails (old kernel, seccomp) small thread pool doing positional reads/writes.
+// Caller submits ops tagged by own index and waits for completions, every op completes exactly once.
+// Other threads can post own completions with notify, so one thread can wait for both I/O and
+// compute. With io_uring notify goes through eventfd with read kept armed on ring.
+#if defined(_WIN32)
+typedef HANDLE io_file;
+static const io_file INVALID_IO_FILE = INVALID_HANDLE_VALUE;
+#else
+typedef int io_file;
+static const io_file INVALID_IO_FILE = -1;
+#endif
+
+struct async_io_op
+{
+	io_file File;
+	u8* Buffer;
+	u32 Size;
+	u64 Offset;
+	u32 Tag;
+	b32 Write;
+};
+
+struct async_io_done
+{
+	u32 Tag;
+	s64 Result; // bytes transferred, < 0 on error
+};
+
+inline io_file
+OpenIOFile(const char* Path, b32 Write)
+{
+#if defined(_WIN32)
+	io_file Result = CreateFileA(Path, Write ? GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ, nullptr,
+								 Write ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+#else
+	io_file Result = Write ? open(Path, O_WRONLY | O_CREAT | O_TRUNC, 0644) : open(Path, O_RDONLY);
+#endif
+	return Result;
+}
+
+inline void
+CloseIOFile(io_file File)
+{
+#if defined(_WIN32)
+	CloseHandle(File);
+#else
+	close(File);
+#endif
+}
+
+inline u64
+IOFileSize(io_file File)
+{
+#if defined(_WIN32)
+	LARGE_INTEGER Size = {};
+	GetFileSizeEx(File, &Size);
+	u64 Result = Size.QuadPart;
+#else
+	struct stat Stat = {};
+	fstat(File, &Stat);
+	u64 Result = Stat.st_size;
+#endif
+	return Result;
+}
+
+// blocking positional transfer, returns bytes or < 0 on error
+inline s64
+IOFileTransfer(const async_io_op& Op)
+{
+#if defined(_WIN32)
+	OVERLAPPED Overlapped = {};
+	Overlapped.Offset = static_cast<DWORD>(Op.Offset);
+	Overlapped.OffsetHigh = static_cast<DWORD>(Op.Offset >> 32);
+
+	DWORD Transferred = 0;
+	BOOL Ok = Op.Write ? WriteFile(Op.File, Op.Buffer, Op.Size, &Transferred, &Overlapped) :
+						 ReadFile(Op.File, Op.Buffer, Op.Size, &Transferred, &Overlapped);
+	s64 Result = Ok ? Transferred : -1;
+#else
+	ssize_t Transferred = Op.Write ? pwrite(Op.File, Op.Buffer, Op.Size, Op.Offset) : pread(Op.File, Op.Buffer, Op.Size, Op.Offset);
+	s64 Result = Transferred;
+#endif
+	return Result;
+}
+
+#if defined(__linux__)
+
+struct io_uring_ring
+{
+	int Fd;
+
+	u32* SqHead;
+	u32* SqTail;
+	u32 SqMask;
+	u32* SqArray;
+	io_uring_sqe* Sqes;
+
+	u32* CqHead;
+	u32* CqTail;
+	u32 CqMask;
+	io_uring_cqe* Cqes;
+
+	u8* SqMap;
+	u64 SqMapSize;
+	u8* CqMap;
+	u64 CqMapSize;
+	u64 SqesMapSize;
+
+	u32 Unsubmitted;
+	u32 InFlight; // pushed ops not reaped yet
+};
+
+b32
+IoUringInit(io_uring_ring& Ring, u32 Entries)
+{
+	Ring = {};
+
+	io_uring_params Params = {};
+	Ring.Fd = static_cast<int>(syscall(__NR_io_uring_setup, Entries, &Params));
+	if (Ring.Fd < 0) return false;
+
+	Ring.SqMapSize = Params.sq_off.array + Params.sq_entries * sizeof(u32);
+	Ring.CqMapSize = Params.cq_off.cqes + Params.cq_entries * sizeof(io_uring_cqe);
+
+	// NOTE: newer kernels map both rings with one mmap
+	b32 SingleMap = (Params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (SingleMap)
+	{
+		Ring.SqMapSize = Ring.SqMapSize > Ring.CqMapSize ? Ring.SqMapSize : Ring.CqMapSize;
+		Ring.CqMapSize = Ring.SqMapSize;
+	}
+
+	void* SqMap = mmap(nullptr, Ring.SqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, Ring.Fd, IORING_OFF_SQ_RING);
+	void* CqMap = SingleMap ? SqMap :
+		mmap(nullptr, Ring.CqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, Ring.Fd, IORING_OFF_CQ_RING);
+
+	Ring.SqesMapSize = Params.sq_entries * sizeof(io_uring_sqe);
+	void* SqesMap = mmap(nullptr, Ring.SqesMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, Ring.Fd, IORING_OFF_SQES);
+
+	if ((SqMap == MAP_FAILED) || (CqMap == MAP_FAILED) || (SqesMap == MAP_FAILED))
+	{
+		if (SqMap != MAP_FAILED) munmap(SqMap, Ring.SqMapSize);
+		if (!SingleMap && (CqMap != MAP_FAILED)) munmap(CqMap, Ring.CqMapSize);
+		if (SqesMap != MAP_FAILED) munmap(SqesMap, Ring.SqesMapSize);
+		close(Ring.Fd);
+		Ring = {};
+		return false;
+	}
+
+	Ring.SqMap = static_cast<u8*>(SqMap);
+	Ring.CqMap = static_cast<u8*>(CqMap);
+	Ring.SqHead = reinterpret_cast<u32*>(Ring.SqMap + Params.sq_off.head);
+	Ring.SqTail = reinterpret_cast<u32*>(Ring.SqMap + Params.sq_off.tail);
+	Ring.SqMask = *reinterpret_cast<u32*>(Ring.SqMap + Params.sq_off.ring_mask);
+	Ring.SqArray = reinterpret_cast<u32*>(Ring.SqMap + Params.sq_off.array);
+	Ring.Sqes = static_cast<io_uring_sqe*>(SqesMap);
+
+	Ring.CqHead = reinterpret_cast<u32*>(Ring.CqMap + Params.cq_off.head);
+	Ring.CqTail = reinterpret_cast<u32*>(Ring.CqMap + Params.cq_off.tail);
+	Ring.CqMask = *reinterpret_cast<u32*>(Ring.CqMap + Params.cq_off.ring_mask);
+	Ring.Cqes = reinterpret_cast<io_uring_cqe*>(Ring.CqMap + Params.cq_off.cqes);
+
+	return true;
+}
+
+void
+IoUringRelease(io_uring_ring& Ring)
+{
+	if (Ring.Fd <= 0) return;
+
+	munmap(Ring.Sqes, Ring.SqesMapSize);
+	if (Ring.CqMap != Ring.SqMap) munmap(Ring.CqMap, Ring.CqMapSize);
+	munmap(Ring.SqMap, Ring.SqMapSize);
+	close(Ring.Fd);
+
+	Ring = {};
+}
+
+inline io_uring_sqe&
+IoUringNextSqe(io_uring_ring& Ring)
+{
+	io_uring_sqe& Result = Ring.Sqes[*Ring.SqTail & Ring.SqMask];
+	memset(&Result, 0, sizeof(Result));
+	return Result;
+}
+
+inline void
+IoUringCommitSqe(io_uring_ring& Ring)
+{
+	u32 Tail = *Ring.SqTail;
+	u32 Index = Tail & Ring.SqMask;
+
+	Ring.SqArray[Index] = Index;
+	__atomic_store_n(Ring.SqTail, Tail + 1, __ATOMIC_RELEASE);
+	Ring.Unsubmitted++;
+	Ring.InFlight++;
+}
+
+// NOTE: caller keeps in flight count <= ring entries, so SQ never overflows
+inline void
+IoUringPush(io_uring_ring& Ring, const async_io_op& Op)
+{
+	io_uring_sqe& Sqe = IoUringNextSqe(Ring);
+	Sqe.opcode = Op.Write ? IORING_OP_WRITE : IORING_OP_READ;
+	Sqe.fd = Op.File;
+	Sqe.addr = reinterpret_cast<u64>(Op.Buffer);
+	Sqe.len = Op.Size;
+	Sqe.off = Op.Offset;
+	Sqe.user_data = Op.Tag;
+	IoUringCommitSqe(Ring);
+}
+
+// cancels op with TargetTag if it's still pending, cancel completes with own Tag
+inline void
+IoUringPushCancel(io_uring_ring& Ring, u32 TargetTag, u32 Tag)
+{
+	io_uring_sqe& Sqe = IoUringNextSqe(Ring);
+	Sqe.opcode = IORING_OP_ASYNC_CANCEL;
+	Sqe.fd = -1;
+	Sqe.addr = TargetTag;
+	Sqe.user_data = Tag;
+	IoUringCommitSqe(Ring);
+}
+
+// submits pushed ops and waits for at least one completion, returns reaped count, 0 on ring failure
+u32
+IoUringWait(io_uring_ring& Ring, async_io_done* Done, u32 MaxCount)
+{
+	u32 Head = *Ring.CqHead;
+	u32 Tail = __atomic_load_n(Ring.CqTail, __ATOMIC_ACQUIRE);
+
+	while (Ring.Unsubmitted || (Head == Tail))
+	{
+		u32 Flags = Head == Tail ? IORING_ENTER_GETEVENTS : 0;
+		s64 Entered = syscall(__NR_io_uring_enter, Ring.Fd, Ring.Unsubmitted, Flags ? 1 : 0, Flags, nullptr, 0);
+		if (Entered < 0)
+		{
+			if ((errno != EINTR) && (errno != EAGAIN) && (errno != EBUSY)) return 0;
+		}
+		else
+		{
+			Ring.Unsubmitted -= static_cast<u32>(Entered);
+		}
+
+		Tail = __atomic_load_n(Ring.CqTail, __ATOMIC_ACQUIRE);
+	}
+
+	u32 Count = 0;
+	for (; (Head != Tail) && (Count < MaxCount); Head++, Count++)
+	{
+		const io_uring_cqe& Cqe = Ring.Cqes[Head & Ring.CqMask];
+		Done[Count].Tag = static_cast<u32>(Cqe.user_data);
+		Done[Count].Result = Cqe.res;
+	}
+
+	__atomic_store_n(Ring.CqHead, Head, __ATOMIC_RELEASE);
+	Ring.InFlight -= Count;
+	return Count;
+}
+
+#endif
+
+class AsyncIO
+{
+#if defined(__linux__)
+	static constexpr u32 NOTIFY_TAG = MaxUInt32;
+	static constexpr u32 CANCEL_TAG = MaxUInt32 - 1;
+
+	io_uring_ring Ring;
+	int NotifyFd;
+	u64 NotifyValue;
+#endif
+	b32 UseRing;
+	b32 DoneLeft; // completions queued past MaxCount of last wait
+
+	std::vector<std::thread> Threads;
+	std::mutex Lock;
+	std::condition_variable OpReady;
+	std::condition_variable DoneReady;
+	std::deque<async_io_op> Ops;
+	std::deque<async_io_done> Done;
+	b32 Stop;
+
+public:
+	AsyncIO() : UseRing(false), DoneLeft(false), Stop(false)
+	{
+#if defined(__linux__)
+		Ring = {};
+		NotifyFd = -1;
+#endif
+	}
+
+	~AsyncIO()
+	{
+		release();
+	}
+
+	// QueueDepth bounds I/O ops in flight, fallback pool is used when TryRing is false or ring setup fails
+	void init(u32 QueueDepth, u32 FallbackThreads, b32 TryRing)
+	{
+		release();
+
+#if defined(__linux__)
+		if (TryRing)
+		{
+			NotifyFd = eventfd(0, EFD_CLOEXEC);
+			UseRing = (NotifyFd >= 0) && IoUringInit(Ring, QueueDepth + 1);
+			if (UseRing)
+			{
+				armNotify();
+				return;
+			}
+
+			if (NotifyFd >= 0) close(NotifyFd);
+			NotifyFd = -1;
+		}
+#endif
+
+		Stop = false;
+		FallbackThreads = FallbackThreads ? FallbackThreads : 1;
+		for (u32 i = 0; i < FallbackThreads; i++)
+		{
+			Threads.emplace_back([this]() { fallbackLoop(); });
+		}
+	}
+
+	// Waits for all ops in flight, so their buffers can be freed after release. Returns false only if
+	// ring failed before every op was reaped, kernel may still access their buffers then.
+	// NOTE: closing ring doesn't wait for its ops, teardown is asynchronous, so pending ops are reaped first
+	b32 release()
+	{
+		b32 Result = true;
+
+#if defined(__linux__)
+		if (UseRing)
+		{
+			Result = drainRing();
+			IoUringRelease(Ring);
+			close(NotifyFd);
+			NotifyFd = -1;
+		}
+#endif
+		UseRing = false;
+		DoneLeft = false;
+
+		{
+			std::lock_guard<std::mutex> Guard(Lock);
+			Stop = true;
+		}
+		OpReady.notify_all();
+
+		for (auto& Thread : Threads)
+		{
+			Thread.join();
+		}
+		Threads.clear();
+		Ops.clear();
+		Done.clear();
+
+		return Result;
+	}
+
+	const char* backendName() const
+	{
+		const char* Result = UseRing ? "io_uring" : "thread pool";
+		return Result;
+	}
+
+	// NOTE: only from thread that waits
+	void submit(const async_io_op& Op)
+	{
+#if defined(__linux__)
+		if (UseRing)
+		{
+			IoUringPush(Ring, Op);
+			return;
+		}
+#endif
+		{
+			std::lock_guard<std::mutex> Guard(Lock);
+			Ops.push_back(Op);
+		}
+		OpReady.notify_one();
+	}
+
+	// posts completion with Result 0 from any thread. Returns false if waiter couldn't be woken (eventfd
+	// write failed for other reason than signal), completion stays queued for next wait.
+	b32 notify(u32 Tag)
+	{
+		{
+			std::lock_guard<std::mutex> Guard(Lock);
+			Done.push_back(async_io_done{Tag, 0});
+		}
+
+#if defined(__linux__)
+		if (UseRing)
+		{
+			u64 One = 1;
+			ssize_t Written;
+			do
+			{
+				Written = write(NotifyFd, &One, sizeof(One));
+			} while ((Written < 0) && (errno == EINTR));
+
+			b32 Result = Written == sizeof(One);
+			return Result;
+		}
+#endif
+		DoneReady.notify_one();
+		return true;
+	}
+
+	// blocks until at least one completion, caller must have ops or notifies pending.
+	// Returns completion count, 0 if ring failed.
+	u32 wait(async_io_done* Out, u32 MaxCount)
+	{
+#if defined(__linux__)
+		if (UseRing)
+		{
+			for (;;)
+			{
+				// NOTE: completions left from last wait are taken without blocking on ring
+				u32 Count = 0;
+				if (!DoneLeft)
+				{
+					Count = IoUringWait(Ring, Out, MaxCount);
+					if (!Count) return 0;
+				}
+
+				// NOTE: eventfd read resets counter, so all posted completions are taken on its completion
+				u32 Result = 0;
+				b32 Notified = false;
+				for (u32 i = 0; i < Count; i++)
+				{
+					if (Out[i].Tag == NOTIFY_TAG) Notified = true;
+					else Out[Result++] = Out[i];
+				}
+
+				if (Notified) armNotify();
+
+				if (Notified || DoneLeft)
+				{
+					std::lock_guard<std::mutex> Guard(Lock);
+					for (; !Done.empty() && (Result < MaxCount); Result++)
+					{
+						Out[Result] = Done.front();
+						Done.pop_front();
+					}
+
+					// NOTE: leftovers don't have eventfd write of their own anymore
+					DoneLeft = !Done.empty();
+				}
+
+				if (Result) return Result;
+			}
+		}
+#endif
+		std::unique_lock<std::mutex> Guard(Lock);
+		DoneReady.wait(Guard, [this]() { return !Done.empty(); });
+
+		u32 Result = 0;
+		for (; !Done.empty() && (Result < MaxCount); Result++)
+		{
+			Out[Result] = Done.front();
+			Done.pop_front();
+		}
+		return Result;
+	}
+
+private:
+#if defined(__linux__)
+	// armed notify read never completes on its own, so it's cancelled, then every op is reaped
+	b32 drainRing()
+	{
+		IoUringPushCancel(Ring, NOTIFY_TAG, CANCEL_TAG);
+
+		async_io_done Reaped[16];
+		while (Ring.InFlight)
+		{
+			if (!IoUringWait(Ring, Reaped, ArrayCount(Reaped))) return false;
+		}
+
+		return true;
+	}
+
+	void armNotify()
+	{
+		async_io_op Op = {};
+		Op.File = NotifyFd;
+		Op.Buffer = reinterpret_cast<u8*>(&NotifyValue);
+		Op.Size = sizeof(NotifyValue);
+		Op.Tag = NOTIFY_TAG;
+		IoUringPush(Ring, Op);
+	}
+#endif
+
+	void fallbackLoop()
+	{
+		for (;;)
+		{
+			async_io_op Op;
+			{
+				std::unique_lock<std::mutex> Guard(Lock);
+				OpReady.wait(Guard, [this]() { return Stop || !Ops.empty(); });
+				if (Ops.empty()) return;
+
+				Op = Ops.front();
+				Ops.pop_front();
+			}
+
+			async_io_done Result;
+			Result.Tag = Op.Tag;
+			Result.Result = IOFileTransfer(Op);
+
+			{
+				std::lock_guard<std::mutex> Guard(Lock);
+				Done.push_back(Result);
+			}
+			DoneReady.notify_one();
+		}
+	}
+};
@@ -0,0 +1,544 @@
+// Block sorting: SA-IS suffix array -> BWT -> MTF + RLE0 -> block rANS.
+//
+// BWT uses virtual sentinel, so n + 1 rotations: row 0 is "$T", stored last column skips '$'.
+// Encoder stores row of suffix at start of every of BWT_WALK_COUNT segments, so inverse runs
+// that many independent walks interleaved (one packed random access per byte each).
+//
+// MTF output is coded as bytes: zero runs in bijective base 2 (RUNA = 0, RUNB = 1), value v as v + 1,
+// values >= 254 as escape 255 and one extra byte. With ContextCount > 1 stream is split by previous
+// byte (order-1 bucketed), every context has own rANS table.
+//
+// Container (u32 words): u64 TotalSize, u32 BlockSize, u32 ContextCount, then per block:
+//   u32 RawSize, u32 WalkStart[BWT_WALK_COUNT], ContextCount x (u32 WordCount, rANS block)
+static constexpr u32 BWT_MAX_BLOCK_SIZE = (1 << 24) - 1; // row index + byte packed in u32
+static constexpr u32 BWT_WALK_COUNT = 4;
+static constexpr u32 BWT_MAX_CONTEXTS = 4;
+static constexpr u32 BWT_RUNA = 0;
+static constexpr u32 BWT_RUNB = 1;
+static constexpr u32 BWT_ESCAPE = 255;
+
+struct bwt_params
+{
+	u32 BlockSize;
+	u32 ContextCount; // 1 - order-0, up to BWT_MAX_CONTEXTS - bucketed order-1
+};
+
+inline bwt_params
+BwtDefaultParams()
+{
+	bwt_params Result = {};
+	Result.BlockSize = 1 << 22;
+	Result.ContextCount = 1;
+	return Result;
+}
+
+// SA-IS (Nong, Zhang, Chan), suffix array of Text[0..n) with virtual sentinel, alphabet [0, K)
+template<typename T> void
+SaisBuckets(const T* Text, s32 n, s32* Bucket, s32 K, b32 End)
+{
+	for (s32 c = 0; c < K; c++) Bucket[c] = 0;
+	for (s32 i = 0; i < n; i++) Bucket[Text[i]]++;
+
+	s32 Sum = 0;
+	for (s32 c = 0; c < K; c++)
+	{
+		Sum += Bucket[c];
+		Bucket[c] = End ? Sum : Sum - Bucket[c];
+	}
+}
+
+template<typename T> void
+SaisInduce(const T* Text, s32* SA, s32 n, const u8* IsS, s32* Bucket, s32 K)
+{
+	SaisBuckets(Text, n, Bucket, K, false);
+
+	// NOTE: last suffix is L type and comes right after sentinel
+	SA[Bucket[Text[n - 1]]++] = n - 1;
+	for (s32 i = 0; i < n; i++)
+	{
+		s32 j = SA[i] - 1;
+		if ((SA[i] > 0) && !IsS[j]) SA[Bucket[Text[j]]++] = j;
+	}
+
+	SaisBuckets(Text, n, Bucket, K, true);
+	for (s32 i = n - 1; i >= 0; i--)
+	{
+		s32 j = SA[i] - 1;
+		if ((SA[i] > 0) && IsS[j]) SA[--Bucket[Text[j]]] = j;
+	}
+}
+
+template<typename T> void
+Sais(const T* Text, s32* SA, s32 n, s32 K)
+{
+	if (n <= 1)
+	{
+		if (n) SA[0] = 0;
+		return;
+	}
+
+	std::vector<u8> IsS(n);
+	std::vector<s32> Bucket(K);
+
+	IsS[n - 1] = false;
+	for (s32 i = n - 2; i >= 0; i--)
+	{
+		IsS[i] = (Text[i] < Text[i + 1]) || ((Text[i] == Text[i + 1]) && IsS[i + 1]);
+	}
+
+	auto IsLMS = [&IsS](s32 i) { return (i > 0) && IsS[i] && !IsS[i - 1]; };
+
+	// sort LMS substrings
+	for (s32 i = 0; i < n; i++) SA[i] = -1;
+
+	SaisBuckets(Text, n, Bucket.data(), K, true);
+	for (s32 i = 1; i < n; i++)
+	{
+		if (IsLMS(i)) SA[--Bucket[Text[i]]] = i;
+	}
+
+	SaisInduce(Text, SA, n, IsS.data(), Bucket.data(), K);
+
+	s32 LmsCount = 0;
+	for (s32 i = 0; i < n; i++)
+	{
+		if (IsLMS(SA[i])) SA[LmsCount++] = SA[i];
+	}
+
+	// name LMS substrings, equal substrings get equal name
+	for (s32 i = LmsCount; i < n; i++) SA[i] = -1;
+
+	s32 NameCount = 0;
+	s32 Prev = -1;
+	for (s32 i = 0; i < LmsCount; i++)
+	{
+		s32 Pos = SA[i];
+		b32 Diff = false;
+
+		for (s32 d = 0;; d++)
+		{
+			if ((Prev < 0) || ((Pos + d) == n) || ((Prev + d) == n) ||
+				(Text[Pos + d] != Text[Prev + d]) || (IsS[Pos + d] != IsS[Prev + d]))
+			{
+				Diff = true;
+				break;
+			}
+
+			if ((d > 0) && (IsLMS(Pos + d) || IsLMS(Prev + d))) break;
+		}
+
+		if (Diff)
+		{
+			NameCount++;
+			Prev = Pos;
+		}
+
+		SA[LmsCount + (Pos >> 1)] = NameCount - 1;
+	}
+
+	for (s32 i = n - 1, j = n - 1; i >= LmsCount; i--)
+	{
+		if (SA[i] >= 0) SA[j--] = SA[i];
+	}
+
+	// sort reduced string, recursion only if names aren't unique
+	s32* Reduced = SA + n - LmsCount;
+	if (NameCount < LmsCount)
+	{
+		Sais(Reduced, SA, LmsCount, NameCount);
+	}
+	else
+	{
+		for (s32 i = 0; i < LmsCount; i++) SA[Reduced[i]] = i;
+	}
+
+	// induce whole suffix array from sorted LMS suffixes
+	for (s32 i = 1, j = 0; i < n; i++)
+	{
+		if (IsLMS(i)) Reduced[j++] = i;
+	}
+
+	for (s32 i = 0; i < LmsCount; i++) SA[i] = Reduced[SA[i]];
+	for (s32 i = LmsCount; i < n; i++) SA[i] = -1;
+
+	SaisBuckets(Text, n, Bucket.data(), K, true);
+	for (s32 i = LmsCount - 1; i >= 0; i--)
+	{
+		s32 j = SA[i];
+		SA[i] = -1;
+		SA[--Bucket[Text[j]]] = j;
+	}
+
+	SaisInduce(Text, SA, n, IsS.data(), Bucket.data(), K);
+}
+
+inline u32
+BwtSegmentSize(u32 n)
+{
+	u32 Result = (n + BWT_WALK_COUNT - 1) / BWT_WALK_COUNT;
+	return Result;
+}
+
+// Out gets n bytes, WalkStart row of suffix at every segment start. SA is scratch of n entries.
+void
+BwtForward(const u8* In, u8* Out, u32 n, s32* SA, u32* WalkStart)
+{
+	Assert(n && (n <= BWT_MAX_BLOCK_SIZE));
+
+	Sais(In, SA, static_cast<s32>(n), 256);
+
+	u32 Segment = BwtSegmentSize(n);
+	for (u32 i = 0; i < BWT_WALK_COUNT; i++) WalkStart[i] = 0;
+
+	Out[0] = In[n - 1];
+	u32 k = 1;
+	for (u32 i = 0; i < n; i++)
+	{
+		u32 Suffix = static_cast<u32>(SA[i]);
+		u32 Row = i + 1;
+
+		if (Suffix) Out[k++] = In[Suffix - 1];
+		if ((Suffix % Segment) == 0) WalkStart[Suffix / Segment] = Row;
+	}
+
+	Assert(k == n);
+}
+
+// Packed T vector: entry of row j holds next row in high 24 bits and its last column byte in low 8,
+// so every output byte costs one dependent random load. Walks are independent, so their loads overlap.
+void
+BwtInverse(const u8* In, u8* Out, u32 n, const u32* WalkStart, u32* Vec)
+{
+	Assert(n && (n <= BWT_MAX_BLOCK_SIZE));
+
+	u32 Primary = WalkStart[0];
+
+	u32 Base[256] = {};
+	for (u32 i = 0; i < n; i++) Base[In[i]]++;
+
+	u32 Sum = 1;
+	for (u32 c = 0; c < 256; c++)
+	{
+		u32 Count = Base[c];
+		Base[c] = Sum;
+		Sum += Count;
+	}
+
+	// row Primary holds '$' in last column, rows after it are shifted by one in stored column
+	Vec[0] = Primary << 8;
+	for (u32 Row = 0; Row < Primary; Row++)
+	{
+		u8 c = In[Row];
+		Vec[Base[c]++] = (Row << 8) | c;
+	}
+
+	for (u32 Row = Primary + 1; Row <= n; Row++)
+	{
+		u8 c = In[Row - 1];
+		Vec[Base[c]++] = (Row << 8) | c;
+	}
+
+	u32 Segment = BwtSegmentSize(n);
+	u32 Pos[BWT_WALK_COUNT];
+	u32 End[BWT_WALK_COUNT];
+	u32 Row[BWT_WALK_COUNT];
+	u32 MinLen = Segment;
+
+	for (u32 i = 0; i < BWT_WALK_COUNT; i++)
+	{
+		u64 Start = static_cast<u64>(i) * Segment;
+		Pos[i] = Start < n ? static_cast<u32>(Start) : n;
+		End[i] = (Start + Segment) < n ? static_cast<u32>(Start + Segment) : n;
+		Row[i] = WalkStart[i];
+		MinLen = (End[i] - Pos[i]) < MinLen ? (End[i] - Pos[i]) : MinLen;
+	}
+
+	for (u32 k = 0; k < MinLen; k++)
+	{
+		for (u32 i = 0; i < BWT_WALK_COUNT; i++)
+		{
+			u32 Entry = Vec[Row[i]];
+			Out[Pos[i]++] = static_cast<u8>(Entry);
+			Row[i] = Entry >> 8;
+		}
+	}
+
+	for (u32 i = 0; i < BWT_WALK_COUNT; i++)
+	{
+		while (Pos[i] < End[i])
+		{
+			u32 Entry = Vec[Row[i]];
+			Out[Pos[i]++] = static_cast<u8>(Entry);
+			Row[i] = Entry >> 8;
+		}
+	}
+}
+
+inline void
+BwtPutRun(u8* Out, u32& OutCount, u32 Run)
+{
+	while (Run)
+	{
+		if (Run & 1)
+		{
+			Out[OutCount++] = BWT_RUNA;
+			Run = (Run - 1) >> 1;
+		}
+		else
+		{
+			Out[OutCount++] = BWT_RUNB;
+			Run = (Run - 2) >> 1;
+		}
+	}
+}
+
+// Out needs 2 * n bytes in worst case (every value escaped), returns byte count
+u32
+BwtMtfRleEncode(const u8* In, u32 n, u8* Out)
+{
+	u8 Order[256];
+	for (u32 i = 0; i < 256; i++) Order[i] = static_cast<u8>(i);
+
+	u32 OutCount = 0;
+	u32 Run = 0;
+
+	for (u32 i = 0; i < n; i++)
+	{
+		u8 c = In[i];
+		if (Order[0] == c)
+		{
+			Run++;
+			continue;
+		}
+
+		BwtPutRun(Out, OutCount, Run);
+		Run = 0;
+
+		u32 Index = 1;
+		while (Order[Index] != c) Index++;
+
+		memmove(Order + 1, Order, Index);
+		Order[0] = c;
+
+		if (Index < (BWT_ESCAPE - 1))
+		{
+			Out[OutCount++] = static_cast<u8>(Index + 1);
+		}
+		else
+		{
+			Out[OutCount++] = BWT_ESCAPE;
+			Out[OutCount++] = static_cast<u8>(Index - (BWT_ESCAPE - 1));
+		}
+	}
+
+	BwtPutRun(Out, OutCount, Run);
+	return OutCount;
+}
+
+// returns false if stream doesn't decode to exactly n bytes
+b32
+BwtMtfRleDecode(const u8* In, u32 InCount, u8* Out, u32 n)
+{
+	u8 Order[256];
+	for (u32 i = 0; i < 256; i++) Order[i] = static_cast<u8>(i);
+
+	u32 OutCount = 0;
+	u32 i = 0;
+
+	while (i < InCount)
+	{
+		u32 Sym = In[i++];
+		if (Sym <= BWT_RUNB)
+		{
+			u64 Run = 0;
+			u64 Weight = 1;
+
+			i--;
+			while ((i < InCount) && (In[i] <= BWT_RUNB))
+			{
+				Run += (In[i++] + 1) * Weight;
+				Weight <<= 1;
+				if (Run > (n - OutCount)) return false;
+			}
+
+			memset(Out + OutCount, Order[0], Run);
+			OutCount += static_cast<u32>(Run);
+			continue;
+		}
+
+		u32 Index = Sym - 1;
+		if (Sym == BWT_ESCAPE)
+		{
+			if ((i == InCount) || (In[i] > 1)) return false;
+			Index = (BWT_ESCAPE - 1) + In[i++];
+		}
+
+		if (OutCount == n) return false;
+
+		u8 c = Order[Index];
+		memmove(Order + 1, Order, Index);
+		Order[0] = c;
+		Out[OutCount++] = c;
+	}
+
+	b32 Result = OutCount == n;
+	return Result;
+}
+
+inline u32
+BwtContext(u8 PrevSym, u32 ContextCount)
+{
+	u32 Result = PrevSym < (ContextCount - 1) ? PrevSym : (ContextCount - 1);
+	return Result;
+}
+
+struct bwt_workspace
+{
+	std::vector<s32> SA;
+	std::vector<u32> Vec;
+	std::vector<u8> Block;
+	std::vector<u8> Sym;
+	std::vector<u8> Context[BWT_MAX_CONTEXTS];
+	std::vector<u32> Scratch;
+	rans_block_enc_ctx EncCtx;
+	rans_block_dec_ctx DecCtx;
+};
+
+void
+BwtCompress(const u8* Data, u64 Size, std::vector<u32>& Out, const bwt_params& Params)
+{
+	Assert(Params.BlockSize && (Params.BlockSize <= BWT_MAX_BLOCK_SIZE));
+	Assert(Params.ContextCount && (Params.ContextCount <= BWT_MAX_CONTEXTS));
+
+	Out.clear();
+	Out.push_back(static_cast<u32>(Size));
+	Out.push_back(static_cast<u32>(Size >> 32));
+	Out.push_back(Params.BlockSize);
+	Out.push_back(Params.ContextCount);
+
+	bwt_workspace W;
+
+	u32 MaxBlock = Size < Params.BlockSize ? static_cast<u32>(Size) : Params.BlockSize;
+	W.SA.resize(MaxBlock);
+	W.Block.resize(MaxBlock);
+	W.Sym.resize(2ull * MaxBlock);
+
+	for (u64 BlockStart = 0; BlockStart < Size; BlockStart += Params.BlockSize)
+	{
+		u32 n = static_cast<u32>((Size - BlockStart) < Params.BlockSize ? (Size - BlockStart) : Params.BlockSize);
+
+		u32 WalkStart[BWT_WALK_COUNT];
+		BwtForward(Data + BlockStart, W.Block.data(), n, W.SA.data(), WalkStart);
+		u32 SymCount = BwtMtfRleEncode(W.Block.data(), n, W.Sym.data());
+
+		for (u32 c = 0; c < Params.ContextCount; c++) W.Context[c].clear();
+
+		u8 Prev = 0;
+		for (u32 i = 0; i < SymCount; i++)
+		{
+			W.Context[BwtContext(Prev, Params.ContextCount)].push_back(W.Sym[i]);
+			Prev = W.Sym[i];
+		}
+
+		Out.push_back(n);
+		Out.insert(Out.end(), WalkStart, WalkStart + BWT_WALK_COUNT);
+
+		for (u32 c = 0; c < Params.ContextCount; c++)
+		{
+			const std::vector<u8>& Stream = W.Context[c];
+			if (Stream.empty())
+			{
+				Out.push_back(0);
+				continue;
+			}
+
+			W.Scratch.resize((RansBlockBound(Stream.size()) + sizeof(u32) - 1) / sizeof(u32));
+			u32* StreamEnd = W.Scratch.data() + W.Scratch.size();
+			u32* Begin = RansBlockEncode(W.EncCtx, StreamEnd, Stream.data(), static_cast<u32>(Stream.size()));
+
+			Out.push_back(static_cast<u32>(StreamEnd - Begin));
+			Out.insert(Out.end(), Begin, StreamEnd);
+		}
+	}
+}
+
+// returns decoded size, 0 on malformed stream or if it doesn't fit in DestCapacity
+u64
+BwtDecompress(u8* Dest, u64 DestCapacity, const u32* In, u64 InWordCount)
+{
+	if (InWordCount < 4) return 0;
+
+	u64 TotalSize = In[0] | (static_cast<u64>(In[1]) << 32);
+	u32 BlockSize = In[2];
+	u32 ContextCount = In[3];
+	if ((TotalSize > DestCapacity) || !BlockSize || (BlockSize > BWT_MAX_BLOCK_SIZE)) return 0;
+	if (!ContextCount || (ContextCount > BWT_MAX_CONTEXTS)) return 0;
+
+	const u32* InEnd = In + InWordCount;
+	In += 4;
+
+	bwt_workspace W;
+
+	u32 MaxBlock = TotalSize < BlockSize ? static_cast<u32>(TotalSize) : BlockSize;
+	W.Vec.resize(MaxBlock + 1ull);
+	W.Block.resize(MaxBlock);
+	W.Sym.resize(2ull * MaxBlock);
+	for (u32 c = 0; c < ContextCount; c++) W.Context[c].resize(2ull * MaxBlock);
+
+	u64 Done = 0;
+	while (Done < TotalSize)
+	{
+		if ((InEnd - In) < (1 + BWT_WALK_COUNT)) return 0;
+
+		u32 n = *In++;
+		const u32* WalkStart = In;
+		In += BWT_WALK_COUNT;
+
+		if (!n || (n > MaxBlock) || (n > (TotalSize - Done))) return 0;
+		for (u32 i = 0; i < BWT_WALK_COUNT; i++)
+		{
+			if (WalkStart[i] > n) return 0;
+		}
+
+		u32 ContextSize[BWT_MAX_CONTEXTS];
+		u32 SymCount = 0;
+		for (u32 c = 0; c < ContextCount; c++)
+		{
+			if (In == InEnd) return 0;
+
+			u32 WordCount = *In++;
+			ContextSize[c] = 0;
+			if (!WordCount) continue;
+			if (static_cast<u64>(InEnd - In) < WordCount) return 0;
+
+			u32* StreamIn = const_cast<u32*>(In);
+			ContextSize[c] = RansBlockDecode(W.DecCtx, W.Context[c].data(), 2 * MaxBlock, &StreamIn, StreamIn + WordCount);
+			if (!ContextSize[c]) return 0;
+
+			In += WordCount;
+			SymCount += ContextSize[c];
+		}
+
+		if (SymCount > (2ull * MaxBlock)) return 0;
+
+		// merge context streams back in coding order
+		u32 ContextPos[BWT_MAX_CONTEXTS] = {};
+		u8 Prev = 0;
+		for (u32 i = 0; i < SymCount; i++)
+		{
+			u32 c = BwtContext(Prev, ContextCount);
+			if (ContextPos[c] == ContextSize[c]) return 0;
+
+			Prev = W.Context[c][ContextPos[c]++];
+			W.Sym[i] = Prev;
+		}
+
+		if (!BwtMtfRleDecode(W.Sym.data(), SymCount, W.Block.data(), n)) return 0;
+
+		BwtInverse(W.Block.data(), Dest + Done, n, WalkStart, W.Vec.data());
+		Done += n;
+	}
+
+	u64 Result = TotalSize;
+	return Result;
+}
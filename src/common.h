@@ -3,7 +3,9 @@
 
 #include <fstream>
 #include <cstdio>
+#include <cstdlib>
 #include <cassert>
+#include <cstring>
 #include <vector>
 #include <limits>
 #include <stdint.h>
@@ -35,11 +37,21 @@ static constexpr f64 MaxF64 = std::numeric_limits<f64>::max();
 
 static constexpr u32 RUNS_COUNT = 10;
 
+inline void
+VerifyFailed(const char* Expression, const char* File, int Line)
+{
+	fprintf(stderr, "Verify failed: %s, %s:%d\n", Expression, File, Line);
+	abort();
+}
+
 #ifdef _DEBUG
 	//#define Assert(Expression) assert(Expression)
 #define Assert(Expression) if (!(Expression)) *((int *)0) = 0;
+#define Verify(Expression) Assert(Expression)
 #else
 #define Assert(Expression)
+// NOTE: checked in release too, failure is reported and aborts
+#define Verify(Expression) ((Expression) ? (void)0 : VerifyFailed(#Expression, __FILE__, __LINE__))
 #endif
 
 #define ArrayCount(Array) (sizeof(Array) / sizeof((Array)[0]))
@@ -53,9 +65,14 @@ struct array2d
 	T E[Dim0][Dim1];
 };
 
+// NOTE: portable intrinsics. Bit scans return 0 for 0 on every compiler
+// (BSF/BSR leave result undefined, __builtin_ctz/clz(0) is UB), so callers get same result everywhere.
+// MAY_ALIAS marks headers that are written over memory of other types (allocator blocks),
+// GCC and Clang apply type based alias analysis to them, MSVC doesn't.
 #if _MSC_VER
 
 #define ALIGN(type, name, N) __declspec(align(N)) type name
+#define MAY_ALIAS
 #include <intrin.h>
 
 static inline u64
@@ -77,14 +94,48 @@ FindLeastSignificantSetBit32(u32 Source)
 {
 	u32 Result;
 	u32 S = _BitScanForward((unsigned long*)&Result, Source);
+	return S ? Result : 0;
+}
 
-	return Result;
+inline u32
+FindMostSignificantSetBit64(u64 Source)
+{
+	u32 Result;
+	u32 S = _BitScanReverse64((unsigned long*)&Result, Source);
+	return S ? Result : 0;
+}
+
+inline u32
+FindLeastSignificantSetBit64(u64 Source)
+{
+	u32 Result;
+	u32 S = _BitScanForward64((unsigned long*)&Result, Source);
+	return S ? Result : 0;
+}
+
+inline u32
+ByteSwap32(u32 Source)
+{
+	return _byteswap_ulong(Source);
+}
+
+inline u64
+ByteSwap64(u64 Source)
+{
+	return _byteswap_uint64(Source);
+}
+
+inline void
+PrefetchRead(const void* Ptr)
+{
+	_mm_prefetch(static_cast<const char*>(Ptr), _MM_HINT_T0);
 }
 
 #elif defined(__GNUC__)
 #include <x86intrin.h>
 
 #define ALIGN(type, name, N) type name __attribute__ ((aligned(N)))
+#define MAY_ALIAS __attribute__((may_alias))
 
 static inline u64
 MulHi64(u64 a, u64 b)
@@ -95,14 +146,47 @@ MulHi64(u64 a, u64 b)
 inline u32
 FindMostSignificantSetBit32(u32 Source)
 {
-	u32 Result = 31 - __builtin_clz(Source);
+	u32 Result = Source ? 31 - __builtin_clz(Source) : 0;
 	return Result;
 }
 
 inline u32
 FindLeastSignificantSetBit32(u32 Source)
-{	
-	#error "Function not implemented"
+{
+	u32 Result = Source ? __builtin_ctz(Source) : 0;
+	return Result;
+}
+
+inline u32
+FindMostSignificantSetBit64(u64 Source)
+{
+	u32 Result = Source ? 63 - __builtin_clzll(Source) : 0;
+	return Result;
+}
+
+inline u32
+FindLeastSignificantSetBit64(u64 Source)
+{
+	u32 Result = Source ? __builtin_ctzll(Source) : 0;
+	return Result;
+}
+
+inline u32
+ByteSwap32(u32 Source)
+{
+	return __builtin_bswap32(Source);
+}
+
+inline u64
+ByteSwap64(u64 Source)
+{
+	return __builtin_bswap64(Source);
+}
+
+inline void
+PrefetchRead(const void* Ptr)
+{
+	__builtin_prefetch(Ptr, 0, 3);
 }
 
 #endif
@@ -221,6 +305,73 @@ struct AccumTime
 	}
 };
 
+// dTLB load miss counter of calling thread (perf_event on Linux).
+// Valid is false if counter isn't available (other OS, perf_event_paranoid, no PMU in VM).
+#if defined(__linux__)
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+struct TlbMissCounter
+{
+	int Fd;
+	b32 Valid;
+
+	TlbMissCounter()
+	{
+		perf_event_attr Attr = {};
+		Attr.type = PERF_TYPE_HW_CACHE;
+		Attr.size = sizeof(Attr);
+		Attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		Attr.disabled = 1;
+		Attr.exclude_kernel = 1;
+		Attr.exclude_hv = 1;
+
+		Fd = static_cast<int>(syscall(SYS_perf_event_open, &Attr, 0, -1, -1, 0));
+		Valid = Fd >= 0;
+	}
+
+	~TlbMissCounter()
+	{
+		if (Valid) close(Fd);
+	}
+
+	inline void start()
+	{
+		if (Valid)
+		{
+			ioctl(Fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(Fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+
+	inline u64 end()
+	{
+		u64 Result = 0;
+		if (Valid)
+		{
+			ioctl(Fd, PERF_EVENT_IOC_DISABLE, 0);
+			if (read(Fd, &Result, sizeof(Result)) != sizeof(Result)) Result = 0;
+		}
+
+		return Result;
+	}
+};
+
+#else
+
+struct TlbMissCounter
+{
+	b32 Valid = false;
+
+	inline void start() {}
+	inline u64 end() { return 0; }
+};
+
+#endif
+
 inline b32
 IsPowerOf2(u32 Value)
 {
@@ -310,6 +461,135 @@ ReadEntireFile(const std::string& PathName)
 	return Result;
 }
 
+b32
+WriteEntireFile(const std::string& PathName, const u8* Data, u64 Size)
+{
+	std::ofstream file(PathName, std::ios::binary | std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cerr << "can't open file: " << PathName << "\n";
+		return false;
+	}
+
+	file.write(reinterpret_cast<const char*>(Data), Size);
+	b32 Result = file.good();
+	if (!Result)
+	{
+		std::cerr << "error during file writing!\n" << PathName << "\n";
+	}
+
+	return Result;
+}
+
+// Read only file mapping, pages are loaded on first touch and shared between processes mapping same file
+struct mapped_file
+{
+	const u8* Data;
+	u64 Size;
+#if defined(_WIN32)
+	HANDLE File;
+	HANDLE Mapping;
+#else
+	int File;
+#endif
+};
+
+#if defined(_WIN32)
+
+b32
+MapFile(mapped_file& Result, const std::string& PathName)
+{
+	Result = {};
+
+	Result.File = CreateFileA(PathName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (Result.File == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER FileSize;
+	if (!GetFileSizeEx(Result.File, &FileSize) || !FileSize.QuadPart)
+	{
+		CloseHandle(Result.File);
+		return false;
+	}
+
+	Result.Size = FileSize.QuadPart;
+	Result.Mapping = CreateFileMappingA(Result.File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (Result.Mapping)
+	{
+		Result.Data = static_cast<const u8*>(MapViewOfFile(Result.Mapping, FILE_MAP_READ, 0, 0, 0));
+	}
+
+	if (!Result.Data)
+	{
+		if (Result.Mapping) CloseHandle(Result.Mapping);
+		CloseHandle(Result.File);
+		return false;
+	}
+
+	return true;
+}
+
+void
+UnmapFile(mapped_file& File)
+{
+	if (File.Data)
+	{
+		UnmapViewOfFile(File.Data);
+		CloseHandle(File.Mapping);
+		CloseHandle(File.File);
+	}
+
+	File = {};
+}
+
+#else
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+b32
+MapFile(mapped_file& Result, const std::string& PathName)
+{
+	Result = {};
+
+	Result.File = open(PathName.c_str(), O_RDONLY);
+	if (Result.File < 0) return false;
+
+	struct stat Stat;
+	if ((fstat(Result.File, &Stat) != 0) || !Stat.st_size)
+	{
+		close(Result.File);
+		return false;
+	}
+
+	Result.Size = Stat.st_size;
+	void* Data = mmap(nullptr, Result.Size, PROT_READ, MAP_PRIVATE, Result.File, 0);
+	if (Data == MAP_FAILED)
+	{
+		close(Result.File);
+		Result = {};
+		return false;
+	}
+
+	Result.Data = static_cast<const u8*>(Data);
+	return true;
+}
+
+void
+UnmapFile(mapped_file& File)
+{
+	if (File.Data)
+	{
+		munmap(const_cast<u8*>(File.Data), File.Size);
+		close(File.File);
+	}
+
+	File = {};
+}
+
+#endif
+
 namespace fs = std::filesystem; //C++17
 
 void
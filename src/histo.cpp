@@ -0,0 +1,181 @@
+#include <cstring>
+#include <thread>
+
+// Byte histogram with interleaved sub-tables. Consecutive equal bytes increment different counters
+// so increments are not serialized on store-to-load forwarding of the same address.
+
+static constexpr u32 HISTO_SUB_TABLES = 4;
+static constexpr u64 HISTO_MAX_CHUNK = 1ull << 31; // keeps every u32 sub-table counter from overflow
+static constexpr u64 HISTO_PARALLEL_MIN_SIZE = 8 << 20;
+static constexpr u32 HISTO_SAMPLE_CHUNK = 64;
+
+static inline u64
+LoadU64(const u8* Ptr)
+{
+	u64 Result;
+	memcpy(&Result, Ptr, sizeof(Result));
+	return Result;
+}
+
+// 8 bytes per step, split to 32 bit halves to keep byte extraction cheap
+#define HistoCount8(Counts, Val) \
+	{ \
+		u32 Lo = static_cast<u32>(Val); \
+		u32 Hi = static_cast<u32>((Val) >> 32); \
+		Counts[0][(u8)Lo]++; \
+		Counts[1][(u8)(Lo >> 8)]++; \
+		Counts[2][(u8)(Lo >> 16)]++; \
+		Counts[3][Lo >> 24]++; \
+		Counts[0][(u8)Hi]++; \
+		Counts[1][(u8)(Hi >> 8)]++; \
+		Counts[2][(u8)(Hi >> 16)]++; \
+		Counts[3][Hi >> 24]++; \
+	}
+
+static void
+CountByteChunk(u32* Freq, const u8* Input, u64 Size)
+{
+	Assert(Size <= HISTO_MAX_CHUNK);
+
+	ALIGN(u32, Counts[HISTO_SUB_TABLES][256], 64);
+	ZeroSize(Counts, sizeof(Counts));
+
+	const u8* At = Input;
+	const u8* End = Input + Size;
+	const u8* End16 = Input + (Size & ~15ull);
+
+	while (At < End16)
+	{
+		u64 A = LoadU64(At);
+		u64 B = LoadU64(At + 8);
+		At += 16;
+
+		HistoCount8(Counts, A);
+		HistoCount8(Counts, B);
+	}
+
+	while (At < End)
+	{
+		Counts[0][*At++]++;
+	}
+
+	for (u32 i = 0; i < 256; i++)
+	{
+		Freq[i] = Counts[0][i] + Counts[1][i] + Counts[2][i] + Counts[3][i];
+	}
+}
+
+#undef HistoCount8
+
+template<typename T> inline void
+CountByteFast(T* Freq, const u8* Input, u64 Size)
+{
+	u32 ChunkFreq[256];
+
+	for (u64 Start = 0; Start < Size; Start += HISTO_MAX_CHUNK)
+	{
+		u64 Left = Size - Start;
+		u64 ChunkSize = Left < HISTO_MAX_CHUNK ? Left : HISTO_MAX_CHUNK;
+
+		CountByteChunk(ChunkFreq, Input + Start, ChunkSize);
+		for (u32 i = 0; i < 256; i++)
+		{
+			Freq[i] += ChunkFreq[i];
+		}
+	}
+}
+
+// ThreadCount == 0 uses all hardware threads; small inputs always counted on calling thread
+template<typename T> void
+CountByteParallel(T* Freq, const u8* Input, u64 Size, u32 ThreadCount = 0)
+{
+	if (ThreadCount == 0)
+	{
+		ThreadCount = std::thread::hardware_concurrency();
+	}
+
+	u64 MaxThreadCount = Size / HISTO_PARALLEL_MIN_SIZE;
+	ThreadCount = ThreadCount < MaxThreadCount ? ThreadCount : static_cast<u32>(MaxThreadCount);
+
+	if (ThreadCount < 2)
+	{
+		CountByteFast(Freq, Input, Size);
+		return;
+	}
+
+	std::vector<u64> PartFreq(ThreadCount * 256, 0);
+	std::vector<std::thread> Workers;
+	Workers.reserve(ThreadCount - 1);
+
+	u64 PartSize = Size / ThreadCount;
+	for (u32 i = 1; i < ThreadCount; i++)
+	{
+		u64 Start = PartSize * i;
+		u64 Count = (i + 1) == ThreadCount ? (Size - Start) : PartSize;
+		u64* Out = PartFreq.data() + i * 256;
+
+		Workers.emplace_back([Out, Input, Start, Count]() { CountByteFast(Out, Input + Start, Count); });
+	}
+
+	CountByteFast(PartFreq.data(), Input, PartSize);
+
+	for (auto& Worker : Workers)
+	{
+		Worker.join();
+	}
+
+	for (u32 Part = 0; Part < ThreadCount; Part++)
+	{
+		const u64* PartCount = PartFreq.data() + Part * 256;
+		for (u32 i = 0; i < 256; i++)
+		{
+			Freq[i] += static_cast<T>(PartCount[i]);
+		}
+	}
+}
+
+// Approximate histogram from evenly spread chunks, returns count of sampled bytes.
+// Used for fast decisions (block mode, codec choice), never for building coding tables.
+inline u64
+CountByteSampled(u32* Freq, const u8* Input, u64 Size, u32 SampleSize = 1 << 14)
+{
+	if (Size <= SampleSize)
+	{
+		CountByteFast(Freq, Input, Size);
+		return Size;
+	}
+
+	u64 ChunkCount = SampleSize / HISTO_SAMPLE_CHUNK;
+	if (ChunkCount <= 1)
+	{
+		// NOTE: sample smaller than two chunks is just one chunk from start
+		u64 Count = Size < HISTO_SAMPLE_CHUNK ? Size : HISTO_SAMPLE_CHUNK;
+		CountByteFast(Freq, Input, Count);
+		return Count;
+	}
+
+	u64 Stride = (Size - HISTO_SAMPLE_CHUNK) / (ChunkCount - 1);
+
+	ALIGN(u32, Counts[HISTO_SUB_TABLES][256], 64);
+	ZeroSize(Counts, sizeof(Counts));
+
+	for (u64 Chunk = 0; Chunk < ChunkCount; Chunk++)
+	{
+		const u8* At = Input + Chunk * Stride;
+		for (u32 i = 0; i < HISTO_SAMPLE_CHUNK; i += 4)
+		{
+			Counts[0][At[i + 0]]++;
+			Counts[1][At[i + 1]]++;
+			Counts[2][At[i + 2]]++;
+			Counts[3][At[i + 3]]++;
+		}
+	}
+
+	for (u32 i = 0; i < 256; i++)
+	{
+		Freq[i] += Counts[0][i] + Counts[1][i] + Counts[2][i] + Counts[3][i];
+	}
+
+	u64 Result = ChunkCount * HISTO_SAMPLE_CHUNK;
+	return Result;
+}
@@ -146,7 +146,8 @@ struct HuffDefaultBuild
 
 	inline void writeTable(BitWriter& Writer) const
 	{
-		u8 LenCount[17] = {};
+		// NOTE: all 256 symbols can share one length, so counts don't fit u8
+		u32 LenCount[17] = {};
 		for (u32 i = 1; i <= MaxSymbolIndex; i++)
 		{
 			LenCount[Nodes[i].Len]++;
@@ -162,7 +163,7 @@ struct HuffDefaultBuild
 		const huff_node* CurrNode = Nodes + 1;
 		for (u32 i = 1; i < ArrayCount(LenCount); i++)
 		{
-			u8 CodesWithLen = LenCount[i];
+			u32 CodesWithLen = LenCount[i];
 			if (CodesWithLen)
 			{
 				Writer.writeMSB(CodesWithLen, MaxCountBits);
@@ -490,7 +491,7 @@ struct HuffDecoder
 struct HuffDecTableInfo
 {
 	u8 SymBuff[256];
-	u8 CodeLenCount[HUFF_MAX_CODELEN + 1];
+	u16 CodeLenCount[HUFF_MAX_CODELEN + 1];
 	u8 MinCodeLen;
 	u8 MaxCodeLen;
 	u32 DecTableReqSizeByte;
@@ -499,7 +500,7 @@ struct HuffDecTableInfo
 	{
 		MinCodeLen = 255;
 		MaxCodeLen = 0;
-		MemSet<u8>(CodeLenCount, sizeof(CodeLenCount), 0);
+		MemSet<u16>(CodeLenCount, ArrayCount(CodeLenCount), 0);
 
 		Reader.refillTo(8);
 		u64 MaxCountBits = Reader.peek(8);
@@ -544,6 +545,65 @@ struct HuffDecTableInfo
 		DecTableReqSizeByte = ((u32)1 << MaxCodeLen) * sizeof(huff_dec_entry);
 	}
 
+	// Same for untrusted input: returns false if header isn't prefix code of at least 2 symbols with code
+	// lengths up to MaxCodeLenLimit. Reader returns zeros past its end, overrun is checked by caller.
+	inline b32 readTableChecked(BitReaderMSB& Reader, u32 MaxCodeLenLimit)
+	{
+		Assert(MaxCodeLenLimit <= HUFF_MAX_CODELEN);
+
+		MinCodeLen = 255;
+		MaxCodeLen = 0;
+		MemSet<u16>(CodeLenCount, ArrayCount(CodeLenCount), 0);
+
+		Reader.refillTo(16);
+		u32 MaxCountBits = static_cast<u32>(Reader.peek(8));
+		Reader.consume(8);
+
+		u32 MaxSymbolBits = static_cast<u32>(Reader.peek(8));
+		Reader.consume(8);
+
+		if (!MaxCountBits || (MaxCountBits > 9) || !MaxSymbolBits || (MaxSymbolBits > 8)) return false;
+
+		Reader.refillTo(MaxCountBits);
+		u32 SymbolCount = static_cast<u32>(Reader.peek(MaxCountBits));
+		Reader.consume(MaxCountBits);
+
+		if ((SymbolCount < 2) || (SymbolCount > 256)) return false;
+
+		// NOTE: lengths come in increasing order, so at most HUFF_MAX_CODELEN groups
+		u32 CodeSpace = 0;
+		u32 ReadCount = 0;
+		while (ReadCount < SymbolCount)
+		{
+			Reader.refillTo(4 + MaxCountBits);
+			u32 CodesWithLen = static_cast<u32>(Reader.peek(MaxCountBits));
+			Reader.consume(MaxCountBits);
+
+			u32 CodeLen = static_cast<u32>(Reader.peek(4)) + 1;
+			Reader.consume(4);
+
+			if (!CodesWithLen || (CodesWithLen > (SymbolCount - ReadCount))) return false;
+			if ((CodeLen <= MaxCodeLen) || (CodeLen > MaxCodeLenLimit)) return false;
+
+			CodeLenCount[CodeLen] = CodesWithLen;
+			MinCodeLen = CodeLen < MinCodeLen ? CodeLen : MinCodeLen;
+			MaxCodeLen = CodeLen;
+			CodeSpace += CodesWithLen << (HUFF_MAX_CODELEN - CodeLen);
+
+			while (CodesWithLen--)
+			{
+				Reader.refillTo(MaxSymbolBits);
+				SymBuff[ReadCount++] = static_cast<u8>(Reader.peek(MaxSymbolBits));
+				Reader.consume(MaxSymbolBits);
+			}
+		}
+
+		if (CodeSpace > (1u << HUFF_MAX_CODELEN)) return false;
+
+		DecTableReqSizeByte = ((u32)1 << MaxCodeLen) * sizeof(huff_dec_entry);
+		return true;
+	}
+
 	inline void assignCodesMSB(HuffDecoder& Dec) const
 	{
 		u16* SetMem = reinterpret_cast<u16*>(Dec.Table);
@@ -0,0 +1,550 @@
+// LZ77 front end for entropy coders. Hash chain match finder over sliding window, sequences
+// (literal run, match length, offset) are split in streams: literals and 3 code streams are coded
+// with block rANS, extra bits of length/offset codes go to raw bit stream.
+//
+// Container (little endian, every field and section is u32 aligned):
+//   u64 TotalSize, then blocks of up to LZ_BLOCK_SIZE input bytes:
+//   u32 RawSize, u32 SeqCount, 4 x (u32 WordCount, rANS block), u32 WordCount, extra bits
+// rANS streams are literals, literal length codes, match length codes, offset codes.
+// Window isn't reset between blocks, block is only entropy coding unit. Bytes after last sequence
+// of block are literals.
+static constexpr u32 LZ_MIN_MATCH = 4;
+static constexpr u32 LZ_MAX_MATCH = 1 << 16;
+static constexpr u32 LZ_BLOCK_SIZE = 1 << 18;
+static constexpr u32 LZ_MAX_WINDOW_LOG = 24;
+static constexpr u32 LZ_DIRECT_CODES = 16; // smaller lengths are codes themselves, no extra bits
+// literal run is shorter than LZ_BLOCK_SIZE and match length value than LZ_MAX_MATCH, so Msb of value is at most 17 and 15
+static constexpr u32 LZ_MAX_LIT_LEN_CODE = LZ_DIRECT_CODES + 17 - 4;
+static constexpr u32 LZ_MAX_MATCH_LEN_CODE = LZ_DIRECT_CODES + 15 - 4;
+static_assert((LZ_BLOCK_SIZE == (1 << 18)) && (LZ_MAX_MATCH == (1 << 16)), "length code limits must follow block and match size");
+static constexpr u32 LZ_WILDCOPY_SIZE = 16;
+static constexpr u32 LZ_NO_POS = MaxUInt32;
+static constexpr u32 LZ_STREAM_COUNT = 4;
+
+struct lz_params
+{
+	u32 WindowLog;
+	u32 HashLog;
+	u32 ChainDepth; // candidates checked per position
+	b32 Lazy; // defer match by one byte if next position has longer one
+};
+
+inline lz_params
+LzDefaultParams()
+{
+	lz_params Result = {};
+	Result.WindowLog = 20;
+	Result.HashLog = 17;
+	Result.ChainDepth = 32;
+	Result.Lazy = true;
+	return Result;
+}
+
+// length code: values below LZ_DIRECT_CODES as is, then one code per power of 2 with Msb extra bits
+inline u32
+LzLengthCode(u32 Value, u32* ExtraBitCount)
+{
+	u32 Result = Value;
+	*ExtraBitCount = 0;
+
+	if (Value >= LZ_DIRECT_CODES)
+	{
+		u32 Msb = FindMostSignificantSetBit32(Value);
+		Result = LZ_DIRECT_CODES + Msb - 4;
+		*ExtraBitCount = Msb;
+	}
+
+	return Result;
+}
+
+// offset (>= 1) code is its Msb, Msb extra bits
+inline u32
+LzOffsetCode(u32 Offset)
+{
+	Assert(Offset);
+	u32 Result = FindMostSignificantSetBit32(Offset);
+	return Result;
+}
+
+// A is behind B, compares up to End (limit for B), 8 bytes at a time
+inline u32
+LzMatchLength(const u8* A, const u8* B, const u8* End)
+{
+	const u8* Start = B;
+
+	while ((B + sizeof(u64)) <= End)
+	{
+		u64 WordA;
+		u64 WordB;
+		memcpy(&WordA, A, sizeof(u64));
+		memcpy(&WordB, B, sizeof(u64));
+
+		u64 Diff = WordA ^ WordB;
+		if (Diff)
+		{
+			u32 Result = static_cast<u32>(B - Start) + (FindLeastSignificantSetBit64(Diff) >> 3);
+			return Result;
+		}
+
+		A += sizeof(u64);
+		B += sizeof(u64);
+	}
+
+	while ((B < End) && (*A == *B))
+	{
+		A++;
+		B++;
+	}
+
+	u32 Result = static_cast<u32>(B - Start);
+	return Result;
+}
+
+// Head holds last position of each 4 byte hash, Chain[Pos & WindowMask] previous position with same hash.
+// Candidates older than window are never followed, so chain slot reuse is safe.
+class LzMatchFinder
+{
+	const u8* Data;
+	u64 Size;
+	u32 WindowSize;
+	u32 ChainMask;
+	u32 HashShift;
+	u32 ChainDepth;
+	u32 NextInsert;
+
+	std::vector<u32> Head;
+	std::vector<u32> Chain;
+
+public:
+	void init(const u8* InData, u64 InSize, const lz_params& Params)
+	{
+		Assert(Params.WindowLog <= LZ_MAX_WINDOW_LOG);
+		Assert(InSize < MaxUInt32);
+
+		Data = InData;
+		Size = InSize;
+		WindowSize = 1 << Params.WindowLog;
+		HashShift = 32 - Params.HashLog;
+		ChainDepth = Params.ChainDepth;
+		NextInsert = 0;
+
+		// NOTE: no offset is larger than input, so small input doesn't need whole window of chain
+		u32 ChainSize = 1;
+		while ((ChainSize < WindowSize) && (ChainSize < InSize)) ChainSize <<= 1;
+		ChainMask = ChainSize - 1;
+
+		Head.assign(1ull << Params.HashLog, LZ_NO_POS);
+		Chain.resize(ChainSize);
+	}
+
+	// longest match at Pos ending before Limit, returns 0 if shorter than LZ_MIN_MATCH
+	u32 find(u32 Pos, u32 Limit, u32* OutOffset)
+	{
+		insertUpTo(Pos);
+
+		u32 MaxLen = Limit - Pos;
+		MaxLen = MaxLen < LZ_MAX_MATCH ? MaxLen : LZ_MAX_MATCH;
+		if (MaxLen < LZ_MIN_MATCH) return 0;
+
+		u32 BestLen = LZ_MIN_MATCH - 1;
+		u32 BestOffset = 0;
+		const u8* Curr = Data + Pos;
+
+		u32 Cand = Head[hash(Pos)];
+		for (u32 Depth = ChainDepth; Depth && (Cand != LZ_NO_POS); Depth--)
+		{
+			u32 Offset = Pos - Cand;
+			if (Offset >= WindowSize) break;
+
+			const u8* Match = Data + Cand;
+			if (Match[BestLen] == Curr[BestLen])
+			{
+				u32 Len = LzMatchLength(Match, Curr, Curr + MaxLen);
+				if (Len > BestLen)
+				{
+					BestLen = Len;
+					BestOffset = Offset;
+					if (Len == MaxLen) break;
+				}
+			}
+
+			Cand = Chain[Cand & ChainMask];
+		}
+
+		u32 Result = BestOffset ? BestLen : 0;
+		*OutOffset = BestOffset;
+		return Result;
+	}
+
+	void insertUpTo(u32 Pos)
+	{
+		u32 End = (Size >= LZ_MIN_MATCH) ? static_cast<u32>(Size - LZ_MIN_MATCH + 1) : 0;
+		End = Pos < End ? Pos : End;
+
+		for (; NextInsert < End; NextInsert++)
+		{
+			u32 Hash = hash(NextInsert);
+			Chain[NextInsert & ChainMask] = Head[Hash];
+			Head[Hash] = NextInsert;
+		}
+	}
+
+private:
+	inline u32 hash(u32 Pos) const
+	{
+		u32 Val;
+		memcpy(&Val, Data + Pos, sizeof(u32));
+
+		u32 Result = (Val * 2654435761u) >> HashShift;
+		return Result;
+	}
+};
+
+struct lz_block_streams
+{
+	ByteVec Literals;
+	ByteVec Codes[LZ_STREAM_COUNT - 1]; // literal length, match length, offset
+	ByteVec Extra;
+	u32 SeqCount;
+};
+
+inline void
+LzPutU32(ByteVec& Out, u32 Value)
+{
+	u8 Bytes[sizeof(u32)];
+	memcpy(Bytes, &Value, sizeof(u32));
+	Out.insert(Out.end(), Bytes, Bytes + sizeof(u32));
+}
+
+inline void
+LzWriteRansStream(rans_block_enc_ctx& Ctx, std::vector<u32>& Scratch, ByteVec& Out, const ByteVec& Stream)
+{
+	u32 WordCount = 0;
+	u32* Begin = nullptr;
+
+	if (Stream.size())
+	{
+		Scratch.resize((RansBlockBound(Stream.size()) + sizeof(u32) - 1) / sizeof(u32));
+		u32* End = Scratch.data() + Scratch.size();
+		Begin = RansBlockEncode(Ctx, End, Stream.data(), static_cast<u32>(Stream.size()));
+		WordCount = static_cast<u32>(End - Begin);
+	}
+
+	LzPutU32(Out, WordCount);
+	if (WordCount)
+	{
+		const u8* Bytes = reinterpret_cast<const u8*>(Begin);
+		Out.insert(Out.end(), Bytes, Bytes + WordCount * sizeof(u32));
+	}
+}
+
+void
+LzParseBlock(LzMatchFinder& Finder, const u8* Data, u32 BlockStart, u32 BlockEnd, b32 Lazy, lz_block_streams& Streams)
+{
+	Streams.Literals.clear();
+	for (ByteVec& Codes : Streams.Codes) Codes.clear();
+	Streams.SeqCount = 0;
+
+	// every sequence takes at most 17 + 15 + 23 extra bits
+	Streams.Extra.resize((BlockEnd - BlockStart) / LZ_MIN_MATCH * 8 + 8);
+	BitWriter Extra(Streams.Extra.data(), Streams.Extra.size());
+
+	u32 Anchor = BlockStart;
+	u32 Pos = BlockStart;
+
+	while ((Pos + LZ_MIN_MATCH) <= BlockEnd)
+	{
+		u32 Offset;
+		u32 Len = Finder.find(Pos, BlockEnd, &Offset);
+		if (!Len)
+		{
+			Pos++;
+			continue;
+		}
+
+		if (Lazy && ((Pos + 1 + LZ_MIN_MATCH) <= BlockEnd))
+		{
+			u32 NextOffset;
+			u32 NextLen = Finder.find(Pos + 1, BlockEnd, &NextOffset);
+			if (NextLen > Len)
+			{
+				Pos++;
+				Len = NextLen;
+				Offset = NextOffset;
+			}
+		}
+
+		u32 LitLen = Pos - Anchor;
+		Streams.Literals.insert(Streams.Literals.end(), Data + Anchor, Data + Pos);
+
+		u32 ExtraBitCount;
+		u32 Code = LzLengthCode(LitLen, &ExtraBitCount);
+		Assert(Code <= LZ_MAX_LIT_LEN_CODE);
+		Streams.Codes[0].push_back(static_cast<u8>(Code));
+		if (ExtraBitCount) Extra.writeMSB(LitLen - (1 << ExtraBitCount), ExtraBitCount);
+
+		u32 MatchLenValue = Len - LZ_MIN_MATCH;
+		Code = LzLengthCode(MatchLenValue, &ExtraBitCount);
+		Assert(Code <= LZ_MAX_MATCH_LEN_CODE);
+		Streams.Codes[1].push_back(static_cast<u8>(Code));
+		if (ExtraBitCount) Extra.writeMSB(MatchLenValue - (1 << ExtraBitCount), ExtraBitCount);
+
+		Code = LzOffsetCode(Offset);
+		Streams.Codes[2].push_back(static_cast<u8>(Code));
+		if (Code) Extra.writeMSB(Offset - (1 << Code), Code);
+
+		Streams.SeqCount++;
+		Pos += Len;
+		Anchor = Pos;
+	}
+
+	Streams.Literals.insert(Streams.Literals.end(), Data + Anchor, Data + BlockEnd);
+
+	u64 ExtraSize = Extra.finish();
+	Streams.Extra.resize(AlignSizeForward(ExtraSize, sizeof(u32)), 0);
+	Finder.insertUpTo(BlockEnd);
+}
+
+// worst case is all literals in rANS blocks
+inline u64
+LzCompressBound(u64 Size)
+{
+	u64 BlockCount = (Size + LZ_BLOCK_SIZE - 1) / LZ_BLOCK_SIZE;
+	u64 Result = sizeof(u64) + RansBlockBound(Size) + BlockCount * (8 * sizeof(u32) + LZ_STREAM_COUNT * RansBlockBound(0));
+	return Result;
+}
+
+// Encoder scratch, reused between calls so per thread workspace codes many inputs without reallocation
+struct lz_workspace
+{
+	LzMatchFinder Finder;
+	rans_block_enc_ctx Ctx;
+	std::vector<u32> Scratch;
+	lz_block_streams Streams;
+};
+
+void
+LzCompress(lz_workspace& Workspace, const u8* Data, u64 Size, ByteVec& Out, const lz_params& Params)
+{
+	Out.clear();
+	Out.reserve(LzCompressBound(Size));
+
+	u8 SizeBytes[sizeof(u64)];
+	memcpy(SizeBytes, &Size, sizeof(u64));
+	Out.insert(Out.end(), SizeBytes, SizeBytes + sizeof(u64));
+
+	LzMatchFinder& Finder = Workspace.Finder;
+	Finder.init(Data, Size, Params);
+
+	rans_block_enc_ctx* Ctx = &Workspace.Ctx;
+	std::vector<u32>& Scratch = Workspace.Scratch;
+	lz_block_streams& Streams = Workspace.Streams;
+
+	for (u64 BlockStart = 0; BlockStart < Size; BlockStart += LZ_BLOCK_SIZE)
+	{
+		u64 BlockEnd = (BlockStart + LZ_BLOCK_SIZE) < Size ? (BlockStart + LZ_BLOCK_SIZE) : Size;
+		LzParseBlock(Finder, Data, static_cast<u32>(BlockStart), static_cast<u32>(BlockEnd), Params.Lazy, Streams);
+
+		LzPutU32(Out, static_cast<u32>(BlockEnd - BlockStart));
+		LzPutU32(Out, Streams.SeqCount);
+
+		LzWriteRansStream(*Ctx, Scratch, Out, Streams.Literals);
+		for (const ByteVec& Codes : Streams.Codes)
+		{
+			LzWriteRansStream(*Ctx, Scratch, Out, Codes);
+		}
+
+		LzPutU32(Out, static_cast<u32>(Streams.Extra.size() / sizeof(u32)));
+		Out.insert(Out.end(), Streams.Extra.begin(), Streams.Extra.end());
+	}
+}
+
+void
+LzCompress(const u8* Data, u64 Size, ByteVec& Out, const lz_params& Params)
+{
+	std::vector<lz_workspace> Workspace(1);
+	LzCompress(Workspace[0], Data, Size, Out, Params);
+}
+
+// Copies 16 byte chunks until Dest reaches DestEnd, may write up to 15 bytes past it.
+// Src must be at least 16 bytes behind Dest if ranges overlap.
+inline void
+LzWildCopy(u8* Dest, const u8* Src, u8* DestEnd)
+{
+	do
+	{
+		memcpy(Dest, Src, LZ_WILDCOPY_SIZE);
+		Dest += LZ_WILDCOPY_SIZE;
+		Src += LZ_WILDCOPY_SIZE;
+	}
+	while (Dest < DestEnd);
+}
+
+struct lz_reader
+{
+	const u8* Pos;
+	const u8* End;
+	b32 Valid;
+
+	u32 readU32()
+	{
+		u32 Result = 0;
+		if ((End - Pos) >= static_cast<s64>(sizeof(u32)))
+		{
+			memcpy(&Result, Pos, sizeof(u32));
+			Pos += sizeof(u32);
+		}
+		else
+		{
+			Valid = false;
+		}
+
+		return Result;
+	}
+
+	// returns decoded size, empty stream is 0
+	u32 readRansStream(rans_block_dec_ctx& Ctx, u8* Dest, u32 DestCapacity)
+	{
+		u32 WordCount = readU32();
+		if (!WordCount) return 0;
+
+		if ((static_cast<u64>(End - Pos) / sizeof(u32)) < WordCount)
+		{
+			Valid = false;
+			return 0;
+		}
+
+		u32* In = const_cast<u32*>(reinterpret_cast<const u32*>(Pos));
+		u32 Result = RansBlockDecode(Ctx, Dest, DestCapacity, &In, In + WordCount);
+		if (!Result) Valid = false;
+
+		Pos += WordCount * sizeof(u32);
+		return Result;
+	}
+};
+
+// Code must be checked against LZ_MAX_LIT_LEN_CODE / LZ_MAX_MATCH_LEN_CODE, larger ones shift past 32 bits
+inline u32
+LzReadLength(BitReaderMSB& Extra, u32 Code)
+{
+	Assert(Code <= LZ_MAX_LIT_LEN_CODE);
+
+	u32 Result = Code;
+	if (Code >= LZ_DIRECT_CODES)
+	{
+		u32 BitCount = Code - LZ_DIRECT_CODES + 4;
+		Extra.refillTo(BitCount);
+		Result = (1 << BitCount) + static_cast<u32>(Extra.peek(BitCount));
+		Extra.consume(BitCount);
+	}
+
+	return Result;
+}
+
+// returns decoded size, 0 on malformed stream or if it doesn't fit in DestCapacity. In must be u32 aligned.
+u64
+LzDecompress(u8* Dest, u64 DestCapacity, const u8* In, u64 InSize)
+{
+	Assert((reinterpret_cast<size_t>(In) & (sizeof(u32) - 1)) == 0);
+
+	if (InSize < sizeof(u64)) return 0;
+
+	u64 TotalSize;
+	memcpy(&TotalSize, In, sizeof(u64));
+	if (TotalSize > DestCapacity) return 0;
+
+	lz_reader Reader = {In + sizeof(u64), In + InSize, true};
+
+	std::vector<rans_block_dec_ctx> Ctx(1);
+	ByteVec Literals(LZ_BLOCK_SIZE + LZ_WILDCOPY_SIZE);
+	ByteVec Codes[LZ_STREAM_COUNT - 1];
+	for (ByteVec& Stream : Codes) Stream.resize(LZ_BLOCK_SIZE / LZ_MIN_MATCH);
+
+	u8* Out = Dest;
+	u8* OutEnd = Dest + TotalSize;
+
+	while (Out < OutEnd)
+	{
+		u32 RawSize = Reader.readU32();
+		u32 SeqCount = Reader.readU32();
+		if (!Reader.Valid || !RawSize || (RawSize > LZ_BLOCK_SIZE) || (RawSize > (OutEnd - Out))) return 0;
+		if (SeqCount > (RawSize / LZ_MIN_MATCH)) return 0;
+
+		u32 LitCount = Reader.readRansStream(Ctx[0], Literals.data(), LZ_BLOCK_SIZE);
+		for (ByteVec& Stream : Codes)
+		{
+			u32 CodeCount = Reader.readRansStream(Ctx[0], Stream.data(), SeqCount);
+			if (CodeCount != SeqCount) return 0;
+		}
+
+		u32 ExtraWords = Reader.readU32();
+		if (!Reader.Valid || ((static_cast<u64>(Reader.End - Reader.Pos) / sizeof(u32)) < ExtraWords)) return 0;
+
+		BitReaderMSB Extra(const_cast<u8*>(Reader.Pos), ExtraWords * sizeof(u32));
+		Reader.Pos += ExtraWords * sizeof(u32);
+
+		u8* BlockEnd = Out + RawSize;
+		const u8* Lit = Literals.data();
+		const u8* LitEnd = Lit + LitCount;
+
+		for (u32 i = 0; i < SeqCount; i++)
+		{
+			u32 LitLenCode = Codes[0][i];
+			u32 MatchLenCode = Codes[1][i];
+			u32 OffsetCode = Codes[2][i];
+			if ((LitLenCode > LZ_MAX_LIT_LEN_CODE) || (MatchLenCode > LZ_MAX_MATCH_LEN_CODE) || (OffsetCode >= LZ_MAX_WINDOW_LOG)) return 0;
+
+			u32 LitLen = LzReadLength(Extra, LitLenCode);
+			u32 MatchLen = LzReadLength(Extra, MatchLenCode) + LZ_MIN_MATCH;
+
+			u32 Offset = 1 << OffsetCode;
+			if (OffsetCode)
+			{
+				Extra.refillTo(OffsetCode);
+				Offset += static_cast<u32>(Extra.peek(OffsetCode));
+				Extra.consume(OffsetCode);
+			}
+
+			if ((LitLen > (LitEnd - Lit)) || ((static_cast<u64>(LitLen) + MatchLen) > static_cast<u64>(BlockEnd - Out))) return 0;
+
+			// NOTE: literal buffer has LZ_WILDCOPY_SIZE tail, so only Dest side is checked
+			if ((Out + LitLen + LZ_WILDCOPY_SIZE) <= OutEnd)
+			{
+				if (LitLen) LzWildCopy(Out, Lit, Out + LitLen);
+			}
+			else
+			{
+				memcpy(Out, Lit, LitLen);
+			}
+
+			Out += LitLen;
+			Lit += LitLen;
+
+			if (Offset > (Out - Dest)) return 0;
+
+			const u8* Match = Out - Offset;
+			if ((Offset >= LZ_WILDCOPY_SIZE) && ((Out + MatchLen + LZ_WILDCOPY_SIZE) <= OutEnd))
+			{
+				LzWildCopy(Out, Match, Out + MatchLen);
+				Out += MatchLen;
+			}
+			else
+			{
+				// overlapping short offset repeats pattern, must go byte by byte
+				for (u32 k = 0; k < MatchLen; k++)
+				{
+					*Out++ = *Match++;
+				}
+			}
+		}
+
+		u64 RestCount = LitEnd - Lit;
+		if (RestCount != static_cast<u64>(BlockEnd - Out)) return 0;
+
+		memcpy(Out, Lit, RestCount);
+		Out += RestCount;
+	}
+
+	u64 Result = TotalSize;
+	return Result;
+}
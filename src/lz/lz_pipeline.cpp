@@ -0,0 +1,376 @@
+// File to file LZ compression with overlapped stages: async reads of next blocks, compression of
+// independent blocks on worker threads, ordered async writes. Ring of QueueDepth block slots bounds
+// memory and I/O in flight, slot of block B is B % QueueDepth, so it's read again only after block
+// B - QueueDepth is written. Calling thread owns all slot state transitions and waits for both I/O
+// completions and compressed blocks on one AsyncIO.
+//
+// Container (little endian):
+//   u64 TotalSize, u32 BlockSize, u32 BlockCount, LZ stream of every block (LzCompress format),
+//   u32 CompressedSize[BlockCount]
+// Block sizes go to trailer, so blocks are written straight from compressor output. Every LZ stream
+// is u32 sized, so streams stay u32 aligned.
+static constexpr u32 PIPELINE_HEADER_SIZE = sizeof(u64) + 2 * sizeof(u32);
+
+struct pipeline_params
+{
+	u32 BlockSize;
+	u32 QueueDepth; // block slots, 1 - no overlap, read/compress/write one block at a time
+	u32 WorkerCount; // 0 - all hardware threads
+	u32 IOThreadCount; // fallback backend only
+	b32 UseUring;
+	lz_params Lz;
+};
+
+inline pipeline_params
+PipelineDefaultParams()
+{
+	pipeline_params Result = {};
+	Result.BlockSize = 4 << 20;
+	Result.QueueDepth = 8;
+	Result.IOThreadCount = 2;
+	Result.UseUring = true;
+	Result.Lz = LzDefaultParams();
+	return Result;
+}
+
+struct pipeline_stats
+{
+	u64 InSize;
+	u64 OutSize;
+	u32 BlockCount;
+	const char* Backend;
+};
+
+enum class pipeline_slot_state : u32
+{
+	Free,
+	Reading,
+	Compressing,
+	Compressed,
+	Writing,
+};
+
+struct pipeline_slot
+{
+	pipeline_slot_state State;
+	u32 Block;
+	u32 Size; // bytes to read or write
+	u32 Done; // bytes transferred, short transfers are resubmitted
+	u64 Offset;
+	ByteVec In;
+	ByteVec Out;
+};
+
+class PipelineWorkers
+{
+	std::vector<std::thread> Threads;
+	std::mutex Lock;
+	std::condition_variable Ready;
+	std::deque<u32> Slots;
+	b32 Stop;
+
+public:
+	template<typename F> void start(u32 WorkerCount, F Body)
+	{
+		Stop = false;
+		for (u32 i = 0; i < WorkerCount; i++)
+		{
+			Threads.emplace_back([this, Body]()
+			{
+				std::vector<lz_workspace> Workspace(1);
+
+				for (;;)
+				{
+					u32 Slot;
+					{
+						std::unique_lock<std::mutex> Guard(Lock);
+						Ready.wait(Guard, [this]() { return Stop || !Slots.empty(); });
+						if (Slots.empty()) return;
+
+						Slot = Slots.front();
+						Slots.pop_front();
+					}
+
+					Body(Workspace[0], Slot);
+				}
+			});
+		}
+	}
+
+	void push(u32 Slot)
+	{
+		{
+			std::lock_guard<std::mutex> Guard(Lock);
+			Slots.push_back(Slot);
+		}
+		Ready.notify_one();
+	}
+
+	// NOTE: workers finish queued slots before exit
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> Guard(Lock);
+			Stop = true;
+		}
+		Ready.notify_all();
+
+		for (auto& Thread : Threads)
+		{
+			Thread.join();
+		}
+		Threads.clear();
+	}
+};
+
+b32
+PipelineCompressFile(const char* InPath, const char* OutPath, const pipeline_params& Params, pipeline_stats* Stats)
+{
+	Assert(Params.BlockSize && Params.QueueDepth);
+
+	io_file InFile = OpenIOFile(InPath, false);
+	if (InFile == INVALID_IO_FILE) return false;
+
+	io_file OutFile = OpenIOFile(OutPath, true);
+	if (OutFile == INVALID_IO_FILE)
+	{
+		CloseIOFile(InFile);
+		return false;
+	}
+
+	u64 TotalSize = IOFileSize(InFile);
+	u64 BlockCount64 = (TotalSize + Params.BlockSize - 1) / Params.BlockSize;
+	if (BlockCount64 > MaxUInt32)
+	{
+		CloseIOFile(InFile);
+		CloseIOFile(OutFile);
+		return false;
+	}
+
+	u32 BlockCount = static_cast<u32>(BlockCount64);
+	u32 QueueDepth = Params.QueueDepth;
+	u32 WorkerCount = Params.WorkerCount;
+	if (WorkerCount == 0)
+	{
+		WorkerCount = std::thread::hardware_concurrency();
+		WorkerCount = WorkerCount ? WorkerCount : 1;
+	}
+
+	std::vector<pipeline_slot> Slots(QueueDepth);
+	for (pipeline_slot& Slot : Slots)
+	{
+		Slot.State = pipeline_slot_state::Free;
+		Slot.In.resize(Params.BlockSize);
+	}
+
+	std::vector<u32> BlockSizes(BlockCount);
+
+	AsyncIO IO;
+	IO.init(QueueDepth, Params.IOThreadCount, Params.UseUring);
+
+	std::atomic<b32> NotifyFailed(false);
+
+	PipelineWorkers Workers;
+	Workers.start(WorkerCount, [&](lz_workspace& Workspace, u32 SlotIndex)
+	{
+		pipeline_slot& Slot = Slots[SlotIndex];
+		LzCompress(Workspace, Slot.In.data(), Slot.Size, Slot.Out, Params.Lz);
+		if (!IO.notify(SlotIndex)) NotifyFailed = true;
+	});
+
+	u32 NextRead = 0;
+	u32 NextWrite = 0;
+	u32 WritesDone = 0;
+	u32 Pending = 0; // I/O ops and compressions in flight
+	u64 WriteOffset = PIPELINE_HEADER_SIZE;
+	b32 Failed = false;
+
+	auto SubmitTransfer = [&](u32 SlotIndex, b32 Write)
+	{
+		pipeline_slot& Slot = Slots[SlotIndex];
+
+		async_io_op Op = {};
+		Op.File = Write ? OutFile : InFile;
+		Op.Buffer = (Write ? Slot.Out.data() : Slot.In.data()) + Slot.Done;
+		Op.Size = Slot.Size - Slot.Done;
+		Op.Offset = Slot.Offset + Slot.Done;
+		Op.Tag = SlotIndex;
+		Op.Write = Write;
+		IO.submit(Op);
+	};
+
+	std::vector<async_io_done> Completions(QueueDepth + 1);
+
+	while (WritesDone < BlockCount)
+	{
+		if (!Failed)
+		{
+			while ((NextRead < BlockCount) && (Slots[NextRead % QueueDepth].State == pipeline_slot_state::Free))
+			{
+				pipeline_slot& Slot = Slots[NextRead % QueueDepth];
+				u64 Offset = static_cast<u64>(NextRead) * Params.BlockSize;
+
+				Slot.State = pipeline_slot_state::Reading;
+				Slot.Block = NextRead;
+				Slot.Offset = Offset;
+				Slot.Size = static_cast<u32>((TotalSize - Offset) < Params.BlockSize ? (TotalSize - Offset) : Params.BlockSize);
+				Slot.Done = 0;
+				SubmitTransfer(NextRead % QueueDepth, false);
+
+				Pending++;
+				NextRead++;
+			}
+
+			while ((NextWrite < BlockCount) && (Slots[NextWrite % QueueDepth].State == pipeline_slot_state::Compressed))
+			{
+				pipeline_slot& Slot = Slots[NextWrite % QueueDepth];
+				BlockSizes[NextWrite] = static_cast<u32>(Slot.Out.size());
+
+				Slot.State = pipeline_slot_state::Writing;
+				Slot.Offset = WriteOffset;
+				Slot.Size = static_cast<u32>(Slot.Out.size());
+				Slot.Done = 0;
+				SubmitTransfer(NextWrite % QueueDepth, true);
+
+				WriteOffset += Slot.Size;
+				Pending++;
+				NextWrite++;
+			}
+		}
+
+		if (!Pending) break;
+
+		u32 Count = IO.wait(Completions.data(), static_cast<u32>(Completions.size()));
+		if (!Count || NotifyFailed)
+		{
+			// NOTE: ops still in flight are reaped by release below, before slot buffers are freed
+			Failed = true;
+			break;
+		}
+
+		for (u32 i = 0; i < Count; i++)
+		{
+			u32 SlotIndex = Completions[i].Tag;
+			s64 Result = Completions[i].Result;
+			pipeline_slot& Slot = Slots[SlotIndex];
+			Pending--;
+
+			if (Slot.State == pipeline_slot_state::Compressing)
+			{
+				Slot.State = pipeline_slot_state::Compressed;
+				continue;
+			}
+
+			// NOTE: 0 bytes read before block end means file was truncated under us
+			if (Result <= 0)
+			{
+				Failed = true;
+				continue;
+			}
+
+			Slot.Done += static_cast<u32>(Result);
+			if (Slot.Done < Slot.Size)
+			{
+				if (!Failed)
+				{
+					SubmitTransfer(SlotIndex, Slot.State == pipeline_slot_state::Writing);
+					Pending++;
+				}
+				continue;
+			}
+
+			if (Slot.State == pipeline_slot_state::Reading)
+			{
+				Slot.State = pipeline_slot_state::Compressing;
+				Workers.push(SlotIndex);
+				Pending++;
+			}
+			else
+			{
+				Slot.State = pipeline_slot_state::Free;
+				WritesDone++;
+			}
+		}
+	}
+
+	Workers.stop();
+	const char* Backend = IO.backendName();
+	if (!IO.release())
+	{
+		// NOTE: ring failed with ops in flight, kernel may still write slot buffers, so they are leaked on purpose
+		Failed = true;
+		new std::vector<pipeline_slot>(std::move(Slots));
+	}
+
+	if (!Failed)
+	{
+		ByteVec Header(PIPELINE_HEADER_SIZE);
+		memcpy(Header.data(), &TotalSize, sizeof(u64));
+		memcpy(Header.data() + sizeof(u64), &Params.BlockSize, sizeof(u32));
+		memcpy(Header.data() + sizeof(u64) + sizeof(u32), &BlockCount, sizeof(u32));
+
+		async_io_op Op = {};
+		Op.File = OutFile;
+		Op.Write = true;
+		Op.Buffer = Header.data();
+		Op.Size = PIPELINE_HEADER_SIZE;
+		Op.Offset = 0;
+		Failed = IOFileTransfer(Op) != Op.Size;
+
+		Op.Buffer = reinterpret_cast<u8*>(BlockSizes.data());
+		Op.Size = BlockCount * sizeof(u32);
+		Op.Offset = WriteOffset;
+		Failed |= Op.Size && (IOFileTransfer(Op) != Op.Size);
+	}
+
+	CloseIOFile(InFile);
+	CloseIOFile(OutFile);
+
+	if (Stats)
+	{
+		Stats->InSize = TotalSize;
+		Stats->OutSize = WriteOffset + BlockCount * sizeof(u32);
+		Stats->BlockCount = BlockCount;
+		Stats->Backend = Backend;
+	}
+
+	return !Failed;
+}
+
+// returns decoded size, 0 on malformed container or if it doesn't fit in DestCapacity. In must be u32 aligned.
+u64
+PipelineDecompress(u8* Dest, u64 DestCapacity, const u8* In, u64 InSize)
+{
+	if (InSize < PIPELINE_HEADER_SIZE) return 0;
+
+	u64 TotalSize;
+	u32 BlockSize;
+	u32 BlockCount;
+	memcpy(&TotalSize, In, sizeof(u64));
+	memcpy(&BlockSize, In + sizeof(u64), sizeof(u32));
+	memcpy(&BlockCount, In + sizeof(u64) + sizeof(u32), sizeof(u32));
+
+	if (TotalSize > DestCapacity) return 0;
+	if ((InSize - PIPELINE_HEADER_SIZE) / sizeof(u32) < BlockCount) return 0;
+	if (!BlockSize || (((TotalSize + BlockSize - 1) / BlockSize) != BlockCount)) return 0;
+
+	const u8* Trailer = In + InSize - BlockCount * sizeof(u32);
+	const u8* Block = In + PIPELINE_HEADER_SIZE;
+	u64 Decoded = 0;
+
+	for (u32 i = 0; i < BlockCount; i++)
+	{
+		u32 CompressedSize;
+		memcpy(&CompressedSize, Trailer + i * sizeof(u32), sizeof(u32));
+		if (CompressedSize > static_cast<u64>(Trailer - Block)) return 0;
+
+		u64 Expected = (TotalSize - Decoded) < BlockSize ? (TotalSize - Decoded) : BlockSize;
+		u64 Size = LzDecompress(Dest + Decoded, Expected, Block, CompressedSize);
+		if (Size != Expected) return 0;
+
+		Decoded += Size;
+		Block += CompressedSize;
+	}
+
+	return Decoded;
+}
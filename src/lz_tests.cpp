@@ -0,0 +1,277 @@
+#include "lz/lz77.cpp"
+#include "lz/lz_pipeline.cpp"
+
+void
+TestLz77(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+
+	if (InputFile.Size >= MaxUInt32)
+	{
+		printf("File to big for _TestLz77_\n");
+		return;
+	}
+
+	struct lz_test_config
+	{
+		const char* Name;
+		u32 WindowLog;
+		u32 ChainDepth;
+		b32 Lazy;
+	};
+
+	const lz_test_config Configs[] =
+	{
+		{"fast", 16, 4, false},
+		{"default", 20, 32, true},
+		{"max window", 24, 128, true},
+	};
+
+	ByteVec CompBuff;
+	std::vector<u8> DecBuff(InputFile.Size);
+
+	Timer Timer;
+
+	for (const lz_test_config& Config : Configs)
+	{
+		lz_params Params = LzDefaultParams();
+		Params.WindowLog = Config.WindowLog;
+		Params.ChainDepth = Config.ChainDepth;
+		Params.Lazy = Config.Lazy;
+
+		Timer.start();
+		LzCompress(InputFile.Data, InputFile.Size, CompBuff, Params);
+		Timer.end();
+
+		printf(" %s: window %u KiB, chain %u, %s\n", Config.Name, (1 << Config.WindowLog) >> 10, Config.ChainDepth, Config.Lazy ? "lazy" : "greedy");
+		printf(" encode");
+		PrintSymbolEncPerfStats(Timer.Clock, Timer.Time, InputFile.Size);
+
+		AccumTime Accum;
+		for (u32 Run = 0; Run < RUNS_COUNT; Run++)
+		{
+			Timer.start();
+			u64 DecodedSize = LzDecompress(DecBuff.data(), DecBuff.size(), CompBuff.data(), CompBuff.size());
+			Timer.end();
+			Accum.update(Timer);
+
+			Verify(DecodedSize == InputFile.Size);
+			Assert(!memcmp(DecBuff.data(), InputFile.Data, InputFile.Size));
+		}
+
+		printf(" decode");
+		PrintAvgPerSymbolPerfStats(Accum, RUNS_COUNT, InputFile.Size);
+		PrintCompressionSize(InputFile.Size, CompBuff.size());
+	}
+
+	// one sequence blocks with length codes past the limits are rejected before extra bits are read
+	{
+		static constexpr u32 RawSize = 64;
+		const u8 BadCodes[][2] = { { LZ_MAX_LIT_LEN_CODE + 1, 0 }, { 70, 0 }, { 0, LZ_MAX_MATCH_LEN_CODE + 1 }, { 0, 70 } };
+
+		std::vector<lz_workspace> Workspace(1);
+		u8 Dest[RawSize];
+
+		for (const u8* Bad : BadCodes)
+		{
+			u64 TotalSize = RawSize;
+			CompBuff.clear();
+			CompBuff.insert(CompBuff.end(), reinterpret_cast<u8*>(&TotalSize), reinterpret_cast<u8*>(&TotalSize + 1));
+			LzPutU32(CompBuff, RawSize);
+			LzPutU32(CompBuff, 1);
+
+			LzWriteRansStream(Workspace[0].Ctx, Workspace[0].Scratch, CompBuff, ByteVec(RawSize, 'a'));
+			LzWriteRansStream(Workspace[0].Ctx, Workspace[0].Scratch, CompBuff, ByteVec(1, Bad[0]));
+			LzWriteRansStream(Workspace[0].Ctx, Workspace[0].Scratch, CompBuff, ByteVec(1, Bad[1]));
+			LzWriteRansStream(Workspace[0].Ctx, Workspace[0].Scratch, CompBuff, ByteVec(1, 0));
+
+			LzPutU32(CompBuff, 4);
+			CompBuff.resize(CompBuff.size() + 4 * sizeof(u32), 0xff);
+
+			Verify(!LzDecompress(Dest, RawSize, CompBuff.data(), CompBuff.size()));
+		}
+	}
+}
+
+void
+TestPipelineCompress(file_data& InputFile)
+{
+	PRINT_TEST_FUNC();
+
+	struct pipeline_test_config
+	{
+		const char* Name;
+		u32 QueueDepth;
+		u32 WorkerCount;
+		b32 UseUring;
+	};
+
+	// NOTE: queue depth 1 is sequential read, compress, write of every block
+	const pipeline_test_config Configs[] =
+	{
+		{"sequential", 1, 1, true},
+		{"overlapped", 8, 0, true},
+		{"overlapped, no io_uring", 8, 0, false},
+	};
+
+	const std::string InPath = (fs::temp_directory_path() / "pipeline_in.bin").string();
+	const std::string OutPath = (fs::temp_directory_path() / "pipeline_out.bin").string();
+	Verify(WriteEntireFile(InPath, InputFile.Data, InputFile.Size));
+
+	Timer Timer;
+
+	for (const pipeline_test_config& Config : Configs)
+	{
+		pipeline_params Params = PipelineDefaultParams();
+		Params.BlockSize = 1 << 20;
+		Params.QueueDepth = Config.QueueDepth;
+		Params.WorkerCount = Config.WorkerCount;
+		Params.UseUring = Config.UseUring;
+
+		pipeline_stats Stats = {};
+		Timer.start();
+		b32 Compressed = PipelineCompressFile(InPath.c_str(), OutPath.c_str(), Params, &Stats);
+		Timer.end();
+		Verify(Compressed);
+
+		printf(" %s: %u blocks, queue depth %u, %s\n", Config.Name, Stats.BlockCount, Config.QueueDepth, Stats.Backend);
+		printf(" compress");
+		PrintSymbolEncPerfStats(Timer.Clock, Timer.Time, InputFile.Size);
+		PrintCompressionSize(InputFile.Size, Stats.OutSize);
+
+		file_data OutFile = ReadEntireFile(OutPath);
+		Assert(OutFile.Size == Stats.OutSize);
+
+		std::vector<u8> DecBuff(InputFile.Size);
+		u64 DecodedSize = PipelineDecompress(DecBuff.data(), DecBuff.size(), OutFile.Data, OutFile.Size);
+		Verify(DecodedSize == InputFile.Size);
+		Assert(!memcmp(DecBuff.data(), InputFile.Data, InputFile.Size));
+		delete[] OutFile.Data;
+	}
+
+	// release with reads still in flight reaps them, so buffers can go right after
+	for (b32 UseUring = 0; UseUring < 2; UseUring++)
+	{
+		static constexpr u32 ReadCount = 8;
+		static constexpr u32 ReadSize = 64 << 10;
+
+		io_file File = OpenIOFile(InPath.c_str(), false);
+		std::vector<ByteVec> Buffers(ReadCount, ByteVec(ReadSize));
+
+		AsyncIO IO;
+		IO.init(ReadCount, 2, UseUring);
+		for (u32 i = 0; i < ReadCount; i++)
+		{
+			async_io_op Op = {};
+			Op.File = File;
+			Op.Buffer = Buffers[i].data();
+			Op.Size = ReadSize;
+			Op.Offset = (static_cast<u64>(i) * ReadSize) % InputFile.Size;
+			Op.Tag = i;
+			IO.submit(Op);
+		}
+
+		Verify(IO.release());
+		Buffers.clear();
+		CloseIOFile(File);
+	}
+
+	fs::remove(InPath);
+	fs::remove(OutPath);
+}
+
+// Directory job: files and blocks of large files are independent LZ tasks on work stealing pool
+static constexpr u64 DIR_BLOCK_SIZE = 4 << 20;
+
+struct dir_task
+{
+	u32 Index; // output slot
+	u32 FileIndex;
+	u64 Start;
+	u64 Size;
+};
+
+struct dir_workspace
+{
+	lz_workspace Lz;
+};
+
+void
+TestDirectoryCompress(std::vector<file_data>& InputArr)
+{
+	PRINT_TEST_FUNC();
+
+	std::vector<dir_task> Tasks;
+	u64 TotalSize = 0;
+	for (u32 FileIndex = 0; FileIndex < InputArr.size(); FileIndex++)
+	{
+		const file_data& File = InputArr[FileIndex];
+		TotalSize += File.Size;
+
+		for (u64 Start = 0; Start < File.Size; Start += DIR_BLOCK_SIZE)
+		{
+			dir_task Task = {};
+			Task.Index = static_cast<u32>(Tasks.size());
+			Task.FileIndex = FileIndex;
+			Task.Start = Start;
+			Task.Size = (File.Size - Start) < DIR_BLOCK_SIZE ? (File.Size - Start) : DIR_BLOCK_SIZE;
+			Tasks.push_back(Task);
+		}
+	}
+
+	// NOTE: largest first, so small tasks are left for balancing at the end
+	std::vector<dir_task> Sorted = Tasks;
+	std::sort(Sorted.begin(), Sorted.end(), [](const dir_task& A, const dir_task& B) { return A.Size > B.Size; });
+
+	std::vector<ByteVec> BlockOut(Tasks.size());
+	lz_params Params = LzDefaultParams();
+
+	u32 MaxThreadCount = std::thread::hardware_concurrency();
+	MaxThreadCount = MaxThreadCount ? MaxThreadCount : 1;
+
+	printf(" %lu files, %lu tasks, %lu bytes\n", InputArr.size(), Tasks.size(), TotalSize);
+
+	for (u32 ThreadCount : {1u, MaxThreadCount})
+	{
+		task_pool_params PoolParams = TaskPoolDefaultParams();
+		PoolParams.ThreadCount = ThreadCount;
+
+		WorkStealingPool<dir_task> Pool;
+		Pool.init(PoolParams);
+
+		for (u64 i = 0; i < Sorted.size(); i++)
+		{
+			Pool.push(i % Pool.threadCount(), Sorted[i]);
+		}
+
+		Timer Timer;
+		Timer.start();
+		Pool.run<dir_workspace>([&](dir_workspace& Workspace, dir_task& Task, u32)
+		{
+			const u8* Data = InputArr[Task.FileIndex].Data + Task.Start;
+			LzCompress(Workspace.Lz, Data, Task.Size, BlockOut[Task.Index], Params);
+		});
+		Timer.end();
+
+		u64 CompressedSize = 0;
+		for (const ByteVec& Block : BlockOut) CompressedSize += Block.size();
+
+		u64 Stolen = 0;
+		for (u32 Worker = 0; Worker < Pool.threadCount(); Worker++) Stolen += Pool.stats(Worker).Stolen;
+
+		printf(" %u threads, %u nodes, %lu steals\n", Pool.threadCount(), Pool.nodeCount(), Stolen);
+		printf(" compress");
+		PrintSymbolEncPerfStats(Timer.Clock, Timer.Time, TotalSize);
+		PrintCompressionSize(TotalSize, CompressedSize);
+	}
+
+	std::vector<u8> DecBuff(DIR_BLOCK_SIZE);
+	for (const dir_task& Task : Tasks)
+	{
+		const ByteVec& Block = BlockOut[Task.Index];
+		u64 DecodedSize = LzDecompress(DecBuff.data(), DecBuff.size(), Block.data(), Block.size());
+
+		Verify(DecodedSize == Task.Size);
+		Assert(!memcmp(DecBuff.data(), InputArr[Task.FileIndex].Data + Task.Start, Task.Size));
+	}
+}
@@ -4,11 +4,15 @@
 #include "common.h"
 #include "mem.cpp"
 #include "suballoc.cpp"
+#include "histo.cpp"
+#include "task_pool.cpp"
+#include "async_io.cpp"
 
 #include "renorm.cpp"
 #include "huff_tests.cpp"
 #include "ac_tests.cpp"
 #include "ans_tests.cpp"
+#include "lz_tests.cpp"
 
 #include <cstdlib>
 #include <ctime>
@@ -28,7 +32,7 @@ main(int argc, char** argv)
 	for (auto& InputFile : InputArr)
 	{
 		size_t ByteCount[256] = {};
-		CountByte(ByteCount, InputFile.Data, InputFile.Size);
+		CountByteParallel(ByteCount, InputFile.Data, InputFile.Size);
 		f64 FileByteH = Entropy(ByteCount, 256);
 		printf("---------- %s %lu H:%.3f\n", InputFile.Name.c_str(), InputFile.Size, FileByteH);
 
@@ -37,7 +41,13 @@ main(int argc, char** argv)
 		//TestStaticAC(InputFile);
 		//TestACBasicModel(InputFile);
 		//TestPPMModel(InputFile);
+		TestPPMWorkspace(InputFile);
+		TestPPMParallel(InputFile);
+		TestPPMDictionary(InputFile);
+		TestPPMSnapshot(InputFile);
+		TestPPMHugePages(InputFile);
 	
+		TestByteHistogram(InputFile);
 		TestBasicRans8(InputFile);
 		TestBasicRans32(InputFile);
 		TestFastEncodeRans8(InputFile);
@@ -45,17 +55,40 @@ main(int argc, char** argv)
 		TestTableDecodeRans16(InputFile);
 		TestTableInterleavedRans16(InputFile);
 		TestTableInterleavedRans32(InputFile);
+		TestInterleavedRansSweep(InputFile);
+		TestBwtRans32(InputFile);
 		TestSIMDDecodeRans16(InputFile);
+		TestBatchDecodeRans16(InputFile);
 		TestNormalizationRans32(InputFile);
 		TestPrecomputeAdaptiveOrder1Rans32(InputFile);
+		TestBlockSplitRans32(InputFile);
+		TestSplitDecodeRans32(InputFile);
+		TestAdaptiveRans8(InputFile);
+		TestNibbleSplitRans32(InputFile);
+		TestAliasRans32(InputFile);
+		TestSmallMessagesThreaded(InputFile);
+		TestRansBlockDictionary(InputFile);
+		TestCheckedDecodeRans(InputFile);
+		TestCodecAutoSelect(InputFile);
+		TestSkewedBlocks(InputFile);
 
+		TestBitScanIntrinsics(InputFile);
 		TestBasicTans(InputFile);
 		//TestBasicTans<false>(InputFile);
 		TestInterleavedTans(InputFile);
 		//TestInterleavedTans<false>(InputFile);
+		TestInterleavedTansFast<2>(InputFile);
+		TestInterleavedTansFast<4>(InputFile);
+		TestTansTableBuild(InputFile);
+		TestWideAlphabetAns(InputFile);
+
+		TestLz77(InputFile);
+		TestPipelineCompress(InputFile);
 
 		printf("\n");
 	}
 
+	TestDirectoryCompress(InputArr);
+
 	return 0;
 }
\ No newline at end of file
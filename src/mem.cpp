@@ -228,4 +228,281 @@ struct BitReaderReverseMSB
 		refillTo(Count);
 		return Result;
 	}
-};
\ No newline at end of file
+};
+
+// Same bit order as BitReaderReverseMSB (stream read as big endian number, consumed from the low end),
+// but keeps whole 64 bit window loaded: refill moves window back by consumed bytes with one bounds check,
+// after refill at least 57 bits can be consumed.
+struct BitReaderReverseFast
+{
+	u8* Start;
+	s64 Pos; // index of the last byte in window
+	u64 BitBuff;
+	u32 BitsConsumed;
+
+	BitReaderReverseFast() : Start(nullptr), Pos(0), BitBuff(0), BitsConsumed(0) {}
+	BitReaderReverseFast(u8* BuffStart, size_t Size)
+	{
+		init(BuffStart, Size);
+	}
+
+	inline void init(u8* BuffStart, size_t Size)
+	{
+		Assert(Size);
+		Start = BuffStart;
+		Pos = Size - 1;
+		reload();
+
+		u8 LastByte = Start[Pos];
+		Assert(LastByte);
+		BitsConsumed = FindLeastSignificantSetBit32(LastByte) + 1;
+	}
+
+	inline void reload()
+	{
+		if (Pos >= 7)
+		{
+			u64 Word;
+			memcpy(&Word, Start + Pos - 7, sizeof(Word));
+			BitBuff = ByteSwap64(Word);
+		}
+		else
+		{
+			reloadSlow();
+		}
+	}
+
+	void reloadSlow()
+	{
+		// bytes before the start of buffer are read as zero
+		BitBuff = 0;
+		for (s64 i = 0; i < 8; i++)
+		{
+			s64 Index = Pos - i;
+			if (Index < 0) break;
+
+			BitBuff |= static_cast<u64>(Start[Index]) << (i * 8);
+		}
+	}
+
+	inline void refill()
+	{
+		Pos -= BitsConsumed >> 3;
+		BitsConsumed &= 7;
+		reload();
+	}
+
+	inline u64 peek(u32 Count)
+	{
+		u64 Result = (BitBuff >> BitsConsumed) & ((1ull << Count) - 1);
+		return Result;
+	}
+
+	inline void consume(u32 Count)
+	{
+		BitsConsumed += Count;
+		Assert(BitsConsumed <= 64);
+	}
+
+	inline u64 getBits(u32 Count)
+	{
+		u64 Result = peek(Count);
+		consume(Count);
+		return Result;
+	}
+
+	inline b32 isFinished()
+	{
+		b32 Result = ((Pos + 1) * 8) == BitsConsumed;
+		return Result;
+	}
+};
+
+// Page backed memory for large arenas. Random access over hundreds of MB misses dTLB with 4 KB pages,
+// so explicit huge pages are tried first, then transparent huge pages (Linux), then normal pages.
+enum page_kind
+{
+	PageKind_Normal,
+	PageKind_Transparent, // THP advised, kernel may still back part of range with small pages
+	PageKind_Huge,
+};
+
+struct page_alloc_params
+{
+	b32 HugePages;
+	b32 Prefault; // touch every page now, not on first use inside hot loop
+	s32 NumaNode; // < 0 - no binding
+};
+
+inline page_alloc_params
+PageAllocDefaultParams()
+{
+	page_alloc_params Result = {};
+	Result.HugePages = true;
+	Result.Prefault = true;
+	Result.NumaNode = -1;
+	return Result;
+}
+
+struct page_block
+{
+	u8* Memory;
+	u64 Size; // mapped size, multiple of page size
+	page_kind Kind;
+};
+
+static constexpr u64 HUGE_PAGE_SIZE = 2 << 20;
+static constexpr u64 SMALL_PAGE_SIZE = 4096;
+
+inline const char*
+PageKindName(page_kind Kind)
+{
+	const char* Result = Kind == PageKind_Huge ? "huge" : (Kind == PageKind_Transparent ? "transparent huge" : "normal");
+	return Result;
+}
+
+#if defined(_WIN32)
+
+// NOTE: large pages need SeLockMemoryPrivilege and are committed (prefaulted) by allocation itself
+b32
+PageAlloc(page_block& Result, u64 Size, const page_alloc_params& Params)
+{
+	Result = {};
+
+	DWORD Node = Params.NumaNode < 0 ? NUMA_NO_PREFERRED_NODE : static_cast<DWORD>(Params.NumaNode);
+	u64 LargePageSize = GetLargePageMinimum();
+
+	if (Params.HugePages && LargePageSize)
+	{
+		u64 MapSize = (Size + LargePageSize - 1) / LargePageSize * LargePageSize;
+		void* Memory = VirtualAllocExNuma(GetCurrentProcess(), nullptr, MapSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE, Node);
+		if (Memory)
+		{
+			Result.Memory = static_cast<u8*>(Memory);
+			Result.Size = MapSize;
+			Result.Kind = PageKind_Huge;
+			return true;
+		}
+	}
+
+	u64 MapSize = AlignSizeForward(Size, SMALL_PAGE_SIZE);
+	void* Memory = VirtualAllocExNuma(GetCurrentProcess(), nullptr, MapSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, Node);
+	if (!Memory) return false;
+
+	Result.Memory = static_cast<u8*>(Memory);
+	Result.Size = MapSize;
+	Result.Kind = PageKind_Normal;
+
+	if (Params.Prefault)
+	{
+		for (u64 i = 0; i < MapSize; i += SMALL_PAGE_SIZE)
+		{
+			Result.Memory[i] = 0;
+		}
+	}
+
+	return true;
+}
+
+void
+PageFree(page_block& Block)
+{
+	if (Block.Memory)
+	{
+		VirtualFree(Block.Memory, 0, MEM_RELEASE);
+	}
+
+	Block = {};
+}
+
+#else
+
+b32
+PageAlloc(page_block& Result, u64 Size, const page_alloc_params& Params)
+{
+	Result = {};
+
+	const int Prot = PROT_READ | PROT_WRITE;
+	const int Flags = MAP_PRIVATE | MAP_ANONYMOUS;
+	u64 MapSize = AlignSizeForward(Size, HUGE_PAGE_SIZE);
+
+#if defined(MAP_HUGETLB)
+	// NOTE: needs reserved pool (vm.nr_hugepages), fails fast if it's too small
+	if (Params.HugePages)
+	{
+		void* Memory = mmap(nullptr, MapSize, Prot, Flags | MAP_HUGETLB, -1, 0);
+		if (Memory != MAP_FAILED)
+		{
+			Result.Memory = static_cast<u8*>(Memory);
+			Result.Kind = PageKind_Huge;
+		}
+	}
+#endif
+
+	if (!Result.Memory)
+	{
+		// over map by one huge page and trim, so range is huge page aligned for THP
+		void* Mapped = mmap(nullptr, MapSize + HUGE_PAGE_SIZE, Prot, Flags, -1, 0);
+		if (Mapped == MAP_FAILED) return false;
+
+		u8* Base = static_cast<u8*>(Mapped);
+		u8* Memory = reinterpret_cast<u8*>(AlignSizeForward(reinterpret_cast<size_t>(Base), HUGE_PAGE_SIZE));
+		u64 Head = Memory - Base;
+		u64 Tail = HUGE_PAGE_SIZE - Head;
+
+		if (Head) munmap(Base, Head);
+		if (Tail) munmap(Memory + MapSize, Tail);
+
+		Result.Memory = Memory;
+		Result.Kind = PageKind_Normal;
+
+#if defined(MADV_HUGEPAGE)
+		if (Params.HugePages && !madvise(Memory, MapSize, MADV_HUGEPAGE))
+		{
+			Result.Kind = PageKind_Transparent;
+		}
+#endif
+	}
+
+	Result.Size = MapSize;
+
+#if defined(__linux__)
+	// preferred (not strict) policy, so allocation still succeeds when node is full
+	if (Params.NumaNode >= 0)
+	{
+		const int MpolPreferred = 1;
+		u64 NodeMask[4] = {};
+		u32 Node = static_cast<u32>(Params.NumaNode);
+		if (Node < 256)
+		{
+			NodeMask[Node / 64] = 1ull << (Node % 64);
+			syscall(SYS_mbind, Result.Memory, Result.Size, MpolPreferred, NodeMask, 257, 0);
+		}
+	}
+#endif
+
+	// NOTE: must come after binding, first touch decides where page lives
+	if (Params.Prefault)
+	{
+		u64 Step = Result.Kind == PageKind_Huge ? HUGE_PAGE_SIZE : SMALL_PAGE_SIZE;
+		for (u64 i = 0; i < Result.Size; i += Step)
+		{
+			Result.Memory[i] = 0;
+		}
+	}
+
+	return true;
+}
+
+void
+PageFree(page_block& Block)
+{
+	if (Block.Memory)
+	{
+		munmap(Block.Memory, Block.Size);
+	}
+
+	Block = {};
+}
+
+#endif
@@ -13,37 +13,61 @@ Normalize(u32* Freq, u32* CumFreq, u16* NormFreq, u16* NormCumFreq, u32 SymCount
 		NormCumFreq[i] = ((u64)TargetTotal * CumFreq[i]) / CurrTotal;
 	}
 
+	// NOTE: every present symbol rounded to zero steals one from narrowest symbol wider than 1 (lowest index on ties).
+	// Victim stays narrowest until it's down to 1 and other widths don't change, so victims go in initial
+	// (width, index) order. Widths are bucketed once, capped at ZeroCount + 1: any wider symbol alone covers all steals.
+	u32 ZeroCount = 0;
 	for (u32 i = 0; i < SymCount; i++)
 	{
-		if (Freq[i] && (NormCumFreq[i] == NormCumFreq[i + 1]))
+		NormFreq[i] = NormCumFreq[i + 1] - NormCumFreq[i];
+		ZeroCount += Freq[i] && !NormFreq[i];
+	}
+
+	if (ZeroCount)
+	{
+		u32 Cap = ZeroCount + 1;
+		std::vector<s32> Head(Cap + 1, -1);
+		std::vector<s32> Next(SymCount);
+
+		for (u32 i = SymCount; i > 0; i--)
 		{
-			u32 BestFreq = ~0u;
-			s32 BestStealIndex = -1;
-			for (u32 j = 0; j < SymCount; j++)
-			{
-				u32 CheckFreq = NormCumFreq[j + 1] - NormCumFreq[j];
-				if ((CheckFreq > 1) && (CheckFreq < BestFreq))
-				{
-					BestFreq = CheckFreq;
-					BestStealIndex = j;
-				}
-			}
+			u32 Width = NormFreq[i - 1];
+			if (Width < 2) continue;
 
-			Assert(BestStealIndex != -1);
-			if (BestStealIndex < i)
-			{
-				for (u32 j = BestStealIndex + 1; j <= i; j++)
-				{
-					NormCumFreq[j]--;
-				}
-			}
-			else
+			u32 Bucket = Width < Cap ? Width : Cap;
+			Next[i - 1] = Head[Bucket];
+			Head[Bucket] = i - 1;
+		}
+
+		// capped bucket is in index order, only its narrowest symbol can be needed
+		s32 Widest = -1;
+		for (s32 j = Head[Cap]; j != -1; j = Next[j])
+		{
+			if ((Widest == -1) || (NormFreq[j] < NormFreq[Widest])) Widest = j;
+		}
+		Head[Cap] = Widest;
+		if (Widest != -1) Next[Widest] = -1;
+
+		u32 Bucket = 2;
+		s32 Victim = -1;
+		for (u32 i = 0; i < SymCount; i++)
+		{
+			if (!Freq[i] || NormFreq[i]) continue;
+
+			while ((Victim == -1) || (NormFreq[Victim] == 1))
 			{
-				for (u32 j = i + 1; j <= BestStealIndex; j++)
-				{
-					NormCumFreq[j]++;
-				}
+				Victim = (Victim != -1) ? Next[Victim] : -1;
+				while ((Victim == -1) && (Bucket <= Cap)) Victim = Head[Bucket++];
+				Assert(Victim != -1);
 			}
+
+			NormFreq[Victim]--;
+			NormFreq[i] = 1;
+		}
+
+		for (u32 i = 0; i < SymCount; i++)
+		{
+			NormCumFreq[i + 1] = NormCumFreq[i] + NormFreq[i];
 		}
 	}
 
@@ -191,4 +215,159 @@ OptimalNormalize(u32* FromFreq, u16* NormFreq, u32 FromTotalSum, u32 SymCount, u
 			}
 		}
 	}
-}
\ No newline at end of file
+}
+
+// Fixed point log2 with 32 fractional bits: table of log2(1 + i/1024) with linear interpolation
+static constexpr u32 NORM_LOG2_TABLE_BITS = 10;
+static constexpr u32 NORM_LOG2_FRAC_BITS = 32;
+static constexpr u32 NORM_COST_SHIFT = 8; // keeps Freq * dLog2 inside 64 bit
+static constexpr u32 NORM_MAX_SYM_COUNT = 4096;
+static constexpr u32 NORM_COST_BUCKET_COUNT = 64 * 4;
+
+struct norm_log2_table
+{
+	u64 Frac[(1 << NORM_LOG2_TABLE_BITS) + 1];
+
+	norm_log2_table()
+	{
+		const u32 Count = 1 << NORM_LOG2_TABLE_BITS;
+		for (u32 i = 0; i <= Count; i++)
+		{
+			f64 Val = std::log2(1.0 + (f64)i / (f64)Count);
+			Frac[i] = static_cast<u64>(Val * (f64)(1ull << NORM_LOG2_FRAC_BITS) + 0.5);
+		}
+	}
+};
+
+static const norm_log2_table NormLog2Table;
+
+inline u64
+Log2Fix(u32 Val)
+{
+	Assert(Val);
+
+	u32 Msb = FindMostSignificantSetBit32(Val);
+
+	// mantissa with 31 bits below the leading one
+	u32 Mantissa = (Val << (31 - Msb)) & 0x7fffffff;
+	u32 Index = Mantissa >> (31 - NORM_LOG2_TABLE_BITS);
+	u64 Rem = Mantissa & ((1 << (31 - NORM_LOG2_TABLE_BITS)) - 1);
+
+	u64 Lo = NormLog2Table.Frac[Index];
+	u64 Hi = NormLog2Table.Frac[Index + 1];
+	u64 Interp = ((Hi - Lo) * Rem) >> (31 - NORM_LOG2_TABLE_BITS);
+
+	u64 Result = ((u64)Msb << NORM_LOG2_FRAC_BITS) + Lo + Interp;
+	return Result;
+}
+
+// change of coded size (fixed point, bigger is better) for moving Freq by Sign
+inline s64
+NormStepCost(u32 FromFreq, u32 Freq, s32 Sign)
+{
+	u64 Log2Curr = Log2Fix(Freq);
+	u64 Log2Next = Log2Fix(Freq + Sign);
+
+	s64 DeltaLog2 = (Sign > 0) ? (s64)((Log2Next - Log2Curr) >> NORM_COST_SHIFT) : -(s64)((Log2Curr - Log2Next) >> NORM_COST_SHIFT);
+	s64 Result = DeltaLog2 * (s64)FromFreq;
+	return Result;
+}
+
+// bucket of step cost magnitude, 4 per octave, ordered as magnitude
+inline u32
+NormCostBucket(s64 Cost)
+{
+	u64 Mag = (Cost < 0) ? (0 - static_cast<u64>(Cost)) : static_cast<u64>(Cost);
+	if (Mag < 4) return static_cast<u32>(Mag);
+
+	u32 Msb = FindMostSignificantSetBit64(Mag);
+	u32 Result = (Msb << 2) | static_cast<u32>((Mag >> (Msb - 2)) & 3);
+	return Result;
+}
+
+// Allocation free version of OptimalNormalize: same rounding, cost is computed in fixed point from
+// a log2 table. Greedy correction is linear: symbols are kept in step cost buckets (fixed size stack
+// arrays) walked once from best bucket. Step cost only gets worse for symbol that moved (gain of +1
+// falls, loss of -1 grows), so it's rebucketed at or after current bucket and walk never goes back.
+// Within bucket symbols take turns. OptimalNormalize stays as the reference.
+void
+OptimalNormalizeFast(const u32* FromFreq, u16* NormFreq, u32 FromTotalSum, u32 SymCount, u32 TargetTotal)
+{
+	Assert(IsPowerOf2(TargetTotal));
+	Assert(FromTotalSum > 0);
+	Assert(SymCount <= NORM_MAX_SYM_COUNT);
+
+	f64 Scale = (f64)TargetTotal / (f64)FromTotalSum;
+	u32 NormSum = 0;
+
+	for (u32 i = 0; i < SymCount; i++)
+	{
+		u32 Result = 0;
+		if (FromFreq[i])
+		{
+			f64 FreqScaled = FromFreq[i] * Scale;
+			u32 Down = (u32)FreqScaled;
+
+			Result = (FreqScaled * FreqScaled < (f64)Down * (f64)(Down + 1)) ? Down : Down + 1;
+			Assert(Result > 0);
+		}
+
+		NormFreq[i] = Result;
+		NormSum += Result;
+	}
+
+	s32 CorrectionCount = TargetTotal - NormSum;
+	if (CorrectionCount == 0) return;
+
+	s32 CorrectionSign = (CorrectionCount > 0) ? 1 : -1;
+
+	// NOTE: bucket walk goes down for gains (+1), up for losses (-1)
+	static constexpr u16 NoSym = 0xffff;
+	u16 Head[NORM_COST_BUCKET_COUNT];
+	u16 Tail[NORM_COST_BUCKET_COUNT];
+	u16 Next[NORM_MAX_SYM_COUNT];
+	MemSet<u16>(Head, NORM_COST_BUCKET_COUNT, NoSym);
+
+	auto Push = [&](u32 Bucket, u32 Sym)
+	{
+		Next[Sym] = NoSym;
+		if (Head[Bucket] == NoSym) Head[Bucket] = static_cast<u16>(Sym);
+		else Next[Tail[Bucket]] = static_cast<u16>(Sym);
+		Tail[Bucket] = static_cast<u16>(Sym);
+	};
+
+	// walk starts at best filled bucket
+	u32 Bucket = (CorrectionSign > 0) ? 0 : (NORM_COST_BUCKET_COUNT - 1);
+	for (u32 i = 0; i < SymCount; i++)
+	{
+		if ((FromFreq[i] == 0) || ((NormFreq[i] == 1) && (CorrectionSign < 0))) continue;
+
+		u32 SymBucket = NormCostBucket(NormStepCost(FromFreq[i], NormFreq[i], CorrectionSign));
+		Bucket = (CorrectionSign > 0) ? (SymBucket > Bucket ? SymBucket : Bucket) : (SymBucket < Bucket ? SymBucket : Bucket);
+		Push(SymBucket, i);
+	}
+
+	while (CorrectionCount != 0)
+	{
+		while (Head[Bucket] == NoSym)
+		{
+			Assert((CorrectionSign > 0) ? (Bucket > 0) : (Bucket < (NORM_COST_BUCKET_COUNT - 1)));
+			if (CorrectionSign > 0) Bucket--;
+			else Bucket++;
+		}
+
+		u32 i = Head[Bucket];
+		Head[Bucket] = Next[i];
+
+		NormFreq[i] += CorrectionSign;
+		CorrectionCount -= CorrectionSign;
+
+		if ((NormFreq[i] > 1) || (CorrectionSign > 0))
+		{
+			// NOTE: fixed point rounding could put symbol before walk position, it's clamped to current bucket
+			u32 NewBucket = NormCostBucket(NormStepCost(FromFreq[i], NormFreq[i], CorrectionSign));
+			NewBucket = (CorrectionSign > 0) ? (NewBucket < Bucket ? NewBucket : Bucket) : (NewBucket > Bucket ? NewBucket : Bucket);
+			Push(NewBucket, i);
+		}
+	}
+}
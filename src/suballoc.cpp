@@ -13,18 +13,71 @@ static constexpr u32 DebugBlockMaxSize = 1 << 13;
 static u32 DebugBlocksCount[DebugBlockMaxSize];
 #endif
 
-struct mem_block
+// NOTE: block headers are written over memory that held user data of any type (split, merge, realloc),
+// without MAY_ALIAS GCC -O2 reorders header and user data accesses
+struct MAY_ALIAS mem_block
 {
 	u64 Size : 31, PrevSize : 30, IsFree : 1;
 };
 
-struct free_mem_block
+struct MAY_ALIAS free_mem_block
 {
 	mem_block Mem;
 	free_mem_block* Next;
 	free_mem_block* Prev;
 };
 
+static_assert(sizeof(mem_block) == sizeof(u64), "mem_block layout must match on all compilers");
+
+// NOTE: arena keeps absolute pointers, so moved arena must rebase every pointer field: p - From + To.
+// Image form (for serialization) stores offset + SUB_ALLOC_IMAGE_BASE, null stays 0.
+static constexpr size_t SUB_ALLOC_IMAGE_BASE = 1;
+
+template<typename T> inline T*
+RebasePtr(T* Ptr, size_t From, size_t To)
+{
+	T* Result = nullptr;
+	if (Ptr)
+	{
+		Result = reinterpret_cast<T*>(reinterpret_cast<size_t>(Ptr) - From + To);
+	}
+
+	return Result;
+}
+
+// Image pointers come from untrusted input: Size bytes at Ptr must lie in ImageSize prefix of arena, aligned
+inline b32
+ValidImagePtr(u64 Ptr, u64 Size, u64 ImageSize, u32 Alignment)
+{
+	if (Ptr < SUB_ALLOC_IMAGE_BASE) return false;
+
+	u64 Offset = Ptr - SUB_ALLOC_IMAGE_BASE;
+	b32 Result = (Offset <= ImageSize) && (Size <= (ImageSize - Offset)) && !(Offset & (Alignment - 1));
+	return Result;
+}
+
+struct sub_alloc_image_header
+{
+	u64 TotalSize;
+	u64 UsedSize;
+	u64 SentinelNext;
+	u64 SentinelPrev;
+};
+
+// In place checkpoint of allocator: arena stays at same address, so saved prefix and free list
+// are restored as is, without rebasing
+struct sub_alloc_checkpoint
+{
+	ByteVec Memory;
+	const u8* Base;
+	free_mem_block FreeSentinel;
+	u64 HighWater;
+#if DEBUG_SUB_ALLOC
+	u32 FreeMem;
+	u32 FreeListCount;
+#endif
+};
+
 template<u32 ReqMinAlloc>
 class StaticSubAlloc
 {
@@ -32,6 +85,8 @@ class StaticSubAlloc
 	static constexpr u32 MemBlockSize = AlignSizeForward(sizeof(mem_block));
 	static constexpr u32 FreeMemBlockSize = AlignSizeForward(sizeof(free_mem_block));
 	static constexpr u32 MaxBlockFreeSize = std::numeric_limits<u32>::max() >> 2;
+	static constexpr u32 MinUse = AlignSizeForward(MinAlloc + MemBlockSize) < FreeMemBlockSize ?
+		FreeMemBlockSize : AlignSizeForward(MinAlloc + MemBlockSize);
 
 	u8* Memory;
 	union
@@ -41,8 +96,11 @@ class StaticSubAlloc
 	} EndOf;
 	free_mem_block FreeSentinel;
 	u64 TotalSize;
+	u64 HighWater; // end of highest block ever allocated since reset
 	//u32 MinAlloc;
-	u32 MinUse;
+	b32 OwnsMemory;
+	page_block Pages; // owned memory is page backed if Pages.Memory is set
+	page_alloc_params PageParams;
 
 public:
 #if DEBUG_SUB_ALLOC
@@ -50,40 +108,227 @@ public:
 	u32 FreeListCount;
 #endif
 
-	StaticSubAlloc() {};
-	StaticSubAlloc(u64 SizeToReserve) : Memory(nullptr)
+	StaticSubAlloc() : Memory(nullptr), TotalSize(0), HighWater(0), OwnsMemory(false), Pages{}, PageParams{} {};
+	StaticSubAlloc(u64 SizeToReserve) : Memory(nullptr), OwnsMemory(false), Pages{}, PageParams{}
 	{
 		init(SizeToReserve);
 	}
 
+	StaticSubAlloc(u64 SizeToReserve, const page_alloc_params& Params) : Memory(nullptr), OwnsMemory(false), Pages{}, PageParams{}
+	{
+		init(SizeToReserve, Params);
+	}
+
+	// NOTE: caller keeps ownership of ExternalMemory, it must outlive allocator
+	StaticSubAlloc(u8* ExternalMemory, u64 Size) : Memory(nullptr), OwnsMemory(false), Pages{}, PageParams{}
+	{
+		init(ExternalMemory, Size);
+	}
+
 	~StaticSubAlloc()
 	{
-		delete[] Memory;
-		Memory = nullptr;
+		release();
 	}
 
 	void init(u64 SizeToReserve)
 	{
-		//MinAlloc = AlignSizeForward(MinAlloc, 2);
-		MinUse = AlignSizeForward(MinAlloc + MemBlockSize);
+		release();
+		SizeToReserve = clampSize(SizeToReserve);
 
-		if (MinUse < FreeMemBlockSize)
-		{
-			MinUse = FreeMemBlockSize;
-		}
+		TotalSize = SizeToReserve;
+		Memory = new u8[TotalSize];
+		OwnsMemory = true;
+		EndOf.MemBlock = reinterpret_cast<mem_block*>(Memory + TotalSize);
+
+		reset();
+	}
 
-		if (SizeToReserve < MinUse)
+	// Arena on page backend (huge pages if available), falls back to heap if mapping fails
+	void init(u64 SizeToReserve, const page_alloc_params& Params)
+	{
+		release();
+		SizeToReserve = clampSize(SizeToReserve);
+
+		if (!PageAlloc(Pages, SizeToReserve, Params))
 		{
-			SizeToReserve = MinUse;
+			init(SizeToReserve);
+			return;
 		}
-		
+
 		TotalSize = SizeToReserve;
-		Memory = new u8[TotalSize];
+		Memory = Pages.Memory;
+		OwnsMemory = true;
+		PageParams = Params;
 		EndOf.MemBlock = reinterpret_cast<mem_block*>(Memory + TotalSize);
 
 		reset();
 	}
 
+	// page kind of owned page backed arena, normal for heap or external memory
+	page_kind pageKind() const
+	{
+		page_kind Result = Pages.Memory ? Pages.Kind : PageKind_Normal;
+		return Result;
+	}
+
+	void init(u8* ExternalMemory, u64 Size)
+	{
+		Assert(ExternalMemory);
+		Assert(Size == clampSize(Size));
+		Assert((reinterpret_cast<size_t>(ExternalMemory) & (PtrAlign - 1)) == 0);
+
+		release();
+
+		TotalSize = Size;
+		Memory = ExternalMemory;
+		OwnsMemory = false;
+		EndOf.MemBlock = reinterpret_cast<mem_block*>(Memory + TotalSize);
+
+		reset();
+	}
+
+	u8* getMemory() const
+	{
+		return Memory;
+	}
+
+	// after loadImage it's size of loaded arena prefix
+	u64 highWater() const
+	{
+		return HighWater;
+	}
+
+	// prefix of arena that holds all used blocks and header of trailing free block
+	u64 usedSize() const
+	{
+		u64 Result = HighWater + FreeMemBlockSize;
+		Result = Result < TotalSize ? Result : TotalSize;
+		return Result;
+	}
+
+	// Copies only used prefix of Src (untouched tail is never written) and rebases free list.
+	// Src is only read, so many allocators can clone one source concurrently.
+	void copyFrom(const StaticSubAlloc& Src)
+	{
+		Assert(Memory && (TotalSize == Src.TotalSize));
+
+		memcpy(Memory, Src.Memory, Src.usedSize());
+		HighWater = Src.HighWater;
+
+		size_t From = reinterpret_cast<size_t>(Src.Memory);
+		size_t To = reinterpret_cast<size_t>(Memory);
+		free_mem_block* FromSentinel = const_cast<free_mem_block*>(&Src.FreeSentinel);
+
+		FreeSentinel = {};
+		rebaseFreeList(Memory, From, To, FromSentinel, &FreeSentinel, Src.FreeSentinel.Next);
+		FreeSentinel.Next = rebaseFreeLink(Src.FreeSentinel.Next, From, To, FromSentinel, &FreeSentinel);
+		FreeSentinel.Prev = rebaseFreeLink(Src.FreeSentinel.Prev, From, To, FromSentinel, &FreeSentinel);
+
+#if DEBUG_SUB_ALLOC
+		FreeMem = Src.FreeMem;
+		FreeListCount = Src.FreeListCount;
+#endif
+	}
+
+	void checkpoint(sub_alloc_checkpoint& Out) const
+	{
+		u64 Used = usedSize();
+		Out.Memory.resize(Used);
+		memcpy(Out.Memory.data(), Memory, Used);
+
+		Out.Base = Memory;
+		Out.FreeSentinel = FreeSentinel;
+		Out.HighWater = HighWater;
+#if DEBUG_SUB_ALLOC
+		Out.FreeMem = FreeMem;
+		Out.FreeListCount = FreeListCount;
+#endif
+	}
+
+	// Checkpoint must be taken from this allocator. Blocks allocated after it are past its used prefix
+	// and become part of trailing free block again, so only prefix is copied back.
+	void restore(const sub_alloc_checkpoint& In)
+	{
+		Assert(In.Base == Memory);
+
+		memcpy(Memory, In.Memory.data(), In.Memory.size());
+		FreeSentinel = In.FreeSentinel;
+		HighWater = In.HighWater;
+#if DEBUG_SUB_ALLOC
+		FreeMem = In.FreeMem;
+		FreeListCount = In.FreeListCount;
+#endif
+	}
+
+	u64 imageSize() const
+	{
+		u64 Result = sizeof(sub_alloc_image_header) + usedSize();
+		return Result;
+	}
+
+	void saveImage(u8* Out) const
+	{
+		sub_alloc_image_header Header = {};
+		Header.TotalSize = TotalSize;
+		Header.UsedSize = usedSize();
+
+		size_t From = reinterpret_cast<size_t>(Memory);
+		free_mem_block* FromSentinel = const_cast<free_mem_block*>(&FreeSentinel);
+
+		Header.SentinelNext = reinterpret_cast<size_t>(rebaseFreeLink(FreeSentinel.Next, From, SUB_ALLOC_IMAGE_BASE, FromSentinel, nullptr));
+		Header.SentinelPrev = reinterpret_cast<size_t>(rebaseFreeLink(FreeSentinel.Prev, From, SUB_ALLOC_IMAGE_BASE, FromSentinel, nullptr));
+
+		memcpy(Out, &Header, sizeof(Header));
+		Out += sizeof(Header);
+
+		memcpy(Out, Memory, Header.UsedSize);
+		rebaseFreeList(Out, From, SUB_ALLOC_IMAGE_BASE, FromSentinel, nullptr, FreeSentinel.Next);
+	}
+
+	// Owned (or not yet allocated) memory is resized to image's arena size, external memory must match it
+	b32 loadImage(const u8* In, u64 InSize)
+	{
+		sub_alloc_image_header Header;
+		if (InSize < sizeof(Header)) return false;
+
+		memcpy(&Header, In, sizeof(Header));
+		In += sizeof(Header);
+
+		if ((Header.UsedSize > Header.TotalSize) || ((InSize - sizeof(Header)) < Header.UsedSize)) return false;
+		if (Header.TotalSize < FreeMemBlockSize) return false;
+
+		if (!Memory || (OwnsMemory && (TotalSize != Header.TotalSize)))
+		{
+			if (Pages.Memory) init(Header.TotalSize, PageParams);
+			else init(Header.TotalSize);
+		}
+
+		if (TotalSize != Header.TotalSize) return false;
+
+		memcpy(Memory, In, Header.UsedSize);
+		HighWater = Header.UsedSize;
+
+		if (!validImageFreeList(Header))
+		{
+			reset();
+			return false;
+		}
+
+		size_t To = reinterpret_cast<size_t>(Memory);
+		free_mem_block* First = reinterpret_cast<free_mem_block*>(Header.SentinelNext);
+
+		FreeSentinel = {};
+		rebaseFreeList(Memory, SUB_ALLOC_IMAGE_BASE, To, nullptr, &FreeSentinel, First);
+		FreeSentinel.Next = rebaseFreeLink(First, SUB_ALLOC_IMAGE_BASE, To, nullptr, &FreeSentinel);
+		FreeSentinel.Prev = rebaseFreeLink(reinterpret_cast<free_mem_block*>(Header.SentinelPrev), SUB_ALLOC_IMAGE_BASE, To, nullptr, &FreeSentinel);
+
+#if DEBUG_SUB_ALLOC
+		FreeMem = 0;
+		FreeListCount = 0;
+#endif
+		return true;
+	}
+
 	void reset()
 	{
 		if (Memory)
@@ -96,6 +341,9 @@ public:
 			FreeSentinel.Next = &FreeSentinel;
 			FreeSentinel.Prev = &FreeSentinel;
 
+			// NOTE: huge arena is split in several free blocks, used prefix isn't tracked for it
+			HighWater = TotalSize > MaxBlockFreeSize ? TotalSize : 0;
+
 			free_mem_block* FreeBlock = reinterpret_cast<free_mem_block*>(Memory);
 
 			if (TotalSize > MaxBlockFreeSize)
@@ -179,6 +427,9 @@ public:
 
 				Result = reinterpret_cast<u8*>(FreeBlock) + MemBlockSize;
 
+				u64 BlockEnd = (Result - Memory) + FreeBlock->Mem.Size;
+				HighWater = BlockEnd > HighWater ? BlockEnd : HighWater;
+
 				Assert(FreeBlock->Mem.Size);				
 				removeBlock(FreeBlock);
 
@@ -324,6 +575,74 @@ public:
 	}
 
 private:
+	static u64 clampSize(u64 Size)
+	{
+		u64 Result = Size < MinUse ? MinUse : Size;
+		return Result;
+	}
+
+	static free_mem_block* rebaseFreeLink(free_mem_block* Ptr, size_t From, size_t To, free_mem_block* FromSentinel, free_mem_block* ToSentinel)
+	{
+		free_mem_block* Result = (Ptr == FromSentinel) ? ToSentinel : RebasePtr(Ptr, From, To);
+		return Result;
+	}
+
+	// Free list of loaded image, still in image form: 0 links to sentinel. Every node must be a free block header
+	// in loaded prefix with block inside arena, walk must reach sentinel within node count that fits prefix.
+	b32 validImageFreeList(const sub_alloc_image_header& Header) const
+	{
+		auto ValidLink = [&Header](u64 Link)
+		{
+			b32 Result = !Link || ValidImagePtr(Link, FreeMemBlockSize, Header.UsedSize, alignof(free_mem_block));
+			return Result;
+		};
+
+		if (!ValidLink(Header.SentinelPrev)) return false;
+
+		u64 MaxNodeCount = Header.UsedSize / FreeMemBlockSize;
+		u64 Link = Header.SentinelNext;
+
+		for (u64 NodeCount = 0; Link; NodeCount++)
+		{
+			if ((NodeCount == MaxNodeCount) || !ValidLink(Link)) return false;
+
+			u64 Offset = Link - SUB_ALLOC_IMAGE_BASE;
+			free_mem_block* Node = reinterpret_cast<free_mem_block*>(Memory + Offset);
+			if (!Node->Mem.IsFree || (Node->Mem.Size > (TotalSize - Offset - MemBlockSize))) return false;
+			if (!ValidLink(reinterpret_cast<size_t>(Node->Prev))) return false;
+
+			Link = reinterpret_cast<size_t>(Node->Next);
+		}
+
+		return true;
+	}
+
+	// Dest holds arena content with links in From base, walks list from First and rewrites links to To base
+	static void rebaseFreeList(u8* Dest, size_t From, size_t To, free_mem_block* FromSentinel, free_mem_block* ToSentinel, free_mem_block* First)
+	{
+		for (free_mem_block* Node = First; Node != FromSentinel;)
+		{
+			free_mem_block* At = reinterpret_cast<free_mem_block*>(Dest + (reinterpret_cast<size_t>(Node) - From));
+			free_mem_block* Next = At->Next;
+
+			At->Next = rebaseFreeLink(Next, From, To, FromSentinel, ToSentinel);
+			At->Prev = rebaseFreeLink(At->Prev, From, To, FromSentinel, ToSentinel);
+			Node = Next;
+		}
+	}
+
+	void release()
+	{
+		if (OwnsMemory)
+		{
+			if (Pages.Memory) PageFree(Pages);
+			else delete[] Memory;
+		}
+
+		Memory = nullptr;
+		OwnsMemory = false;
+	}
+
 	//NOTE: for non power of 2 align
 	inline u32 alignSizeWithMinAllocForward(u32 Size)
 	{
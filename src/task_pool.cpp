@@ -0,0 +1,304 @@
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <sched.h>
+#include <fstream>
+#endif
+
+// NUMA topology for worker pinning: one cpu set per node. Machine without NUMA info is one node.
+struct numa_node
+{
+#if defined(_WIN32)
+	GROUP_AFFINITY Affinity;
+#else
+	std::vector<u32> Cpus;
+#endif
+};
+
+#if defined(_WIN32)
+
+void
+GetNumaNodes(std::vector<numa_node>& Nodes)
+{
+	Nodes.clear();
+
+	ULONG HighestNode = 0;
+	if (GetNumaHighestNodeNumber(&HighestNode))
+	{
+		for (USHORT i = 0; i <= HighestNode; i++)
+		{
+			numa_node Node = {};
+			if (GetNumaNodeProcessorMaskEx(i, &Node.Affinity) && Node.Affinity.Mask)
+			{
+				Nodes.push_back(Node);
+			}
+		}
+	}
+
+	if (Nodes.empty())
+	{
+		numa_node Node = {};
+		GetThreadGroupAffinity(GetCurrentThread(), &Node.Affinity);
+		Nodes.push_back(Node);
+	}
+}
+
+b32
+PinThreadToNode(const numa_node& Node)
+{
+	b32 Result = SetThreadGroupAffinity(GetCurrentThread(), &Node.Affinity, nullptr) != 0;
+	return Result;
+}
+
+#else
+
+// parses sysfs cpu list like "0-3,8-11"
+inline void
+ParseCpuList(std::vector<u32>& Cpus, const std::string& List)
+{
+	size_t Pos = 0;
+	while (Pos < List.size())
+	{
+		size_t End = List.find(',', Pos);
+		End = End == std::string::npos ? List.size() : End;
+
+		std::string Range = List.substr(Pos, End - Pos);
+		size_t Dash = Range.find('-');
+
+		u32 First = static_cast<u32>(strtoul(Range.c_str(), nullptr, 10));
+		u32 Last = Dash == std::string::npos ? First : static_cast<u32>(strtoul(Range.c_str() + Dash + 1, nullptr, 10));
+		for (u32 Cpu = First; Cpu <= Last; Cpu++) Cpus.push_back(Cpu);
+
+		Pos = End + 1;
+	}
+}
+
+void
+GetNumaNodes(std::vector<numa_node>& Nodes)
+{
+	Nodes.clear();
+
+	for (u32 i = 0;; i++)
+	{
+		std::ifstream File("/sys/devices/system/node/node" + std::to_string(i) + "/cpulist");
+		if (!File) break;
+
+		std::string List;
+		std::getline(File, List);
+
+		numa_node Node;
+		ParseCpuList(Node.Cpus, List);
+		if (!Node.Cpus.empty()) Nodes.push_back(Node);
+	}
+
+	if (Nodes.empty())
+	{
+		numa_node Node;
+		u32 CpuCount = std::thread::hardware_concurrency();
+		for (u32 Cpu = 0; Cpu < (CpuCount ? CpuCount : 1); Cpu++) Node.Cpus.push_back(Cpu);
+		Nodes.push_back(Node);
+	}
+}
+
+b32
+PinThreadToNode(const numa_node& Node)
+{
+	cpu_set_t Set;
+	CPU_ZERO(&Set);
+	for (u32 Cpu : Node.Cpus)
+	{
+		if (Cpu < CPU_SETSIZE) CPU_SET(Cpu, &Set);
+	}
+
+	b32 Result = !sched_setaffinity(0, sizeof(Set), &Set);
+	return Result;
+}
+
+#endif
+
+struct task_pool_params
+{
+	u32 ThreadCount; // 0 - all hardware threads
+	b32 PinNuma;     // workers are spread over nodes round robin and pinned to their node cpus
+};
+
+inline task_pool_params
+TaskPoolDefaultParams()
+{
+	task_pool_params Result = {};
+	Result.PinNuma = true;
+	return Result;
+}
+
+struct task_pool_worker_stats
+{
+	u64 Executed;
+	u64 Stolen;
+};
+
+// Work stealing over fixed task set: every worker owns deque, takes own tasks from front and steals
+// from back of other deques when it runs dry, victims on same NUMA node first. Tasks don't spawn
+// tasks, so worker is done when it can't steal anything.
+// Every worker builds own WorkspaceT on its thread after pinning, so workspace memory is node local.
+template<typename TaskT>
+class WorkStealingPool
+{
+	struct worker_queue
+	{
+		std::mutex Lock;
+		std::deque<TaskT> Tasks;
+		u32 Node;
+	};
+
+	std::vector<worker_queue> Queues;
+	std::vector<numa_node> Nodes;
+	std::vector<task_pool_worker_stats> Stats;
+	b32 PinNuma;
+
+public:
+	void init(const task_pool_params& Params)
+	{
+		u32 ThreadCount = Params.ThreadCount;
+		if (ThreadCount == 0)
+		{
+			ThreadCount = std::thread::hardware_concurrency();
+			ThreadCount = ThreadCount ? ThreadCount : 1;
+		}
+
+		GetNumaNodes(Nodes);
+		PinNuma = Params.PinNuma;
+
+		Queues = std::vector<worker_queue>(ThreadCount);
+		for (u32 i = 0; i < ThreadCount; i++)
+		{
+			Queues[i].Node = i % Nodes.size();
+		}
+
+		Stats.assign(ThreadCount, task_pool_worker_stats{});
+	}
+
+	u32 threadCount() const
+	{
+		u32 Result = static_cast<u32>(Queues.size());
+		return Result;
+	}
+
+	u32 nodeCount() const
+	{
+		u32 Result = static_cast<u32>(Nodes.size());
+		return Result;
+	}
+
+	const task_pool_worker_stats& stats(u32 Worker) const
+	{
+		return Stats[Worker];
+	}
+
+	// NOTE: only before run
+	void push(u32 Worker, const TaskT& Task)
+	{
+		Queues[Worker].Tasks.push_back(Task);
+	}
+
+	// Body(WorkspaceT&, TaskT&, u32 Worker); calling thread is worker 0
+	template<typename WorkspaceT, typename F> void run(F&& Body)
+	{
+		u32 ThreadCount = threadCount();
+		Stats.assign(ThreadCount, task_pool_worker_stats{});
+
+		auto WorkerLoop = [&](u32 Worker, b32 Pin)
+		{
+			if (Pin && (Nodes.size() > 1))
+			{
+				PinThreadToNode(Nodes[Queues[Worker].Node]);
+			}
+
+			std::vector<WorkspaceT> Workspace(1);
+			std::vector<u32> Victims;
+			victimOrder(Worker, Victims);
+
+			TaskT Task;
+			for (;;)
+			{
+				if (popOwn(Worker, Task))
+				{
+					Stats[Worker].Executed++;
+				}
+				else if (steal(Victims, Task))
+				{
+					Stats[Worker].Executed++;
+					Stats[Worker].Stolen++;
+				}
+				else
+				{
+					break;
+				}
+
+				Body(Workspace[0], Task, Worker);
+			}
+		};
+
+		std::vector<std::thread> Workers;
+		Workers.reserve(ThreadCount - 1);
+
+		for (u32 i = 1; i < ThreadCount; i++)
+		{
+			Workers.emplace_back(WorkerLoop, i, PinNuma);
+		}
+
+		// NOTE: calling thread keeps its affinity
+		WorkerLoop(0, false);
+
+		for (auto& Worker : Workers)
+		{
+			Worker.join();
+		}
+	}
+
+private:
+	void victimOrder(u32 Worker, std::vector<u32>& Victims) const
+	{
+		u32 ThreadCount = threadCount();
+		Victims.clear();
+
+		for (u32 Pass = 0; Pass < 2; Pass++)
+		{
+			for (u32 i = 1; i < ThreadCount; i++)
+			{
+				u32 Victim = (Worker + i) % ThreadCount;
+				b32 SameNode = Queues[Victim].Node == Queues[Worker].Node;
+				if (SameNode == (Pass == 0)) Victims.push_back(Victim);
+			}
+		}
+	}
+
+	b32 popOwn(u32 Worker, TaskT& Task)
+	{
+		worker_queue& Queue = Queues[Worker];
+		std::lock_guard<std::mutex> Guard(Queue.Lock);
+		if (Queue.Tasks.empty()) return false;
+
+		Task = Queue.Tasks.front();
+		Queue.Tasks.pop_front();
+		return true;
+	}
+
+	b32 steal(const std::vector<u32>& Victims, TaskT& Task)
+	{
+		for (u32 Victim : Victims)
+		{
+			worker_queue& Queue = Queues[Victim];
+			std::lock_guard<std::mutex> Guard(Queue.Lock);
+			if (Queue.Tasks.empty()) continue;
+
+			Task = Queue.Tasks.back();
+			Queue.Tasks.pop_back();
+			return true;
+		}
+
+		return false;
+	}
+};